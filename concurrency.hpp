@@ -1,26 +1,112 @@
 #ifndef CONCURRENCY_HPP
 #define CONCURRENCY_HPP
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
 #include <future>
+#include <iomanip>
+#include <iterator>
+#include <limits>
 #include <list>
 #include <memory>
-#include <mutex>
+#include <new>
+#include <numeric>
 #include <optional>
-#include <thread>
+#include <ostream>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
+#define TRACE_HPP
+#define POLICY_HPP
+#define BARRIER_HPP
 #define CHANNEL_ITER_HPP
+#define CONTAINER_SHARDED_QUEUE_HPP
 #define CONTAINER_RING_BUFFER_HPP
 #define CONTAINER_THREAD_SAFE_HPP
+#define LOCKFREE_MPSC_QUEUE_HPP
+#define LOCKFREE_SEGMENT_QUEUE_HPP
 #define CHANNEL_HPP
-#define LOCKFREE_LIST_HPP
-#define SELECT_HPP
 #define THREAD_POOL_HPP
+#define ACTOR_HPP
+#define CONTAINER_BOUNDED_QUEUE_HPP
+#define RCU_HPP
+#define CONTAINER_CONCURRENT_MAP_HPP
+#define CONTAINER_MAPPED_QUEUE_HPP
+#define CONTAINER_SHARED_RING_BUFFER_HPP
+#define LOCKFREE_LIST_HPP
+#define MAPPED_CHANNEL_HPP
+#define MUTEX_HPP
+#define OBJECT_POOL_HPP
 #define WAIT_GROUP_HPP
+#define PARALLEL_ALGORITHM_HPP
+#define PARALLEL_WALK_HPP
+#define PIPELINE_HPP
+#define POLICY_CHANNEL_HPP
+#define RATE_LIMITER_HPP
+#define SELECT_HPP
+#define SEMAPHORE_HPP
+#define SHARED_CHANNEL_HPP
+#define SYNCHRONIZED_HPP
+#define TIMER_HPP
+
+#include <chrono>
+#include <cstddef>
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) \
+    || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+#include <cstddef>
+#include <functional>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cerrno>
 #include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace platform {
+    // define CONCURRENCY_TRACE before include to record trace events,
+    // otherwise every trace call is discarded at compile time
+#ifdef CONCURRENCY_TRACE
+    constexpr bool trace = true;
+#else
+    constexpr bool trace = false;
+#endif
+}  // namespace platform
 
 
 namespace platform {
@@ -31,275 +117,5919 @@ namespace platform {
     // constexpr auto prevent_deadlock = 150us;  // for personal mac
     constexpr auto prevent_deadlock = 500us;  // for azure-pipeline mac
 #endif
+
+    // fixed instead of std::hardware_destructive_interference_size,
+    // which may vary with compiler flags and break ABI of headers
+#if defined(__APPLE__) && defined(__aarch64__)
+    constexpr size_t cache_line = 128;
+#else
+    constexpr size_t cache_line = 64;
+#endif
 }  // namespace platform
 
 
-template <typename T, typename Channel>
-class ChannelIterator {
-public:
-    ChannelIterator(Channel& channel, std::optional<T>&& item)
-        : channel(channel), item(std::move(item)) {
-        // Do Nothing
+namespace platform {
+    // hint to cpu that caller is spinning, eases pipeline and sibling thread
+    inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) \
+    || defined(_M_IX86)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
     }
 
-    T& operator*() {
-        return item.value();
+    // Hash of calling thread id, cached and mixed so that low bits could
+    // pick a lane even if ids are aligned addresses.
+    inline size_t thread_hash() {
+        static thread_local size_t hash = [] {
+            constexpr size_t half = sizeof(size_t) * 4;
+
+            size_t given =
+                std::hash<std::thread::id>()(std::this_thread::get_id());
+            given *= static_cast<size_t>(0x9e3779b97f4a7c15ull);
+            return given ^ (given >> half);
+        }();
+        return hash;
     }
+}  // namespace platform
 
-    T const& operator*() const {
-        return item.value();
-    }
 
-    ChannelIterator& operator++() {
-        item = channel.Get();
-        return *this;
-    }
+namespace platform {
+    // Read-write shared mapping of whole file, created and zero-filled
+    // up to given size if not exists.
+    class MappedFile {
+    public:
+        MappedFile(std::string const& path, size_t size)
+            : m_data(nullptr), m_size(size) {
+#if defined(__unix__) || defined(__APPLE__)
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), path);
+            }
 
-    bool operator!=(ChannelIterator const& other) const {
-        return item != other.item;
-    }
+            struct stat st;
+            if (::fstat(fd, &st) < 0
+                || (static_cast<size_t>(st.st_size) < size
+                    && ::ftruncate(fd, size) < 0)) {
+                int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), path);
+            }
 
-private:
-    Channel& channel;
-    std::optional<T> item;
-};
+            void* data = ::mmap(
+                nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            int err = errno;
+            ::close(fd);
 
+            if (data == MAP_FAILED) {
+                throw std::system_error(err, std::generic_category(), path);
+            }
+            m_data = data;
+#else
+            throw std::system_error(
+                std::make_error_code(std::errc::function_not_supported),
+                path);
+#endif
+        }
 
-template <typename T, typename = void>  // for stl compatiblity
-class RingBuffer {
-public:
-    using value_type = T;
+        ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+            if (m_data != nullptr) {
+                ::msync(m_data, m_size, MS_SYNC);
+                ::munmap(m_data, m_size);
+            }
+#endif
+        }
 
-    static_assert(std::is_default_constructible_v<T>,
-                  "RingBuffer base type must be default constructible");
+        MappedFile(MappedFile const&) = delete;
+        MappedFile(MappedFile&&) = delete;
 
-    RingBuffer() : RingBuffer(1) {
-        // Do Nothing
-    }
+        MappedFile& operator=(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile&&) = delete;
 
-    RingBuffer(size_t size_buffer)
-        : size_buffer(size_buffer), buffer(std::make_unique<T[]>(size_buffer)) {
-        // Do Nothing
-    }
+        void* data() const {
+            return m_data;
+        }
 
-    RingBuffer(RingBuffer const&) = delete;
-    RingBuffer(RingBuffer&&) = delete;
+        size_t size() const {
+            return m_size;
+        }
 
-    RingBuffer& operator=(RingBuffer const&) = delete;
-    RingBuffer& operator=(RingBuffer&&) = delete;
+        void sync(bool blocking = false) {
+#if defined(__unix__) || defined(__APPLE__)
+            ::msync(m_data, m_size, blocking ? MS_SYNC : MS_ASYNC);
+#endif
+        }
 
-    template <typename... U>
-    void emplace_back(U&&... args) {
-        buffer[ptr_tail] = T(std::forward<U>(args)...);
+    private:
+        void* m_data;
+        size_t m_size;
+    };
+}  // namespace platform
 
-        num_data += 1;
-        ptr_tail = (ptr_tail + 1) % size_buffer;
-    }
 
-    void pop_front() {
-        num_data -= 1;
-        ptr_head = (ptr_head + 1) % size_buffer;
-    }
+namespace platform {
+#if defined(__unix__) || defined(__APPLE__)
+    // Named shared memory segment, first process creates and owns it.
+    // Owner unlinks the name on destruction, mapped processes keep using it.
+    class SharedMemory {
+    public:
+        SharedMemory(std::string const& name, size_t size)
+            : name(name), m_data(nullptr), m_size(size), m_owner(true) {
+            int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0 && errno == EEXIST) {
+                m_owner = false;
+                fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+            }
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), name);
+            }
 
-    T& front() {
-        return buffer[ptr_head];
-    }
+            int res = m_owner ? ::ftruncate(fd, size) : wait_size(fd, size);
+            if (res < 0) {
+                int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), name);
+            }
 
-    T const& front() const {
-        return buffer[ptr_head];
-    }
+            void* data = ::mmap(
+                nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            int err = errno;
+            ::close(fd);
 
-    size_t size() const {
-        return num_data;
-    }
+            if (data == MAP_FAILED) {
+                throw std::system_error(err, std::generic_category(), name);
+            }
+            m_data = data;
+        }
 
-    size_t max_size() const {
-        return size_buffer;
-    }
+        ~SharedMemory() {
+            ::munmap(m_data, m_size);
+            if (m_owner) {
+                ::shm_unlink(name.c_str());
+            }
+        }
 
-private:
-    size_t size_buffer;
-    std::unique_ptr<T[]> buffer;
+        SharedMemory(SharedMemory const&) = delete;
+        SharedMemory(SharedMemory&&) = delete;
 
-    size_t num_data = 0;
-    size_t ptr_head = 0;
-    size_t ptr_tail = 0;
-};
+        SharedMemory& operator=(SharedMemory const&) = delete;
+        SharedMemory& operator=(SharedMemory&&) = delete;
 
+        void* data() const {
+            return m_data;
+        }
 
-template <typename Cont, typename Mutex = std::mutex>
-class ThreadSafe {
-public:
-    using value_type = typename Cont::value_type;
+        size_t size() const {
+            return m_size;
+        }
 
-    template <typename... Args>
-    ThreadSafe(Args&&... args)
-        : m_runnable(true), buffer(std::forward<Args>(args)...) {
-        // Do Nothing
-    }
+        bool owner() const {
+            return m_owner;
+        }
 
-    ~ThreadSafe() {
-        close();
-    }
+    private:
+        std::string name;
+        void* m_data;
+        size_t m_size;
+        bool m_owner;
+
+        // wait until owner truncates segment to given size
+        static int wait_size(int fd, size_t size) {
+            struct stat st;
+            do {
+                if (::fstat(fd, &st) < 0) {
+                    return -1;
+                }
+                std::this_thread::yield();
+            } while (static_cast<size_t>(st.st_size) < size);
+            return 0;
+        }
+    };
 
-    ThreadSafe(ThreadSafe const&) = delete;
-    ThreadSafe(ThreadSafe&&) = delete;
+    // Mutex placed in shared memory, constructed once by segment owner.
+    class ProcessMutex {
+    public:
+        ProcessMutex() {
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+
+            int res = pthread_mutex_init(&handle, &attr);
+            pthread_mutexattr_destroy(&attr);
+            if (res != 0) {
+                throw std::system_error(res, std::generic_category());
+            }
+        }
 
-    ThreadSafe& operator=(ThreadSafe const&) = delete;
-    ThreadSafe& operator=(ThreadSafe&&) = delete;
+        ~ProcessMutex() {
+            pthread_mutex_destroy(&handle);
+        }
 
-    template <typename... U>
-    void emplace_back(U&&... args) {
-        std::unique_lock lock(mutex);
-        cond.wait(lock, [&] {
-            return !m_runnable || buffer.size() < buffer.max_size();
-        });
+        ProcessMutex(ProcessMutex const&) = delete;
+        ProcessMutex(ProcessMutex&&) = delete;
+
+        ProcessMutex& operator=(ProcessMutex const&) = delete;
+        ProcessMutex& operator=(ProcessMutex&&) = delete;
+
+        void lock() {
+            pthread_mutex_lock(&handle);
+        }
+
+        bool try_lock() {
+            return pthread_mutex_trylock(&handle) == 0;
+        }
+
+        void unlock() {
+            pthread_mutex_unlock(&handle);
+        }
+
+        pthread_mutex_t* native_handle() {
+            return &handle;
+        }
+
+    private:
+        pthread_mutex_t handle;
+    };
+
+    // Condition variable placed in shared memory, pair of ProcessMutex.
+    class ProcessCondition {
+    public:
+        ProcessCondition() {
+            pthread_condattr_t attr;
+            pthread_condattr_init(&attr);
+            pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+
+            int res = pthread_cond_init(&handle, &attr);
+            pthread_condattr_destroy(&attr);
+            if (res != 0) {
+                throw std::system_error(res, std::generic_category());
+            }
+        }
+
+        ~ProcessCondition() {
+            pthread_cond_destroy(&handle);
+        }
+
+        ProcessCondition(ProcessCondition const&) = delete;
+        ProcessCondition(ProcessCondition&&) = delete;
+
+        ProcessCondition& operator=(ProcessCondition const&) = delete;
+        ProcessCondition& operator=(ProcessCondition&&) = delete;
+
+        template <typename Pred>
+        void wait(std::unique_lock<ProcessMutex>& lock, Pred pred) {
+            while (!pred()) {
+                pthread_cond_wait(&handle, lock.mutex()->native_handle());
+            }
+        }
+
+        // absolute timeout of pthread is measured by system clock
+        template <typename Clock, typename Duration, typename Pred>
+        bool wait_until(std::unique_lock<ProcessMutex>& lock,
+                        std::chrono::time_point<Clock, Duration> const& time,
+                        Pred pred) {
+            using namespace std::chrono;
+            auto left = duration_cast<system_clock::duration>(time
+                                                              - Clock::now());
+            auto real = system_clock::now() + left;
+            auto ns = duration_cast<nanoseconds>(real.time_since_epoch());
+
+            timespec spec;
+            spec.tv_sec = static_cast<time_t>(ns.count() / 1000000000);
+            spec.tv_nsec = static_cast<long>(ns.count() % 1000000000);
+
+            while (!pred()) {
+                int res = pthread_cond_timedwait(
+                    &handle, lock.mutex()->native_handle(), &spec);
+                if (res == ETIMEDOUT) {
+                    return pred();
+                }
+            }
+            return true;
+        }
+
+        void notify_all() {
+            pthread_cond_broadcast(&handle);
+        }
+
+    private:
+        pthread_cond_t handle;
+    };
+#else
+    class SharedMemory {
+    public:
+        SharedMemory(std::string const& name, size_t) {
+            throw std::system_error(
+                std::make_error_code(std::errc::function_not_supported),
+                name);
+        }
+
+        void* data() const {
+            return nullptr;
+        }
+
+        size_t size() const {
+            return 0;
+        }
+
+        bool owner() const {
+            return false;
+        }
+    };
+
+    class ProcessMutex {
+    public:
+        void lock() {
+            // Do Nothing
+        }
+
+        bool try_lock() {
+            return false;
+        }
+
+        void unlock() {
+            // Do Nothing
+        }
+    };
+
+    class ProcessCondition {
+    public:
+        template <typename Pred>
+        void wait(std::unique_lock<ProcessMutex>&, Pred) {
+            // Do Nothing
+        }
+
+        template <typename Time, typename Pred>
+        bool wait_until(std::unique_lock<ProcessMutex>&,
+                        Time const&,
+                        Pred pred) {
+            return pred();
+        }
+
+        void notify_all() {
+            // Do Nothing
+        }
+    };
+#endif
+}  // namespace platform
+
+
+namespace Trace {
+    constexpr bool enabled = platform::trace;
+
+    struct Event {
+        char const* name;
+        // chrome trace phase, B/E for span, b/e for async span, i for instant
+        char phase;
+        uint64_t id;
+        int64_t ts;
+    };
+
+    // Events of single thread, only the owner appends.
+    // Chunks are never moved, so dump could read while owner records.
+    class Buffer {
+    public:
+        Buffer(size_t tid) : tid(tid), tail(&head) {
+            // Do Nothing
+        }
+
+        ~Buffer() {
+            free_chunks();
+        }
+
+        Buffer(Buffer const&) = delete;
+        Buffer(Buffer&&) = delete;
+
+        Buffer& operator=(Buffer const&) = delete;
+        Buffer& operator=(Buffer&&) = delete;
+
+        void push(Event const& event) {
+            size_t size = tail->size.load(std::memory_order_relaxed);
+            if (size == chunk_size) {
+                Chunk* chunk = new Chunk;
+                tail->next.store(chunk, std::memory_order_release);
+                tail = chunk;
+                size = 0;
+            }
+
+            tail->events[size] = event;
+            tail->size.store(size + 1, std::memory_order_release);
+        }
+
+        template <typename F>
+        void for_each(F&& func) const {
+            for (Chunk const* chunk = &head; chunk != nullptr;
+                 chunk = chunk->next.load(std::memory_order_acquire)) {
+                size_t size = chunk->size.load(std::memory_order_acquire);
+                for (size_t i = 0; i < size; ++i) {
+                    func(chunk->events[i]);
+                }
+            }
+        }
+
+        // only if owner does not record at the same time
+        void clear() {
+            free_chunks();
+            head.size = 0;
+            tail = &head;
+        }
+
+        size_t get_tid() const {
+            return tid;
+        }
+
+    private:
+        static constexpr size_t chunk_size = 1024;
+
+        struct Chunk {
+            Event events[chunk_size];
+            std::atomic<size_t> size{ 0 };
+            std::atomic<Chunk*> next{ nullptr };
+        };
+
+        size_t tid;
+        Chunk head;
+        Chunk* tail;
+
+        void free_chunks() {
+            Chunk* chunk = head.next.exchange(nullptr);
+            while (chunk != nullptr) {
+                Chunk* next = chunk->next.load();
+                delete chunk;
+                chunk = next;
+            }
+        }
+    };
+
+    // Process wide sink, each thread registers its buffer once
+    // and records without lock after it.
+    class Recorder {
+    public:
+        static Recorder& global() {
+            static Recorder recorder;
+            return recorder;
+        }
+
+        void record(char const* name, char phase, uint64_t id = 0) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            local_buffer().push(
+                { name,
+                  phase,
+                  id,
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                      .count() });
+        }
+
+        uint64_t next_id() {
+            return id.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // chrome trace event json, opened by chrome://tracing or perfetto
+        void dump(std::ostream& out) {
+            std::unique_lock lock(mutex);
+
+            bool first = true;
+            auto separate = [&] {
+                out << (first ? "\n" : ",\n");
+                first = false;
+            };
+
+            out << "{\"traceEvents\":[";
+            for (auto const& buffer : buffers) {
+                size_t tid = buffer->get_tid();
+                separate();
+                out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                    << "\"tid\":" << tid << ",\"args\":{\"name\":\"thread "
+                    << tid << "\"}}";
+
+                buffer->for_each([&](Event const& event) {
+                    separate();
+                    write(out, event, tid);
+                });
+            }
+            out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        }
+
+        // only if no thread records at the same time
+        void clear() {
+            std::unique_lock lock(mutex);
+            for (auto const& buffer : buffers) {
+                buffer->clear();
+            }
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start;
+        std::atomic<uint64_t> id;
+
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Buffer>> buffers;
+
+        // buffer outlives its thread, events are kept until clear
+        static inline thread_local std::shared_ptr<Buffer> local;
+
+        Recorder() : start(std::chrono::steady_clock::now()), id(1) {
+            // Do Nothing
+        }
+
+        Buffer& local_buffer() {
+            if (local == nullptr) {
+                std::unique_lock lock(mutex);
+                local = std::make_shared<Buffer>(buffers.size() + 1);
+                buffers.push_back(local);
+            }
+            return *local;
+        }
+
+        static void write(std::ostream& out, Event const& event, size_t tid) {
+            out << "{\"name\":\"";
+            for (char const* c = event.name; *c != '\0'; ++c) {
+                if (*c == '"' || *c == '\\') {
+                    out << '\\';
+                }
+                out << *c;
+            }
+
+            // timestamp in microseconds
+            out << "\",\"cat\":\"concurrency\",\"ph\":\"" << event.phase
+                << "\",\"ts\":" << event.ts / 1000 << '.' << std::setw(3)
+                << std::setfill('0') << event.ts % 1000
+                << ",\"pid\":1,\"tid\":" << tid;
+
+            if (event.phase == 'b' || event.phase == 'e') {
+                out << ",\"id\":" << event.id;
+            }
+            else if (event.id != 0) {
+                out << ",\"args\":{\"id\":" << event.id << '}';
+            }
+            if (event.phase == 'i') {
+                out << ",\"s\":\"t\"";
+            }
+            out << '}';
+        }
+    };
+
+    inline void begin(char const* name, uint64_t id = 0) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'B', id);
+        }
+    }
+
+    inline void end(char const* name, uint64_t id = 0) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'E', id);
+        }
+    }
+
+    inline void instant(char const* name, uint64_t id = 0) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'i', id);
+        }
+    }
+
+    // span which may end on another thread, matched by id
+    inline void async_begin(char const* name, uint64_t id) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'b', id);
+        }
+    }
+
+    inline void async_end(char const* name, uint64_t id) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'e', id);
+        }
+    }
+
+    inline bool dump(std::string const& path) {
+        std::ofstream out(path);
+        Recorder::global().dump(out);
+        return static_cast<bool>(out);
+    }
+
+    // record B and E of the scope
+    class Span {
+    public:
+        Span(char const* name, uint64_t id = 0) : name(name), id(id) {
+            begin(name, id);
+        }
+
+        ~Span() {
+            end(name, id);
+        }
+
+        Span(Span const&) = delete;
+        Span(Span&&) = delete;
+
+        Span& operator=(Span const&) = delete;
+        Span& operator=(Span&&) = delete;
+
+    private:
+        char const* name;
+        uint64_t id;
+    };
+
+    // Wrap task of pool, "queued" spans from submit to dequeue and
+    // "task" spans from start to end. Returns func itself if disabled.
+    template <typename F>
+    decltype(auto) task(F&& func) {
+        if constexpr (!enabled) {
+            return std::forward<F>(func);
+        }
+        else {
+            uint64_t id = Recorder::global().next_id();
+            async_begin("queued", id);
+            return [id, func = std::forward<F>(func)]() mutable {
+                async_end("queued", id);
+                Span span("task", id);
+                return func();
+            };
+        }
+    }
+}  // namespace Trace
+
+
+namespace Policy {
+    // capacity of channel without bound
+    constexpr size_t unbounded = 0;
+
+    // number of threads on producer or consumer side
+    struct Single {};
+    struct Multi {};
+
+    // Busy wait with yield, lowest latency but keeps the core busy.
+    class Spin {
+    public:
+        template <typename Pred>
+        void wait(Pred pred) {
+            if (pred()) {
+                return;
+            }
+
+            Trace::Span span("channel.block");
+            while (!pred()) {
+                std::this_thread::yield();
+            }
+        }
+
+        template <typename Clock, typename Duration, typename Pred>
+        bool wait_until(std::chrono::time_point<Clock, Duration> const& time,
+                        Pred pred) {
+            if (pred()) {
+                return true;
+            }
+
+            Trace::Span span("channel.block");
+            while (!pred()) {
+                if (Clock::now() >= time) {
+                    return pred();
+                }
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+        void notify() {
+            // Do Nothing
+        }
+    };
+
+    // Park on condition variable, notifier locks only if someone waits.
+    // Both sides fence between their store and load, so either waiter
+    // sees the new state or notifier sees the waiter.
+    class Park {
+    public:
+        Park() : num_waiting(0) {
+            // Do Nothing
+        }
+
+        Park(Park const&) = delete;
+        Park(Park&&) = delete;
+
+        Park& operator=(Park const&) = delete;
+        Park& operator=(Park&&) = delete;
+
+        template <typename Pred>
+        void wait(Pred pred) {
+            if (pred()) {
+                return;
+            }
+
+            Trace::Span span("channel.block");
+            ++num_waiting;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            {
+                std::unique_lock lock(mutex);
+                cond.wait(lock, pred);
+            }
+            --num_waiting;
+        }
+
+        template <typename Clock, typename Duration, typename Pred>
+        bool wait_until(std::chrono::time_point<Clock, Duration> const& time,
+                        Pred pred) {
+            if (pred()) {
+                return true;
+            }
+
+            Trace::Span span("channel.block");
+            ++num_waiting;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool res;
+            {
+                std::unique_lock lock(mutex);
+                res = cond.wait_until(lock, time, pred);
+            }
+            --num_waiting;
+            return res;
+        }
+
+        void notify() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (num_waiting.load() > 0) {
+                std::unique_lock lock(mutex);
+                cond.notify_all();
+            }
+        }
+
+    private:
+        std::atomic<size_t> num_waiting;
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+    // Spin shortly for the state changed in a few instructions, then park.
+    class Adaptive {
+    public:
+        template <typename Pred>
+        void wait(Pred pred) {
+            for (size_t spin = 0; spin < max_spin; ++spin) {
+                if (pred()) {
+                    return;
+                }
+                platform::cpu_relax();
+            }
+            park.wait(pred);
+        }
+
+        template <typename Clock, typename Duration, typename Pred>
+        bool wait_until(std::chrono::time_point<Clock, Duration> const& time,
+                        Pred pred) {
+            for (size_t spin = 0; spin < max_spin; ++spin) {
+                if (pred()) {
+                    return true;
+                }
+                platform::cpu_relax();
+            }
+            return park.wait_until(time, pred);
+        }
+
+        void notify() {
+            park.notify();
+        }
+
+    private:
+        static constexpr size_t max_spin = 128;
+
+        Park park;
+    };
+}  // namespace Policy
+
+
+// One shot counter, waiters are released once it counts down to zero.
+class Latch {
+public:
+    Latch(size_t expected) : count(expected) {
+        // Do Nothing
+    }
+
+    Latch(Latch const&) = delete;
+    Latch(Latch&&) = delete;
+
+    Latch& operator=(Latch const&) = delete;
+    Latch& operator=(Latch&&) = delete;
+
+    void CountDown(size_t n = 1) {
+        if (count.fetch_sub(n) == n) {
+            waiter.notify();
+        }
+    }
+
+    bool TryWait() const {
+        return count.load(std::memory_order_acquire) == 0;
+    }
+
+    void Wait() {
+        Trace::Span span("Latch::Wait");
+        waiter.wait([&] { return TryWait(); });
+    }
+
+    void ArriveAndWait(size_t n = 1) {
+        CountDown(n);
+        Wait();
+    }
+
+private:
+    std::atomic<size_t> count;
+    Policy::Adaptive waiter;
+};
+
+// Reusable barrier of fixed number of threads per phase.
+// Arrivals are combined in a tree of small counters, so threads hit
+// different cache lines and only the last of each node climbs up.
+// Last one at the root runs completion, resets counters and opens
+// the next phase.
+class Barrier {
+public:
+    Barrier(size_t expected, std::function<void()> completion = nullptr)
+        : expected(std::max<size_t>(expected, 1)),
+          completion(std::move(completion)), m_phase(0) {
+        build();
+    }
+
+    Barrier(Barrier const&) = delete;
+    Barrier(Barrier&&) = delete;
+
+    Barrier& operator=(Barrier const&) = delete;
+    Barrier& operator=(Barrier&&) = delete;
+
+    // arrive without waiting, returns phase token for Wait
+    size_t Arrive() {
+        size_t phase = m_phase.load(std::memory_order_acquire);
+
+        size_t node = 0;
+        bool last = seat(node);
+        while (last) {
+            node = nodes[node].parent;
+            if (node == npos) {
+                complete();
+                break;
+            }
+            Node& current = nodes[node];
+            size_t count =
+                current.count.fetch_add(1, std::memory_order_acq_rel) + 1;
+            last = count == current.capacity;
+        }
+        return phase;
+    }
+
+    void Wait(size_t phase) {
+        Trace::Span span("Barrier::Wait");
+        waiter.wait([&] {
+            return m_phase.load(std::memory_order_acquire) != phase;
+        });
+    }
+
+    void ArriveAndWait() {
+        Wait(Arrive());
+    }
+
+    size_t GetExpected() const {
+        return expected;
+    }
+
+    size_t GetPhase() const {
+        return m_phase.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t fan_in = 4;
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    struct alignas(platform::cache_line) Node {
+        std::atomic<size_t> count;
+        size_t capacity;
+        size_t parent;
+    };
+
+    size_t expected;
+    std::function<void()> completion;
+
+    size_t num_leaves;
+    size_t num_nodes;
+    std::unique_ptr<Node[]> nodes;
+
+    alignas(platform::cache_line) std::atomic<size_t> m_phase;
+    Policy::Adaptive waiter;
+
+    // leaves split arrivals evenly, each upper node counts its children
+    void build() {
+        std::vector<size_t> capacity;
+        std::vector<size_t> parent;
+
+        num_leaves = (expected + fan_in - 1) / fan_in;
+        for (size_t i = 0; i < num_leaves; ++i) {
+            capacity.push_back(expected * (i + 1) / num_leaves
+                               - expected * i / num_leaves);
+        }
+        parent.resize(num_leaves, npos);
+
+        size_t begin = 0;
+        size_t size = num_leaves;
+        while (size > 1) {
+            size_t next = (size + fan_in - 1) / fan_in;
+            size_t next_begin = capacity.size();
+            for (size_t i = 0; i < next; ++i) {
+                size_t lo = size * i / next;
+                size_t hi = size * (i + 1) / next;
+                capacity.push_back(hi - lo);
+                parent.push_back(npos);
+                for (size_t child = lo; child < hi; ++child) {
+                    parent[begin + child] = next_begin + i;
+                }
+            }
+            begin = next_begin;
+            size = next;
+        }
+
+        num_nodes = capacity.size();
+        nodes = std::make_unique<Node[]>(num_nodes);
+        for (size_t i = 0; i < num_nodes; ++i) {
+            nodes[i].count.store(0, std::memory_order_relaxed);
+            nodes[i].capacity = capacity[i];
+            nodes[i].parent = parent[i];
+        }
+    }
+
+    // Take a seat at leaf, starting from the one of this thread,
+    // true if it was the last seat there. Seats sum up to expected,
+    // so one is always left, and leaves counted over are reset with
+    // others at the end of phase.
+    bool seat(size_t& node) {
+        std::thread::id id = std::this_thread::get_id();
+        size_t start = std::hash<std::thread::id>()(id);
+        for (size_t i = 0;; ++i) {
+            node = (start + i) % num_leaves;
+            Node& leaf = nodes[node];
+            size_t taken = leaf.count.fetch_add(1, std::memory_order_acq_rel);
+            if (taken < leaf.capacity) {
+                return taken + 1 == leaf.capacity;
+            }
+        }
+    }
+
+    void complete() {
+        if (completion) {
+            completion();
+        }
+
+        for (size_t i = 0; i < num_nodes; ++i) {
+            nodes[i].count.store(0, std::memory_order_relaxed);
+        }
+
+        m_phase.fetch_add(1, std::memory_order_release);
+        waiter.notify();
+    }
+};
+
+
+template <typename T, typename Channel>
+class ChannelIterator {
+public:
+    ChannelIterator(Channel& channel, std::optional<T>&& item)
+        : channel(channel), item(std::move(item)) {
+        // Do Nothing
+    }
+
+    T& operator*() {
+        return item.value();
+    }
+
+    T const& operator*() const {
+        return item.value();
+    }
+
+    ChannelIterator& operator++() {
+        item = channel.Get();
+        return *this;
+    }
+
+    // end of channel is only iterator without value
+    bool operator!=(ChannelIterator const& other) const {
+        return item.has_value() != other.item.has_value();
+    }
+
+private:
+    Channel& channel;
+    std::optional<T> item;
+};
+
+
+// Thread safe unbounded queue split into lanes, producer thread is hashed
+// to single lane and consumers sweep lanes from random start.
+// Order is kept per producer, not globally.
+template <typename T>
+class ShardedQueue {
+public:
+    using value_type = T;
+
+    ShardedQueue()
+        : ShardedQueue(std::max(1u, std::thread::hardware_concurrency())) {
+        // Do Nothing
+    }
+
+    ShardedQueue(size_t num_lanes)
+        : num_lanes(std::max<size_t>(num_lanes, 1)),
+          lanes(std::make_unique<Lane[]>(this->num_lanes)), m_runnable(true),
+          num_waiting(0), epoch(0) {
+        // Do Nothing
+    }
+
+    ~ShardedQueue() {
+        close();
+    }
+
+    ShardedQueue(ShardedQueue const&) = delete;
+    ShardedQueue(ShardedQueue&&) = delete;
+
+    ShardedQueue& operator=(ShardedQueue const&) = delete;
+    ShardedQueue& operator=(ShardedQueue&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        if (!runnable()) {
+            return;
+        }
+
+        Lane& lane = lanes[std::hash<std::thread::id>()(
+                               std::this_thread::get_id())
+                           % num_lanes];
+        {
+            std::unique_lock lock(lane.mutex);
+            lane.queue.emplace_back(std::forward<U>(args)...);
+        }
+
+        if (num_waiting.load() > 0) {
+            std::unique_lock lock(mutex);
+            ++epoch;
+            cond.notify_all();
+        }
+    }
+
+    // queue is unbounded, so only closed queue refuses
+    template <typename... U>
+    bool try_emplace_back(U&&... args) {
+        if (!runnable()) {
+            return false;
+        }
+        emplace_back(std::forward<U>(args)...);
+        return true;
+    }
+
+    template <typename Clock, typename Duration, typename... U>
+    bool emplace_back_until(std::chrono::time_point<Clock, Duration> const&,
+                            U&&... args) {
+        return try_emplace_back(std::forward<U>(args)...);
+    }
+
+    void push_back(value_type const& value) {
+        emplace_back(value);
+    }
+
+    void push_back(value_type&& value) {
+        emplace_back(std::move(value));
+    }
+
+    std::optional<value_type> pop_front() {
+        std::optional<value_type> given;
+        wait_for_item([&](value_type& item) { given = std::move(item); });
+        return given;
+    }
+
+    std::optional<value_type> try_pop() {
+        std::optional<value_type> given;
+        sweep([&](value_type& item) { given = std::move(item); });
+        return given;
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> pop_front_until(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        std::optional<value_type> given;
+        wait_for_item([&](value_type& item) { given = std::move(item); },
+                      &time);
+        return given;
+    }
+
+    template <typename F>
+    bool consume_front(F&& func) {
+        return wait_for_item(func);
+    }
+
+    void close() {
+        std::unique_lock lock(mutex);
+        m_runnable = false;
+        cond.notify_all();
+    }
+
+    bool runnable() const {
+        return m_runnable;
+    }
+
+    bool readable() {
+        if (runnable()) {
+            return true;
+        }
+        for (size_t i = 0; i < num_lanes; ++i) {
+            std::unique_lock lock(lanes[i].mutex);
+            if (!lanes[i].queue.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (size_t i = 0; i < num_lanes; ++i) {
+            std::unique_lock lock(lanes[i].mutex);
+            total += lanes[i].queue.size();
+        }
+        return total;
+    }
+
+private:
+    struct alignas(platform::cache_line) Lane {
+        std::mutex mutex;
+        std::deque<T> queue;
+    };
+
+    size_t num_lanes;
+    std::unique_ptr<Lane[]> lanes;
+
+    alignas(platform::cache_line) std::atomic<bool> m_runnable;
+    std::atomic<size_t> num_waiting;
+
+    alignas(platform::cache_line) std::mutex mutex;
+    std::condition_variable cond;
+    size_t epoch;
+
+    // take front of the first non-empty lane from random start,
+    // busy lanes are skipped first and locked on second pass
+    template <typename F>
+    bool sweep(F&& func) {
+        thread_local std::minstd_rand rng(static_cast<unsigned>(
+            std::hash<std::thread::id>()(std::this_thread::get_id())));
+        size_t start = rng() % num_lanes;
+
+        bool skipped = false;
+        for (size_t i = 0; i < num_lanes; ++i) {
+            Lane& lane = lanes[(start + i) % num_lanes];
+            std::unique_lock lock(lane.mutex, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                skipped = true;
+            }
+            else if (take(lane, func)) {
+                return true;
+            }
+        }
+
+        if (skipped) {
+            for (size_t i = 0; i < num_lanes; ++i) {
+                Lane& lane = lanes[(start + i) % num_lanes];
+                std::unique_lock lock(lane.mutex);
+                if (take(lane, func)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    template <typename F>
+    static bool take(Lane& lane, F& func) {
+        if (lane.queue.empty()) {
+            return false;
+        }
+        func(lane.queue.front());
+        lane.queue.pop_front();
+        return true;
+    }
+
+    // producer bumps epoch only if someone is waiting, so waiter reads
+    // epoch before sweeping to not miss items pushed after the sweep,
+    // wait forever if deadline is null
+    template <typename F,
+              typename Clock = std::chrono::steady_clock,
+              typename Duration = typename Clock::duration>
+    bool wait_for_item(
+        F&& func,
+        std::chrono::time_point<Clock, Duration> const* deadline = nullptr) {
+        while (true) {
+            if (sweep(func)) {
+                return true;
+            }
+
+            ++num_waiting;
+            size_t seen;
+            {
+                std::unique_lock lock(mutex);
+                seen = epoch;
+            }
+
+            bool found = sweep(func);
+            bool expired = false;
+            if (!found) {
+                std::unique_lock lock(mutex);
+                auto pred = [&] { return !m_runnable || epoch != seen; };
+                if (deadline == nullptr) {
+                    cond.wait(lock, pred);
+                }
+                else {
+                    expired = !cond.wait_until(lock, *deadline, pred);
+                }
+            }
+            --num_waiting;
+
+            if (found) {
+                return true;
+            }
+            if (expired) {
+                return sweep(func);
+            }
+            if (!runnable() && !readable()) {
+                return false;
+            }
+        }
+    }
+};
+
+
+template <typename T, typename = void>  // for stl compatiblity
+class RingBuffer {
+public:
+    using value_type = T;
+
+    static_assert(std::is_default_constructible_v<T>,
+                  "RingBuffer base type must be default constructible");
+
+    RingBuffer() : RingBuffer(1) {
+        // Do Nothing
+    }
+
+    RingBuffer(size_t size_buffer)
+        : size_buffer(size_buffer), buffer(std::make_unique<T[]>(size_buffer)) {
+        // Do Nothing
+    }
+
+    RingBuffer(RingBuffer const&) = delete;
+    RingBuffer(RingBuffer&&) = delete;
+
+    RingBuffer& operator=(RingBuffer const&) = delete;
+    RingBuffer& operator=(RingBuffer&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        reserve_back() = T(std::forward<U>(args)...);
+        commit_back();
+    }
+
+    // slot which will be published by next commit_back
+    T& reserve_back() {
+        return buffer[ptr_tail];
+    }
+
+    T const& reserve_back() const {
+        return buffer[ptr_tail];
+    }
+
+    void commit_back() {
+        num_data += 1;
+        ptr_tail = (ptr_tail + 1) % size_buffer;
+    }
+
+    void pop_front() {
+        num_data -= 1;
+        ptr_head = (ptr_head + 1) % size_buffer;
+    }
+
+    T& front() {
+        return buffer[ptr_head];
+    }
+
+    T const& front() const {
+        return buffer[ptr_head];
+    }
+
+    size_t size() const {
+        return num_data;
+    }
+
+    size_t max_size() const {
+        return size_buffer;
+    }
+
+private:
+    size_t size_buffer;
+    std::unique_ptr<T[]> buffer;
+
+    size_t num_data = 0;
+    size_t ptr_head = 0;
+    size_t ptr_tail = 0;
+};
+
+
+// state is guarded by single mutex and kept together,
+// aligned to prevent false sharing with neighbor objects,
+// mutex other than std::mutex waits on std::condition_variable_any
+template <typename Cont, typename Mutex = std::mutex>
+class alignas(platform::cache_line) ThreadSafe {
+public:
+    using value_type = typename Cont::value_type;
+
+    // Exclusive borrow of the next back slot, publish it with commit.
+    // Lock is held while reservation alive, keep it short.
+    class Reservation {
+    public:
+        Reservation(ThreadSafe& parent, std::unique_lock<Mutex>&& lock)
+            : parent(parent), lock(std::move(lock)), committed(false) {
+            // Do Nothing
+        }
+
+        ~Reservation() {
+            if (lock.owns_lock()) {
+                lock.unlock();
+            }
+        }
+
+        Reservation(Reservation const&) = delete;
+        Reservation(Reservation&&) = default;
+
+        Reservation& operator=(Reservation const&) = delete;
+        Reservation& operator=(Reservation&&) = delete;
+
+        explicit operator bool() const {
+            return lock.owns_lock() && !committed;
+        }
+
+        value_type& operator*() {
+            return parent.buffer.reserve_back();
+        }
+
+        value_type* operator->() {
+            return &parent.buffer.reserve_back();
+        }
+
+        void commit() {
+            if (*this) {
+                parent.buffer.commit_back();
+                committed = true;
+
+                lock.unlock();
+                parent.cond.notify_all();
+            }
+        }
+
+    private:
+        ThreadSafe& parent;
+        std::unique_lock<Mutex> lock;
+        bool committed;
+    };
+
+    template <typename... Args>
+    ThreadSafe(Args&&... args)
+        : m_runnable(true), buffer(std::forward<Args>(args)...),
+          num_readers(0), num_writers(0) {
+        // Do Nothing
+    }
+
+    ~ThreadSafe() {
+        close();
+    }
+
+    ThreadSafe(ThreadSafe const&) = delete;
+    ThreadSafe(ThreadSafe&&) = delete;
+
+    ThreadSafe& operator=(ThreadSafe const&) = delete;
+    ThreadSafe& operator=(ThreadSafe&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        std::unique_lock lock(mutex);
+        wait(lock, num_writers, [&] {
+            return !m_runnable || buffer.size() < buffer.max_size();
+        });
+
+        if (m_runnable) {
+            buffer.emplace_back(std::forward<U>(args)...);
+        }
+        cond.notify_all();
+    }
+
+    void push_back(value_type const& value) {
+        emplace_back(value);
+    }
+
+    void push_back(value_type&& value) {
+        emplace_back(std::move(value));
+    }
+
+    // Push range under one lock, moved from if it is move iterator.
+    // Waits for room only when bounded buffer is full, wakes as many
+    // readers as pushed. Returns number pushed, less only if closed.
+    template <typename It>
+    size_t push_back_range(It first, It last) {
+        size_t pushed = 0;
+        std::unique_lock lock(mutex);
+        while (first != last) {
+            wait(lock, num_writers, [&] {
+                return !m_runnable || buffer.size() < buffer.max_size();
+            });
+            if (!m_runnable) {
+                break;
+            }
+
+            size_t added = 0;
+            for (; first != last && buffer.size() < buffer.max_size();
+                 ++first) {
+                buffer.emplace_back(*first);
+                ++added;
+            }
+            notify_readers(added);
+            pushed += added;
+        }
+        return pushed;
+    }
+
+    // fail only if buffer is full or closed, never on lock contention
+    template <typename... U>
+    bool try_emplace_back(U&&... args) {
+        std::unique_lock lock(mutex);
+        if (!m_runnable || buffer.size() >= buffer.max_size()) {
+            return false;
+        }
+
+        buffer.emplace_back(std::forward<U>(args)...);
+        cond.notify_all();
+        return true;
+    }
+
+    template <typename Clock, typename Duration, typename... U>
+    bool emplace_back_until(
+        std::chrono::time_point<Clock, Duration> const& time, U&&... args) {
+        std::unique_lock lock(mutex);
+        wait_until(lock, time, num_writers, [&] {
+            return !m_runnable || buffer.size() < buffer.max_size();
+        });
+
+        if (!m_runnable || buffer.size() >= buffer.max_size()) {
+            return false;
+        }
+
+        buffer.emplace_back(std::forward<U>(args)...);
+        cond.notify_all();
+        return true;
+    }
+
+    std::optional<value_type> pop_front() {
+        std::unique_lock lock(mutex);
+        wait(lock, num_readers, [&] {
+            return !m_runnable || buffer.size() > 0;
+        });
+
+        return take_front();
+    }
+
+    // fail only if buffer is empty, never on lock contention
+    std::optional<value_type> try_pop() {
+        std::unique_lock lock(mutex);
+        return take_front();
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> pop_front_until(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        std::unique_lock lock(mutex);
+        wait_until(lock, time, num_readers, [&] {
+            return !m_runnable || buffer.size() > 0;
+        });
+
+        return take_front();
+    }
+
+    // call func with front element in place, then pop it
+    template <typename F>
+    bool consume_front(F&& func) {
+        std::unique_lock lock(mutex);
+        wait(lock, num_readers, [&] {
+            return !m_runnable || buffer.size() > 0;
+        });
+
+        if (!m_runnable && buffer.size() == 0) {
+            return false;
+        }
+
+        func(buffer.front());
+        buffer.pop_front();
+
+        cond.notify_all();
+        return true;
+    }
+
+    // requires reserve_back and commit_back from container, e.g. RingBuffer
+    Reservation reserve_back() {
+        std::unique_lock lock(mutex);
+        wait(lock, num_writers, [&] {
+            return !m_runnable || buffer.size() < buffer.max_size();
+        });
+
+        if (!m_runnable) {
+            lock.unlock();
+        }
+        return Reservation(*this, std::move(lock));
+    }
+
+    void close() {
+        m_runnable = false;
+        cond.notify_all();
+    }
+
+    bool runnable() const {
+        return m_runnable;
+    }
+
+    bool readable() {
+        std::unique_lock lock(mutex);
+        return m_runnable || buffer.size() > 0;
+    }
+
+private:
+    bool m_runnable;
+    Cont buffer;
+
+    Mutex mutex;
+    std::conditional_t<std::is_same_v<Mutex, std::mutex>,
+                       std::condition_variable,
+                       std::condition_variable_any>
+        cond;
+
+    // threads waiting on cond for item and for room, guarded by mutex
+    size_t num_readers;
+    size_t num_writers;
+
+    // traced as channel block only if it really waits
+    template <typename Pred>
+    void wait(std::unique_lock<Mutex>& lock, size_t& waiting, Pred pred) {
+        if (pred()) {
+            return;
+        }
+
+        ++waiting;
+        if constexpr (Trace::enabled) {
+            Trace::Span span("channel.block");
+            cond.wait(lock, pred);
+        }
+        else {
+            cond.wait(lock, pred);
+        }
+        --waiting;
+    }
+
+    template <typename Clock, typename Duration, typename Pred>
+    void wait_until(std::unique_lock<Mutex>& lock,
+                    std::chrono::time_point<Clock, Duration> const& time,
+                    size_t& waiting,
+                    Pred pred) {
+        if (pred()) {
+            return;
+        }
+
+        ++waiting;
+        if constexpr (Trace::enabled) {
+            Trace::Span span("channel.block");
+            cond.wait_until(lock, time, pred);
+        }
+        else {
+            cond.wait_until(lock, time, pred);
+        }
+        --waiting;
+    }
+
+    // Wake n readers only. Writer could take the wake up of reader,
+    // so everyone is waked if any writer waits.
+    void notify_readers(size_t n) {
+        if (num_writers > 0 || n >= num_readers) {
+            cond.notify_all();
+            return;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            cond.notify_one();
+        }
+    }
+
+    std::optional<value_type> take_front() {
+        if (buffer.size() == 0) {
+            return std::nullopt;
+        }
+
+        std::optional<value_type> given(std::move(buffer.front()));
+        buffer.pop_front();
+
+        cond.notify_all();
+        return given;
+    }
+};
+
+template <typename T>
+using TSList = ThreadSafe<std::list<T>>;
+
+template <typename T>
+using TSRingBuffer = ThreadSafe<RingBuffer<T>>;
+
+
+namespace LockFree {
+    // Link embedded in the element of intrusive queue.
+    struct MpscHook {
+        std::atomic<MpscHook*> next;
+
+        MpscHook() : next(nullptr) {
+            // Do Nothing
+        }
+    };
+
+    // Vyukov style intrusive queue, T derives MpscHook and caller owns it.
+    // Push is single exchange, so it is wait free for any number of threads.
+    // Pop is for single consumer and uses no compare exchange.
+    template <typename T>
+    class IntrusiveMpsc {
+    public:
+        IntrusiveMpsc() : m_head(&stub), m_tail(&stub) {
+            // Do Nothing
+        }
+
+        IntrusiveMpsc(IntrusiveMpsc const&) = delete;
+        IntrusiveMpsc(IntrusiveMpsc&&) = delete;
+
+        IntrusiveMpsc& operator=(IntrusiveMpsc const&) = delete;
+        IntrusiveMpsc& operator=(IntrusiveMpsc&&) = delete;
+
+        void push(T* node) {
+            push_hook(node);
+        }
+
+        // nullptr only if queue is empty, waits for a producer which
+        // already took its place but has not linked it yet
+        T* pop() {
+            MpscHook* tail = m_tail;
+            MpscHook* next = tail->next.load(std::memory_order_acquire);
+
+            if (tail == &stub) {
+                if (next == nullptr) {
+                    if (m_head.load(std::memory_order_acquire) == &stub) {
+                        return nullptr;
+                    }
+                    next = wait_link(tail);
+                }
+                m_tail = next;
+                tail = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+
+            if (next == nullptr) {
+                if (tail == m_head.load(std::memory_order_acquire)) {
+                    // tail is last one, stub takes its place
+                    push_hook(&stub);
+                }
+                next = wait_link(tail);
+            }
+
+            m_tail = next;
+            return static_cast<T*>(tail);
+        }
+
+    private:
+        // producers on their own cache line, consumer owns the rest
+        alignas(platform::cache_line) std::atomic<MpscHook*> m_head;
+        alignas(platform::cache_line) MpscHook* m_tail;
+        MpscHook stub;
+
+        void push_hook(MpscHook* node) {
+            node->next.store(nullptr, std::memory_order_relaxed);
+            MpscHook* prev = m_head.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        static MpscHook* wait_link(MpscHook* node) {
+            MpscHook* next;
+            while ((next = node->next.load(std::memory_order_acquire))
+                   == nullptr) {
+                std::this_thread::yield();
+            }
+            return next;
+        }
+    };
+
+    // Unbounded channel buffer for many producers and single consumer,
+    // allocates one node per element over IntrusiveMpsc.
+    template <typename T,
+              typename Wait = Policy::Park,
+              typename Alloc = std::allocator<T>>
+    class MpscQueue {
+    public:
+        using value_type = T;
+
+        MpscQueue(Alloc const& alloc = Alloc())
+            : alloc(alloc), m_runnable(true), m_pushed(0), m_popped(0) {
+            // Do Nothing
+        }
+
+        ~MpscQueue() {
+            close();
+            while (Item* item = queue.pop()) {
+                destroy(item);
+            }
+        }
+
+        MpscQueue(MpscQueue const&) = delete;
+        MpscQueue(MpscQueue&&) = delete;
+
+        MpscQueue& operator=(MpscQueue const&) = delete;
+        MpscQueue& operator=(MpscQueue&&) = delete;
+
+        template <typename... U>
+        void emplace_back(U&&... args) {
+            try_emplace_back(std::forward<U>(args)...);
+        }
+
+        void push_back(value_type const& value) {
+            emplace_back(value);
+        }
+
+        void push_back(value_type&& value) {
+            emplace_back(std::move(value));
+        }
+
+        // queue is unbounded, so only closed queue refuses
+        template <typename... U>
+        bool try_emplace_back(U&&... args) {
+            if (!m_runnable) {
+                return false;
+            }
+
+            Item* item = item_traits::allocate(alloc, 1);
+            try {
+                item_traits::construct(alloc, item, std::forward<U>(args)...);
+            }
+            catch (...) {
+                item_traits::deallocate(alloc, item, 1);
+                throw;
+            }
+
+            queue.push(item);
+            m_pushed.fetch_add(1, std::memory_order_relaxed);
+            waiter.notify();
+            return true;
+        }
+
+        template <typename Clock, typename Duration, typename... U>
+        bool emplace_back_until(std::chrono::time_point<Clock, Duration> const&,
+                                U&&... args) {
+            return try_emplace_back(std::forward<U>(args)...);
+        }
+
+        std::optional<value_type> pop_front() {
+            std::optional<value_type> given;
+            consume_front([&](value_type& data) { given = std::move(data); });
+            return given;
+        }
+
+        std::optional<value_type> try_pop() {
+            std::optional<value_type> given;
+            if (Item* item = take()) {
+                given = std::move(item->data);
+                destroy(item);
+            }
+            return given;
+        }
+
+        template <typename Clock, typename Duration>
+        std::optional<value_type> pop_front_until(
+            std::chrono::time_point<Clock, Duration> const& time) {
+            Item* item = nullptr;
+            waiter.wait_until(time, [&] {
+                item = take();
+                return item != nullptr || !m_runnable;
+            });
+
+            if (item == nullptr) {
+                item = take();
+            }
+
+            std::optional<value_type> given;
+            if (item != nullptr) {
+                given = std::move(item->data);
+                destroy(item);
+            }
+            return given;
+        }
+
+        // after close, items pushed before it are still consumed
+        template <typename F>
+        bool consume_front(F&& func) {
+            Item* item = nullptr;
+            waiter.wait([&] {
+                item = take();
+                return item != nullptr || !m_runnable;
+            });
+
+            if (item == nullptr) {
+                item = take();
+            }
+            if (item == nullptr) {
+                return false;
+            }
+
+            try {
+                func(item->data);
+            }
+            catch (...) {
+                destroy(item);
+                throw;
+            }
+            destroy(item);
+            return true;
+        }
+
+        void close() {
+            m_runnable = false;
+            waiter.notify();
+        }
+
+        bool runnable() const {
+            return m_runnable;
+        }
+
+        bool readable() {
+            return m_runnable || size() > 0;
+        }
+
+        size_t size() const {
+            size_t popped = m_popped.load(std::memory_order_relaxed);
+            size_t pushed = m_pushed.load(std::memory_order_relaxed);
+            return pushed > popped ? pushed - popped : 0;
+        }
+
+    private:
+        struct Item : MpscHook {
+            T data;
+
+            template <typename... U>
+            Item(U&&... args) : data(std::forward<U>(args)...) {
+                // Do Nothing
+            }
+        };
+
+        using item_alloc =
+            typename std::allocator_traits<Alloc>::template rebind_alloc<Item>;
+        using item_traits = std::allocator_traits<item_alloc>;
+
+        item_alloc alloc;
+        IntrusiveMpsc<Item> queue;
+
+        std::atomic<bool> m_runnable;
+        Wait waiter;
+
+        alignas(platform::cache_line) std::atomic<size_t> m_pushed;
+        alignas(platform::cache_line) std::atomic<size_t> m_popped;
+
+        Item* take() {
+            Item* item = queue.pop();
+            if (item != nullptr) {
+                m_popped.fetch_add(1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        void destroy(Item* item) {
+            item_traits::destroy(alloc, item);
+            item_traits::deallocate(alloc, item, 1);
+        }
+    };
+}  // namespace LockFree
+
+
+namespace LockFree {
+    // Unbounded MPMC queue over linked array segments.
+    // Producers fetch add a slot of the tail segment, consumers take
+    // written slots of the head segment in order with compare exchange.
+    // Drained segments are recycled through free list, so memory stays
+    // contiguous and allocation happens once per SegmentSize items.
+    template <typename T,
+              typename Wait = Policy::Park,
+              typename Alloc = std::allocator<T>,
+              size_t SegmentSize = 128>
+    class SegmentQueue {
+    public:
+        using value_type = T;
+
+        SegmentQueue(Alloc const& alloc = Alloc())
+            : alloc(alloc), seg_alloc(alloc), m_runnable(true),
+              free_lock(false), free_list(nullptr), m_popped(0),
+              m_pushed(0) {
+            Segment* seg = allocate();
+            m_head = seg;
+            m_tail = seg;
+        }
+
+        ~SegmentQueue() {
+            close();
+
+            Segment* seg = m_head.load();
+            while (seg != nullptr) {
+                Segment* next = seg->next.load();
+                size_t end = std::min(seg->enq_idx.load(), SegmentSize);
+                for (size_t i = seg->deq_idx.load(); i < end; ++i) {
+                    if (seg->slots[i].state.load() == written) {
+                        destroy(seg->slots[i]);
+                    }
+                }
+                deallocate(seg);
+                seg = next;
+            }
+
+            seg = free_list.load();
+            while (seg != nullptr) {
+                Segment* next = seg->free_next;
+                deallocate(seg);
+                seg = next;
+            }
+        }
+
+        SegmentQueue(SegmentQueue const&) = delete;
+        SegmentQueue(SegmentQueue&&) = delete;
+
+        SegmentQueue& operator=(SegmentQueue const&) = delete;
+        SegmentQueue& operator=(SegmentQueue&&) = delete;
+
+        template <typename... U>
+        void emplace_back(U&&... args) {
+            try_emplace_back(std::forward<U>(args)...);
+        }
+
+        void push_back(value_type const& value) {
+            emplace_back(value);
+        }
+
+        void push_back(value_type&& value) {
+            emplace_back(std::move(value));
+        }
+
+        // queue is unbounded, so only closed queue refuses
+        template <typename... U>
+        bool try_emplace_back(U&&... args) {
+            if (!m_runnable) {
+                return false;
+            }
+
+            while (true) {
+                Segment* seg = acquire(m_tail);
+                size_t idx = seg->enq_idx.fetch_add(1);
+                if (idx < SegmentSize) {
+                    Slot& slot = seg->slots[idx];
+                    try {
+                        traits::construct(alloc,
+                                          slot.ptr(),
+                                          std::forward<U>(args)...);
+                    }
+                    catch (...) {
+                        // consumers skip broken slot
+                        slot.state.store(broken, std::memory_order_release);
+                        release(seg);
+                        throw;
+                    }
+                    slot.state.store(written, std::memory_order_release);
+                    release(seg);
+                    break;
+                }
+
+                Segment* next = seg->next.load();
+                if (next == nullptr) {
+                    Segment* fresh = allocate();
+                    if (seg->next.compare_exchange_strong(next, fresh)) {
+                        next = fresh;
+                    }
+                    else {
+                        recycle(fresh);
+                    }
+                }
+                Segment* tail = seg;
+                m_tail.compare_exchange_strong(tail, next);
+                release(seg);
+            }
+
+            m_pushed.fetch_add(1, std::memory_order_relaxed);
+            waiter.notify();
+            return true;
+        }
+
+        template <typename Clock, typename Duration, typename... U>
+        bool emplace_back_until(std::chrono::time_point<Clock, Duration> const&,
+                                U&&... args) {
+            return try_emplace_back(std::forward<U>(args)...);
+        }
+
+        std::optional<value_type> pop_front() {
+            std::optional<value_type> given;
+            consume_front([&](value_type& data) { given = std::move(data); });
+            return given;
+        }
+
+        std::optional<value_type> try_pop() {
+            std::optional<value_type> given;
+            Taken taken;
+            if (take(taken)) {
+                consume(taken,
+                        [&](value_type& data) { given = std::move(data); });
+            }
+            return given;
+        }
+
+        template <typename Clock, typename Duration>
+        std::optional<value_type> pop_front_until(
+            std::chrono::time_point<Clock, Duration> const& time) {
+            Taken taken;
+            bool found = false;
+            waiter.wait_until(time, [&] {
+                found = take(taken);
+                return found || !m_runnable;
+            });
+
+            std::optional<value_type> given;
+            if (found || take(taken)) {
+                consume(taken,
+                        [&](value_type& data) { given = std::move(data); });
+            }
+            return given;
+        }
+
+        // after close, items pushed before it are still consumed
+        template <typename F>
+        bool consume_front(F&& func) {
+            Taken taken;
+            bool found = false;
+            waiter.wait([&] {
+                found = take(taken);
+                return found || !m_runnable;
+            });
+
+            if (!found && !take(taken)) {
+                return false;
+            }
+            consume(taken, std::forward<F>(func));
+            return true;
+        }
+
+        void close() {
+            m_runnable = false;
+            waiter.notify();
+        }
+
+        bool runnable() const {
+            return m_runnable;
+        }
+
+        bool readable() {
+            return m_runnable || size() > 0;
+        }
+
+        size_t size() const {
+            size_t popped = m_popped.load(std::memory_order_relaxed);
+            size_t pushed = m_pushed.load(std::memory_order_relaxed);
+            return pushed > popped ? pushed - popped : 0;
+        }
+
+    private:
+        static constexpr unsigned char empty = 0;
+        static constexpr unsigned char written = 1;
+        static constexpr unsigned char broken = 2;
+
+        struct Slot {
+            std::atomic<unsigned char> state;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* ptr() {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+        };
+
+        // Reference count in units of two, lowest bit marks retired one.
+        // Segment memory lives until queue is destroyed, so stale threads
+        // may count on recycled one, they validate it before use.
+        struct Segment {
+            alignas(platform::cache_line) std::atomic<size_t> enq_idx;
+            alignas(platform::cache_line) std::atomic<size_t> deq_idx;
+            alignas(platform::cache_line) std::atomic<Segment*> next;
+            std::atomic<size_t> refs;
+            Segment* free_next;
+
+            Slot slots[SegmentSize];
+
+            Segment() : refs(0), free_next(nullptr) {
+                reset();
+            }
+
+            void reset() {
+                enq_idx.store(0, std::memory_order_relaxed);
+                deq_idx.store(0, std::memory_order_relaxed);
+                next.store(nullptr, std::memory_order_relaxed);
+                for (Slot& slot : slots) {
+                    slot.state.store(empty, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        using traits = std::allocator_traits<Alloc>;
+        using seg_alloc_t =
+            typename traits::template rebind_alloc<Segment>;
+        using seg_traits = std::allocator_traits<seg_alloc_t>;
+
+        Alloc alloc;
+        seg_alloc_t seg_alloc;
+
+        std::atomic<bool> m_runnable;
+        Wait waiter;
+
+        // Push is lock free, single popper at a time under free_lock so
+        // top never comes back to the popper. On contention new segment
+        // is allocated instead, so no operation waits for the lock.
+        std::atomic<bool> free_lock;
+        std::atomic<Segment*> free_list;
+
+        alignas(platform::cache_line) std::atomic<Segment*> m_head;
+        std::atomic<size_t> m_popped;
+
+        alignas(platform::cache_line) std::atomic<Segment*> m_tail;
+        std::atomic<size_t> m_pushed;
+
+        // slot taken by consumer, its segment is counted until consumed
+        struct Taken {
+            Segment* seg = nullptr;
+            Slot* slot = nullptr;
+        };
+
+        // Take the next written slot, false if queue is empty.
+        // Runs in wait predicate, so it calls no user code.
+        bool take(Taken& taken) {
+            while (true) {
+                Segment* seg = acquire(m_head);
+                size_t idx = seg->deq_idx.load();
+
+                if (idx >= SegmentSize) {
+                    Segment* next = seg->next.load();
+                    if (next == nullptr) {
+                        release(seg);
+                        return false;
+                    }
+
+                    // unlinked from both ends before retirement
+                    Segment* head = seg;
+                    if (m_head.compare_exchange_strong(head, next)) {
+                        Segment* tail = seg;
+                        m_tail.compare_exchange_strong(tail, next);
+                        seg->refs.fetch_or(1);
+                    }
+                    release(seg);
+                    continue;
+                }
+
+                Slot& slot = seg->slots[idx];
+                unsigned char state =
+                    slot.state.load(std::memory_order_acquire);
+                if (state == empty) {
+                    if (idx >= seg->enq_idx.load()) {
+                        release(seg);
+                        return false;
+                    }
+
+                    // producer took the slot and writes it now
+                    release(seg);
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                if (!seg->deq_idx.compare_exchange_strong(idx, idx + 1)
+                    || state == broken) {
+                    release(seg);
+                    continue;
+                }
+
+                m_popped.fetch_add(1, std::memory_order_relaxed);
+                taken.seg = seg;
+                taken.slot = &slot;
+                return true;
+            }
+        }
+
+        template <typename F>
+        void consume(Taken& taken, F&& func) {
+            try {
+                func(*taken.slot->ptr());
+            }
+            catch (...) {
+                destroy(*taken.slot);
+                release(taken.seg);
+                throw;
+            }
+            destroy(*taken.slot);
+            release(taken.seg);
+        }
+
+        // count on the segment, valid while it is still linked at loc
+        Segment* acquire(std::atomic<Segment*>& loc) {
+            while (true) {
+                Segment* seg = loc.load();
+                seg->refs.fetch_add(2);
+                if (loc.load() == seg) {
+                    return seg;
+                }
+                release(seg);
+            }
+        }
+
+        // last one leaving retired segment recycles it
+        void release(Segment* seg) {
+            size_t refs = seg->refs.fetch_sub(2) - 2;
+            if (refs == 1 && seg->refs.compare_exchange_strong(refs, 0)) {
+                recycle(seg);
+            }
+        }
+
+        Segment* allocate() {
+            if (!free_lock.exchange(true, std::memory_order_acquire)) {
+                Segment* seg = free_list.load();
+                while (seg != nullptr
+                       && !free_list.compare_exchange_weak(seg,
+                                                           seg->free_next)) {
+                    // Do Nothing
+                }
+                free_lock.store(false, std::memory_order_release);
+
+                if (seg != nullptr) {
+                    seg->reset();
+                    return seg;
+                }
+            }
+
+            Segment* seg = seg_traits::allocate(seg_alloc, 1);
+            try {
+                seg_traits::construct(seg_alloc, seg);
+            }
+            catch (...) {
+                seg_traits::deallocate(seg_alloc, seg, 1);
+                throw;
+            }
+            return seg;
+        }
+
+        // stale threads may still count on it, so it is never freed
+        // before the queue, see Segment
+        void recycle(Segment* seg) {
+            Segment* top = free_list.load();
+            do {
+                seg->free_next = top;
+            } while (!free_list.compare_exchange_weak(top, seg));
+        }
+
+        void deallocate(Segment* seg) {
+            seg_traits::destroy(seg_alloc, seg);
+            seg_traits::deallocate(seg_alloc, seg, 1);
+        }
+
+        void destroy(Slot& slot) {
+            traits::destroy(alloc, slot.ptr());
+        }
+    };
+}  // namespace LockFree
+
+
+// Observer of channel readiness, see Selector.
+class ChannelWatcher {
+public:
+    virtual void Notify(size_t key) = 0;
+
+protected:
+    ~ChannelWatcher() = default;
+};
+
+template <typename Container>
+class Channel {
+public:
+    using value_type = typename Container::value_type;
+    using iterator = ChannelIterator<value_type, Channel<Container>>;
+
+    template <typename... U>
+    Channel(U&&... args)
+        : buffer(std::forward<U>(args)...), watcher(nullptr), notifying(0),
+          watch_key(0) {
+        // Do Nothing
+    }
+
+    Channel(Channel const&) = delete;
+    Channel(Channel&&) = delete;
+
+    Channel& operator=(const Channel&) = delete;
+    Channel& operator=(Channel&&) = delete;
+
+    template <typename... U>
+    void Add(U&&... args) {
+        buffer.emplace_back(std::forward<U>(args)...);
+        notify_watcher();
+    }
+
+    // Add range in one step, requires push_back_range from container,
+    // e.g. ThreadSafe. Returns number added, less only if closed.
+    template <typename It>
+    size_t AddBulk(It first, It last) {
+        size_t added = buffer.push_back_range(first, last);
+        if (added > 0) {
+            notify_watcher();
+        }
+        return added;
+    }
+
+    // return false instead of blocking if channel is full or closed
+    template <typename... U>
+    bool TryAdd(U&&... args) {
+        bool added = buffer.try_emplace_back(std::forward<U>(args)...);
+        if (added) {
+            notify_watcher();
+        }
+        return added;
+    }
+
+    template <typename Rep, typename Period, typename... U>
+    bool AddFor(std::chrono::duration<Rep, Period> const& timeout,
+                U&&... args) {
+        return AddUntil(std::chrono::steady_clock::now() + timeout,
+                        std::forward<U>(args)...);
+    }
+
+    template <typename Clock, typename Duration, typename... U>
+    bool AddUntil(std::chrono::time_point<Clock, Duration> const& time,
+                  U&&... args) {
+        bool added =
+            buffer.emplace_back_until(time, std::forward<U>(args)...);
+        if (added) {
+            notify_watcher();
+        }
+        return added;
+    }
+
+    auto Reserve() {
+        return buffer.reserve_back();
+    }
+
+    template <typename R>
+    void Commit(R& slot) {
+        slot.commit();
+        notify_watcher();
+    }
+
+    template <typename U>
+    Channel& operator<<(U&& task) {
+        Add(std::forward<U>(task));
+        return *this;
+    }
+
+    std::optional<value_type> Get() {
+        return buffer.pop_front();
+    }
+
+    std::optional<value_type> TryGet() {
+        return buffer.try_pop();
+    }
+
+    template <typename Rep, typename Period>
+    std::optional<value_type> GetFor(
+        std::chrono::duration<Rep, Period> const& timeout) {
+        return GetUntil(std::chrono::steady_clock::now() + timeout);
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> GetUntil(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        return buffer.pop_front_until(time);
+    }
+
+    template <typename F>
+    bool Consume(F&& func) {
+        return buffer.consume_front(std::forward<F>(func));
+    }
+
+    Channel& operator>>(std::optional<value_type>& get) {
+        get = Get();
+        return *this;
+    }
+
+    Channel& operator>>(value_type& get) {
+        std::optional<value_type> res = Get();
+        if (res.has_value()) {
+            get = std::move(res.value());
+        }
+        return *this;
+    }
+
+    void Close() {
+        buffer.close();
+        notify_watcher();
+    }
+
+    bool Runnable() const {
+        return buffer.runnable();
+    }
+
+    bool Readable() {
+        return buffer.readable();
+    }
+
+    iterator begin() {
+        return iterator(*this, Get());
+    }
+
+    iterator end() {
+        return iterator(*this, std::nullopt);
+    }
+
+    // notify watcher with key after each add and close, one at a time
+    void Watch(ChannelWatcher* given, size_t key) {
+        watch_key = key;
+        watcher = given;
+    }
+
+    // waits notification in flight, so watcher could be released after
+    void Unwatch() {
+        watcher = nullptr;
+        while (notifying > 0) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    Container buffer;
+
+    std::atomic<ChannelWatcher*> watcher;
+    std::atomic<size_t> notifying;
+    size_t watch_key;
+
+    // unwatched channel pays a single load
+    void notify_watcher() {
+        if (watcher.load(std::memory_order_relaxed) == nullptr) {
+            return;
+        }
+
+        ++notifying;
+        if (ChannelWatcher* given = watcher.load()) {
+            given->Notify(watch_key);
+        }
+        --notifying;
+    }
+};
+
+template <typename T>
+using LChannel = Channel<TSList<T>>;
+
+template <typename T>
+using RChannel = Channel<TSRingBuffer<T>>;
+
+template <typename T>
+using ShardedChannel = Channel<ShardedQueue<T>>;
+
+template <typename T>
+using MpscChannel = Channel<LockFree::MpscQueue<T>>;
+
+template <typename T>
+using SegmentChannel = Channel<LockFree::SegmentQueue<T>>;
+
+
+template <typename Pool>
+class BlockingRegion;
+
+// Futures of tasks submitted at once, with completion of whole batch,
+// so fan out waits on single latch instead of each future.
+template <typename T>
+class TaskBatch {
+public:
+    TaskBatch(std::vector<std::future<T>>&& futures,
+              std::shared_ptr<Latch> done)
+        : futures(std::move(futures)), done(std::move(done)) {
+        // Do Nothing
+    }
+
+    TaskBatch(TaskBatch const&) = delete;
+    TaskBatch(TaskBatch&&) = default;
+
+    TaskBatch& operator=(TaskBatch const&) = delete;
+    TaskBatch& operator=(TaskBatch&&) = default;
+
+    // in order of submission, exception of task is thrown from its future
+    std::vector<std::future<T>>& Futures() {
+        return futures;
+    }
+
+    // true once every task has run
+    bool Ready() const {
+        return done->TryWait();
+    }
+
+    // wait every task, results are ready after it
+    void Wait() {
+        done->Wait();
+        for (auto& fut : futures) {
+            fut.wait();
+        }
+    }
+
+    size_t Size() const {
+        return futures.size();
+    }
+
+private:
+    std::vector<std::future<T>> futures;
+    std::shared_ptr<Latch> done;
+};
+
+template <typename T,
+          template <typename> class ChannelType = RChannel>
+class ThreadPool {
+public:
+    ThreadPool() : ThreadPool(std::thread::hardware_concurrency()) {
+        // Do Nothing
+    }
+
+    template <typename... Args>
+    ThreadPool(size_t num_threads, Args&&... args)
+        : runnable(true), num_threads(num_threads),
+          channel(std::forward<Args>(args)...),
+          threads(std::make_unique<std::thread[]>(num_threads)),
+          num_blocking(0), num_extra(0), num_alive(0) {
+        for (size_t i = 0; i < num_threads; ++i) {
+            threads[i] = std::thread([this] { work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        Stop();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    template <typename F>
+    std::future<T> Add(F&& task) {
+        std::packaged_task<T()> ptask(Trace::task(std::forward<F>(task)));
+        std::future<T> fut = ptask.get_future();
+        channel.Add(std::move(ptask));
+        return fut;
+    }
+
+    // Add tasks of forward range with one lock of queue, only as many
+    // idle workers as tasks are waked. Tasks are copied from range,
+    // pass move iterators to move them.
+    template <typename It>
+    TaskBatch<T> AddBulk(It first, It last) {
+        auto done = std::make_shared<Latch>(std::distance(first, last));
+
+        std::vector<std::packaged_task<T()>> tasks;
+        tasks.reserve(std::distance(first, last));
+        for (; first != last; ++first) {
+            tasks.emplace_back(Trace::task(arrive(done, *first)));
+        }
+        return submit(tasks, std::move(done));
+    }
+
+    // Add func(i) for i in [0, n) as AddBulk, func is shared by tasks.
+    template <typename F>
+    TaskBatch<T> AddN(size_t n, F&& func) {
+        auto shared = std::make_shared<std::decay_t<F>>(std::forward<F>(func));
+        auto done = std::make_shared<Latch>(n);
+
+        std::vector<std::packaged_task<T()>> tasks;
+        tasks.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            tasks.emplace_back(Trace::task(
+                arrive(done, [shared, i] { return (*shared)(i); })));
+        }
+        return submit(tasks, std::move(done));
+    }
+
+    // Run func which blocks on I/O or another channel. If caller is worker,
+    // compensating worker is spawned to keep pool busy until it returns.
+    template <typename F>
+    decltype(auto) Blocking(F&& func) {
+        BlockingRegion region(*this);
+        return std::forward<F>(func)();
+    }
+
+    // Run queued tasks in the caller until fut is ready, so worker
+    // waiting on its subtask does not hold a thread away from it.
+    template <typename U>
+    U Await(std::future<U> fut) {
+        while (fut.wait_for(std::chrono::seconds(0))
+               != std::future_status::ready) {
+            auto given = channel.TryGet();
+            if (given.has_value()) {
+                given.value()();
+            }
+            else {
+                fut.wait_for(help_interval);
+            }
+        }
+        return fut.get();
+    }
+
+    // only for workers, other threads are not counted in pool
+    void EnterBlocking() {
+        if (current != this) {
+            return;
+        }
+
+        std::unique_lock lock(mutex);
+        ++num_blocking;
+        if (!runnable || num_extra >= num_blocking
+            || num_alive >= max_extra) {
+            return;
+        }
+
+        // compensation is best effort, blocking call runs anyway
+        try {
+            std::thread(&ThreadPool::work_extra, this).detach();
+            ++num_extra;
+            ++num_alive;
+        }
+        catch (std::system_error const&) {
+            // Do Nothing
+        }
+    }
+
+    void LeaveBlocking() {
+        if (current == this) {
+            std::unique_lock lock(mutex);
+            --num_blocking;
+        }
+    }
+
+    size_t GetNumThreads() const {
+        return num_threads;
+    }
+
+    void Stop() {
+        if (threads != nullptr) {
+            std::unique_lock lock(mutex);
+            runnable = false;
+            lock.unlock();
+            channel.Close();
+
+            for (size_t i = 0; i < num_threads; ++i) {
+                if (threads[i].joinable()) {
+                    threads[i].join();
+                }
+            }
+            threads.reset();
+
+            lock.lock();
+            cond.wait(lock, [&] { return num_alive == 0; });
+        }
+    }
+
+private:
+    // upper bound of compensating workers alive at once
+    static constexpr size_t max_extra = 256;
+    // how long idle compensating worker waits before it checks to retire
+    static constexpr std::chrono::milliseconds idle_interval{ 10 };
+    // how long Await sleeps on future before it looks at queue again
+    static constexpr std::chrono::microseconds help_interval{ 100 };
+
+    // pool which runs on this thread, nullptr for non worker
+    static inline thread_local ThreadPool* current = nullptr;
+
+    std::atomic<bool> runnable;
+    size_t num_threads;
+
+    ChannelType<std::packaged_task<T()>> channel;
+    std::unique_ptr<std::thread[]> threads;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t num_blocking;
+    // compensating workers not yet retired, and all alive ones
+    size_t num_extra;
+    size_t num_alive;
+
+    void work() {
+        current = this;
+        while (runnable) {
+            auto given = channel.Get();
+            if (!given.has_value()) {
+                break;
+            }
+            given.value()();
+        }
+    }
+
+    // retire as soon as there are more compensating workers than blocked
+    void work_extra() {
+        current = this;
+        while (runnable && !retire()) {
+            auto given = channel.GetFor(idle_interval);
+            if (given.has_value()) {
+                given.value()();
+            }
+            else if (!channel.Readable()) {
+                break;
+            }
+        }
+
+        // notified after thread locals are destroyed, so Stop could
+        // release pool right after it
+        std::unique_lock lock(mutex);
+        --num_alive;
+        std::notify_all_at_thread_exit(cond, std::move(lock));
+    }
+
+    bool retire() {
+        std::unique_lock lock(mutex);
+        if (num_extra > num_blocking) {
+            --num_extra;
+            return true;
+        }
+        return false;
+    }
+
+    struct Arrival {
+        Latch& latch;
+
+        ~Arrival() {
+            latch.CountDown();
+        }
+    };
+
+    // count down latch of batch after task, even if it throws
+    template <typename F>
+    static auto arrive(std::shared_ptr<Latch> const& done, F&& func) {
+        return [done, func = std::forward<F>(func)]() mutable -> T {
+            Arrival arrival{ *done };
+            return func();
+        };
+    }
+
+    TaskBatch<T> submit(std::vector<std::packaged_task<T()>>& tasks,
+                        std::shared_ptr<Latch> done) {
+        std::vector<std::future<T>> futures;
+        futures.reserve(tasks.size());
+        for (auto& task : tasks) {
+            futures.push_back(task.get_future());
+        }
+
+        // tasks dropped by closed pool never run, their futures are broken
+        size_t added = channel.AddBulk(std::make_move_iterator(tasks.begin()),
+                                       std::make_move_iterator(tasks.end()));
+        if (added < tasks.size()) {
+            done->CountDown(tasks.size() - added);
+        }
+        return TaskBatch<T>(std::move(futures), std::move(done));
+    }
+};
+
+// Mark the scope where worker of the pool blocks, see ThreadPool::Blocking.
+template <typename Pool>
+class BlockingRegion {
+public:
+    BlockingRegion(Pool& pool) : pool(pool) {
+        pool.EnterBlocking();
+    }
+
+    ~BlockingRegion() {
+        pool.LeaveBlocking();
+    }
+
+    BlockingRegion(BlockingRegion const&) = delete;
+    BlockingRegion(BlockingRegion&&) = delete;
+
+    BlockingRegion& operator=(BlockingRegion const&) = delete;
+    BlockingRegion& operator=(BlockingRegion&&) = delete;
+
+private:
+    Pool& pool;
+};
+
+template <typename T>
+using LThreadPool = ThreadPool<T, LChannel>;
+
+// Pool whose workers own their inbox, tasks are spread round robin or
+// pinned to a worker with AddTo. Inbox has single consumer,
+// so it is MPSC queue which pops without compare exchange.
+template <typename T>
+class InboxThreadPool {
+public:
+    using inbox_type = MpscChannel<std::packaged_task<T()>>;
+
+    InboxThreadPool()
+        : InboxThreadPool(std::max(1u, std::thread::hardware_concurrency())) {
+        // Do Nothing
+    }
+
+    InboxThreadPool(size_t num_threads)
+        : num_threads(std::max<size_t>(num_threads, 1)), next(0),
+          inboxes(std::make_unique<inbox_type[]>(this->num_threads)),
+          threads(std::make_unique<std::thread[]>(this->num_threads)) {
+        for (size_t i = 0; i < this->num_threads; ++i) {
+            threads[i] = std::thread([this, i] {
+                for (auto& task : inboxes[i]) {
+                    task();
+                }
+            });
+        }
+    }
+
+    ~InboxThreadPool() {
+        Stop();
+    }
+
+    InboxThreadPool(const InboxThreadPool&) = delete;
+    InboxThreadPool(InboxThreadPool&&) = delete;
+
+    InboxThreadPool& operator=(const InboxThreadPool&) = delete;
+    InboxThreadPool& operator=(InboxThreadPool&&) = delete;
+
+    template <typename F>
+    std::future<T> Add(F&& task) {
+        size_t worker = next.fetch_add(1, std::memory_order_relaxed);
+        return AddTo(worker % num_threads, std::forward<F>(task));
+    }
+
+    // tasks pinned to the same worker run in order of submission
+    template <typename F>
+    std::future<T> AddTo(size_t worker, F&& task) {
+        std::packaged_task<T()> ptask(Trace::task(std::forward<F>(task)));
+        std::future<T> fut = ptask.get_future();
+        inboxes[worker % num_threads].Add(std::move(ptask));
+        return fut;
+    }
+
+    size_t GetNumThreads() const {
+        return num_threads;
+    }
+
+    // pending tasks are still run before workers exit
+    void Stop() {
+        if (threads != nullptr) {
+            for (size_t i = 0; i < num_threads; ++i) {
+                inboxes[i].Close();
+            }
+
+            for (size_t i = 0; i < num_threads; ++i) {
+                if (threads[i].joinable()) {
+                    threads[i].join();
+                }
+            }
+            threads.reset();
+        }
+    }
+
+private:
+    size_t num_threads;
+    std::atomic<size_t> next;
+
+    std::unique_ptr<inbox_type[]> inboxes;
+    std::unique_ptr<std::thread[]> threads;
+};
+
+
+// Mailbox with behavior, scheduled onto shared pool only if it has messages.
+// Single activation runs at a time and handles up to batch_size messages,
+// so behavior needs no lock and many actors share few threads.
+// Pool should outlive the actor and the messages sent to it.
+template <typename Msg, typename Pool = ThreadPool<void>>
+class Actor {
+public:
+    template <typename F>
+    Actor(Pool& pool, F&& behavior, size_t batch_size = 64)
+        : state(std::make_shared<State>(
+            pool, std::forward<F>(behavior), batch_size)) {
+        // Do Nothing
+    }
+
+    // stop accepting, pending messages are still handled
+    ~Actor() {
+        Close();
+    }
+
+    Actor(Actor const&) = delete;
+    Actor(Actor&&) = default;
+
+    Actor& operator=(Actor const&) = delete;
+    Actor& operator=(Actor&&) = default;
+
+    template <typename... U>
+    bool Send(U&&... args) {
+        return state->send(std::forward<U>(args)...);
+    }
+
+    template <typename U>
+    Actor& operator<<(U&& msg) {
+        Send(std::forward<U>(msg));
+        return *this;
+    }
+
+    void Close() {
+        if (state != nullptr) {
+            state->runnable = false;
+        }
+    }
+
+    bool Runnable() const {
+        return state->runnable;
+    }
+
+    size_t Pending() const {
+        return state->pending;
+    }
+
+    // wait until mailbox is drained, rethrow first failure of behavior
+    void Wait() {
+        state->wait();
+    }
+
+private:
+    struct State : std::enable_shared_from_this<State> {
+        Pool& pool;
+        std::function<void(Msg&)> behavior;
+        size_t batch_size;
+
+        LockFree::MpscQueue<Msg, Policy::Spin> mailbox;
+        std::atomic<bool> runnable;
+
+        // sender publishes pending before it looks at scheduled,
+        // activation clears scheduled before it looks at pending
+        std::atomic<size_t> pending;
+        std::atomic<bool> scheduled;
+
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::exception_ptr error;
+
+        template <typename F>
+        State(Pool& pool, F&& behavior, size_t batch_size)
+            : pool(pool), behavior(std::forward<F>(behavior)),
+              batch_size(std::max<size_t>(batch_size, 1)), runnable(true),
+              pending(0), scheduled(false) {
+            // Do Nothing
+        }
+
+        template <typename... U>
+        bool send(U&&... args) {
+            if (!runnable
+                || !mailbox.try_emplace_back(std::forward<U>(args)...)) {
+                return false;
+            }
+
+            ++pending;
+            if (!scheduled.exchange(true)) {
+                schedule();
+            }
+            return true;
+        }
+
+        void schedule() {
+            pool.Add([self = this->shared_from_this()] { self->run(); });
+        }
+
+        void run() {
+            for (size_t i = 0; i < batch_size && pending > 0; ++i) {
+                try {
+                    mailbox.consume_front(behavior);
+                }
+                catch (...) {
+                    std::unique_lock lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                --pending;
+            }
+
+            // requeue behind other actors instead of holding the worker
+            if (pending > 0) {
+                schedule();
+                return;
+            }
+
+            scheduled = false;
+            if (pending > 0 && !scheduled.exchange(true)) {
+                schedule();
+                return;
+            }
+
+            std::unique_lock lock(mutex);
+            cond.notify_all();
+        }
+
+        void wait() {
+            std::unique_lock lock(mutex);
+            cond.wait(lock, [&] { return pending == 0 && !scheduled; });
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+
+    std::shared_ptr<State> state;
+};
+
+
+// Bounded queue on ring of sequenced cells, sequence of a cell tells
+// whether it is free or published, so producers and consumers share no lock.
+// Single producer or consumer side moves its index without compare exchange.
+template <typename T,
+          typename Producers = Policy::Multi,
+          typename Consumers = Policy::Multi,
+          typename Wait = Policy::Park,
+          typename Alloc = std::allocator<T>>
+class BoundedQueue {
+public:
+    using value_type = T;
+
+    BoundedQueue(size_t size_buffer, Alloc const& alloc = Alloc())
+        : alloc(alloc), size_buffer(std::max<size_t>(size_buffer, 1)),
+          cells(cell_traits::allocate(this->alloc, this->size_buffer)),
+          m_runnable(true), head(0), tail(0) {
+        for (size_t i = 0; i < this->size_buffer; ++i) {
+            cell_traits::construct(this->alloc, cells + i);
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~BoundedQueue() {
+        close();
+        while (dequeue([](T&) {}))
+            ;
+
+        for (size_t i = 0; i < size_buffer; ++i) {
+            cell_traits::destroy(alloc, cells + i);
+        }
+        cell_traits::deallocate(alloc, cells, size_buffer);
+    }
+
+    BoundedQueue(BoundedQueue const&) = delete;
+    BoundedQueue(BoundedQueue&&) = delete;
+
+    BoundedQueue& operator=(BoundedQueue const&) = delete;
+    BoundedQueue& operator=(BoundedQueue&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        waiter.wait([&] {
+            return !m_runnable || enqueue(std::forward<U>(args)...);
+        });
+        waiter.notify();
+    }
+
+    void push_back(value_type const& value) {
+        emplace_back(value);
+    }
+
+    void push_back(value_type&& value) {
+        emplace_back(std::move(value));
+    }
+
+    template <typename... U>
+    bool try_emplace_back(U&&... args) {
+        if (!m_runnable || !enqueue(std::forward<U>(args)...)) {
+            return false;
+        }
+        waiter.notify();
+        return true;
+    }
+
+    template <typename Clock, typename Duration, typename... U>
+    bool emplace_back_until(
+        std::chrono::time_point<Clock, Duration> const& time, U&&... args) {
+        bool pushed = false;
+        waiter.wait_until(time, [&] {
+            if (!m_runnable) {
+                return true;
+            }
+            pushed = enqueue(std::forward<U>(args)...);
+            return pushed;
+        });
+
+        if (pushed) {
+            waiter.notify();
+        }
+        return pushed;
+    }
+
+    std::optional<value_type> pop_front() {
+        std::optional<value_type> given;
+        consume_front([&](value_type& item) { given = std::move(item); });
+        return given;
+    }
+
+    std::optional<value_type> try_pop() {
+        std::optional<value_type> given;
+        if (dequeue([&](value_type& item) { given = std::move(item); })) {
+            waiter.notify();
+        }
+        return given;
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> pop_front_until(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        std::optional<value_type> given;
+        auto take = [&](value_type& item) { given = std::move(item); };
+
+        bool consumed = false;
+        waiter.wait_until(time, [&] {
+            consumed = dequeue(take);
+            return consumed || !m_runnable;
+        });
+
+        if (consumed || dequeue(take)) {
+            waiter.notify();
+        }
+        return given;
+    }
+
+    // after close, items published before it are still consumed
+    template <typename F>
+    bool consume_front(F&& func) {
+        bool consumed = false;
+        waiter.wait([&] {
+            consumed = dequeue(func);
+            return consumed || !m_runnable;
+        });
+
+        if (!consumed) {
+            consumed = dequeue(func);
+        }
+        if (consumed) {
+            waiter.notify();
+        }
+        return consumed;
+    }
+
+    void close() {
+        m_runnable = false;
+        waiter.notify();
+    }
+
+    bool runnable() const {
+        return m_runnable;
+    }
+
+    bool readable() {
+        return m_runnable || size() > 0;
+    }
+
+    size_t size() const {
+        size_t popped = head.load();
+        size_t pushed = tail.load();
+        return pushed > popped ? pushed - popped : 0;
+    }
+
+    size_t max_size() const {
+        return size_buffer;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* get() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    using cell_alloc =
+        typename std::allocator_traits<Alloc>::template rebind_alloc<Cell>;
+    using cell_traits = std::allocator_traits<cell_alloc>;
+
+    static constexpr bool single_producer =
+        std::is_same_v<Producers, Policy::Single>;
+    static constexpr bool single_consumer =
+        std::is_same_v<Consumers, Policy::Single>;
+
+    cell_alloc alloc;
+    size_t size_buffer;
+    Cell* cells;
+
+    std::atomic<bool> m_runnable;
+    Wait waiter;
+
+    alignas(platform::cache_line) std::atomic<size_t> head;
+    alignas(platform::cache_line) std::atomic<size_t> tail;
+
+    // claim index of cell whose sequence is expected, false if not ready
+    template <bool single>
+    bool claim(std::atomic<size_t>& index, size_t offset, size_t& pos) {
+        pos = index.load(std::memory_order_relaxed);
+        while (true) {
+            size_t seq = cells[pos % size_buffer].sequence.load(
+                std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - (pos + offset));
+
+            if (diff < 0) {
+                return false;
+            }
+            if (diff > 0) {
+                pos = index.load(std::memory_order_relaxed);
+            }
+            else if constexpr (single) {
+                index.store(pos + 1, std::memory_order_relaxed);
+                return true;
+            }
+            else if (index.compare_exchange_weak(
+                         pos, pos + 1, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    // waiter may run enqueue and dequeue under its own lock,
+    // so they never notify and callers do it after the wait
+    template <typename... U>
+    bool enqueue(U&&... args) {
+        size_t pos;
+        if (!claim<single_producer>(tail, 0, pos)) {
+            return false;
+        }
+
+        Cell& cell = cells[pos % size_buffer];
+        new (cell.storage) T(std::forward<U>(args)...);
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename F>
+    bool dequeue(F&& func) {
+        size_t pos;
+        if (!claim<single_consumer>(head, 1, pos)) {
+            return false;
+        }
+
+        Cell& cell = cells[pos % size_buffer];
+        try {
+            func(*cell.get());
+        }
+        catch (...) {
+            release(cell, pos);
+            throw;
+        }
+        release(cell, pos);
+        return true;
+    }
+
+    void release(Cell& cell, size_t pos) {
+        cell.get()->~T();
+        cell.sequence.store(pos + size_buffer, std::memory_order_release);
+    }
+};
+
+
+// Read copy update domain. Readers only count themselves in a lane of
+// the current epoch parity, so read side is wait free and scales.
+// Writers unlink old versions and retire them, retired ones are freed
+// in batches after every reader present at retirement has left.
+class RcuDomain {
+public:
+    RcuDomain()
+        : RcuDomain(std::max(1u, std::thread::hardware_concurrency())) {
+        // Do Nothing
+    }
+
+    // lanes are rounded up to power of two
+    RcuDomain(size_t num_lanes)
+        : num_lanes(ceil_pow2(num_lanes)),
+          lanes(std::make_unique<Lane[]>(this->num_lanes)), epoch(0) {
+        // Do Nothing
+    }
+
+    // no reader should be left
+    ~RcuDomain() {
+        for (size_t lane = 0; lane < num_lanes; ++lane) {
+            for (Retired& retired : lanes[lane].pending) {
+                retired.deleter(retired.ptr);
+            }
+        }
+    }
+
+    RcuDomain(RcuDomain const&) = delete;
+    RcuDomain(RcuDomain&&) = delete;
+
+    RcuDomain& operator=(RcuDomain const&) = delete;
+    RcuDomain& operator=(RcuDomain&&) = delete;
+
+    // Token for ReadUnlock, read sections may nest.
+    // Fence pairs with Synchronize, so either writer sees this reader
+    // or reader sees what writer has unlinked before.
+    size_t ReadLock() {
+        size_t lane = platform::thread_hash() & (num_lanes - 1);
+        size_t parity = epoch.load(std::memory_order_relaxed) & 1;
+        lanes[lane].readers[parity].fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return lane * 2 + parity;
+    }
+
+    void ReadUnlock(size_t token) {
+        lanes[token / 2].readers[token % 2].fetch_sub(
+            1, std::memory_order_release);
+    }
+
+    // Wait for readers present at the call, not from read section.
+    // Epoch flips twice, so reader which took the parity just before
+    // a flip is waited too.
+    void Synchronize() {
+        std::unique_lock lock(sync_mutex);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (size_t flip = 0; flip < 2; ++flip) {
+            size_t parity = epoch.fetch_add(1) & 1;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (size_t lane = 0; lane < num_lanes; ++lane) {
+                std::atomic<size_t>& readers = lanes[lane].readers[parity];
+                while (readers.load(std::memory_order_acquire) > 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    // Free after grace period, batched per lane to amortize Synchronize,
+    // so it should not be called from read section either.
+    template <typename T>
+    void Retire(T* ptr) {
+        Retire(ptr, [](void* given) { delete static_cast<T*>(given); });
+    }
+
+    void Retire(void* ptr, void (*deleter)(void*)) {
+        Lane& lane = lanes[platform::thread_hash() & (num_lanes - 1)];
+
+        std::vector<Retired> batch;
+        {
+            std::unique_lock lock(lane.retire_mutex);
+            lane.pending.push_back(Retired{ ptr, deleter });
+            if (lane.pending.size() < batch_size) {
+                return;
+            }
+            batch.swap(lane.pending);
+        }
+
+        Synchronize();
+        for (Retired& retired : batch) {
+            retired.deleter(retired.ptr);
+        }
+    }
+
+private:
+    static constexpr size_t batch_size = 128;
+
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+    };
+
+    struct alignas(platform::cache_line) Lane {
+        std::atomic<size_t> readers[2] = { 0, 0 };
+
+        alignas(platform::cache_line) std::mutex retire_mutex;
+        std::vector<Retired> pending;
+    };
+
+    size_t num_lanes;
+    std::unique_ptr<Lane[]> lanes;
+
+    alignas(platform::cache_line) std::atomic<size_t> epoch;
+    std::mutex sync_mutex;
+
+    static size_t ceil_pow2(size_t value) {
+        size_t pow = 1;
+        while (pow < value) {
+            pow <<= 1;
+        }
+        return pow;
+    }
+};
+
+// RAII read section of domain.
+class RcuReadGuard {
+public:
+    RcuReadGuard(RcuDomain& domain)
+        : domain(domain), token(domain.ReadLock()) {
+        // Do Nothing
+    }
+
+    ~RcuReadGuard() {
+        domain.ReadUnlock(token);
+    }
+
+    RcuReadGuard(RcuReadGuard const&) = delete;
+    RcuReadGuard(RcuReadGuard&&) = delete;
+
+    RcuReadGuard& operator=(RcuReadGuard const&) = delete;
+    RcuReadGuard& operator=(RcuReadGuard&&) = delete;
+
+private:
+    RcuDomain& domain;
+    size_t token;
+};
+
+// Cell of read mostly value. Readers get snapshot of current version
+// with no lock or retry, writers publish new version and retire old one
+// to the domain, which frees it once no reader may hold it.
+template <typename T>
+class RcuCell {
+public:
+    template <typename... U>
+    RcuCell(U&&... args) : current(new T(std::forward<U>(args)...)) {
+        // Do Nothing
+    }
+
+    ~RcuCell() {
+        delete current.load();
+    }
+
+    RcuCell(RcuCell const&) = delete;
+    RcuCell(RcuCell&&) = delete;
+
+    RcuCell& operator=(RcuCell const&) = delete;
+    RcuCell& operator=(RcuCell&&) = delete;
+
+    // func gets snapshot, which stays alive until it returns
+    template <typename F>
+    decltype(auto) read(F&& func) {
+        RcuReadGuard guard(domain);
+        return func(std::as_const(*current.load(std::memory_order_acquire)));
+    }
+
+    T load() {
+        return read([](T const& value) { return value; });
+    }
+
+    template <typename... U>
+    void store(U&&... args) {
+        T* old = nullptr;
+        {
+            auto fresh = std::make_unique<T>(std::forward<U>(args)...);
+            std::unique_lock lock(writer);
+            old = current.exchange(fresh.release(), std::memory_order_acq_rel);
+        }
+        domain.Retire(old);
+    }
+
+    // Copy, modify and publish. Writers are serialized, so concurrent
+    // updates are not lost, readers are not blocked.
+    template <typename F>
+    void update(F&& func) {
+        T* old = nullptr;
+        {
+            std::unique_lock lock(writer);
+            auto fresh =
+                std::make_unique<T>(*current.load(std::memory_order_relaxed));
+            func(*fresh);
+            old = current.exchange(fresh.release(), std::memory_order_acq_rel);
+        }
+        domain.Retire(old);
+    }
+
+private:
+    std::atomic<T*> current;
+    std::mutex writer;
+    RcuDomain domain;
+};
+
+
+// Hash map with lock free reads and lock striped writes.
+// Buckets are chains of immutable nodes, writers replace or unlink
+// nodes under the lock of bucket stripe and retire old ones to rcu
+// domain, so readers walk chains without any lock or retry.
+// Stripe of a bucket stays the same across rehash, rehash takes all
+// stripes and publishes copied table while readers keep the old one.
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class ConcurrentHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+
+    ConcurrentHashMap()
+        : ConcurrentHashMap(0) {
+        // Do Nothing
+    }
+
+    ConcurrentHashMap(size_t capacity,
+                      Hash const& hash = Hash(),
+                      KeyEqual const& equal = KeyEqual())
+        : hasher(hash), equal(equal),
+          num_stripes(ceil_pow2(
+              4 * std::max(1u, std::thread::hardware_concurrency()))),
+          stripes(std::make_unique<Stripe[]>(num_stripes)),
+          table(new Table(std::max(num_stripes, ceil_pow2(capacity)))) {
+        // Do Nothing
+    }
+
+    ~ConcurrentHashMap() {
+        delete table.load();
+    }
+
+    ConcurrentHashMap(ConcurrentHashMap const&) = delete;
+    ConcurrentHashMap(ConcurrentHashMap&&) = delete;
+
+    ConcurrentHashMap& operator=(ConcurrentHashMap const&) = delete;
+    ConcurrentHashMap& operator=(ConcurrentHashMap&&) = delete;
+
+    std::optional<mapped_type> find(key_type const& key) {
+        std::optional<mapped_type> given;
+        visit(key, [&](mapped_type const& value) { given = value; });
+        return given;
+    }
+
+    bool contains(key_type const& key) {
+        return visit(key, [](mapped_type const&) {});
+    }
+
+    // call func with value in place instead of copying it out,
+    // value may be replaced meanwhile but stays alive during func
+    template <typename F>
+    bool visit(key_type const& key, F&& func) {
+        size_t hash = hash_of(key);
+
+        RcuReadGuard guard(domain);
+        Table* current = table.load(std::memory_order_acquire);
+        Node* node = current->bucket(hash).load(std::memory_order_acquire);
+        for (; node != nullptr;
+             node = node->next.load(std::memory_order_acquire)) {
+            if (node->hash == hash && equal(node->key, key)) {
+                func(node->value);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // true if inserted, false if assigned
+    template <typename V>
+    bool insert_or_assign(key_type const& key, V&& value) {
+        size_t hash = hash_of(key);
+        Stripe& stripe = stripe_of(hash);
+
+        Node* old = nullptr;
+        {
+            std::unique_lock lock(stripe.mutex);
+            std::atomic<Node*>* link = nullptr;
+            old = locate(hash, key, link);
+
+            Node* node = new Node(hash, key, std::forward<V>(value));
+            if (old != nullptr) {
+                node->next.store(old->next.load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+                link->store(node, std::memory_order_release);
+            }
+            else {
+                node->next.store(link->load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+                link->store(node, std::memory_order_release);
+                ++stripe.size;
+            }
+        }
+
+        if (old != nullptr) {
+            domain.Retire(old);
+            return false;
+        }
+        grow(stripe);
+        return true;
+    }
+
+    // insert value made by func(key) if absent, func runs under lock
+    // so it is called once per key, returns value in the map
+    template <typename F>
+    mapped_type compute_if_absent(key_type const& key, F&& func) {
+        std::optional<mapped_type> given = find(key);
+        if (given.has_value()) {
+            return std::move(given.value());
+        }
+
+        size_t hash = hash_of(key);
+        Stripe& stripe = stripe_of(hash);
+        {
+            std::unique_lock lock(stripe.mutex);
+            std::atomic<Node*>* link = nullptr;
+            Node* old = locate(hash, key, link);
+            if (old != nullptr) {
+                return old->value;
+            }
+
+            Node* node = new Node(hash, key, func(key));
+            node->next.store(link->load(std::memory_order_relaxed),
+                             std::memory_order_relaxed);
+            link->store(node, std::memory_order_release);
+            ++stripe.size;
+
+            given.emplace(node->value);
+        }
+
+        grow(stripe);
+        return std::move(given.value());
+    }
+
+    bool erase(key_type const& key) {
+        size_t hash = hash_of(key);
+        Stripe& stripe = stripe_of(hash);
+
+        Node* old = nullptr;
+        {
+            std::unique_lock lock(stripe.mutex);
+            std::atomic<Node*>* link = nullptr;
+            old = locate(hash, key, link);
+            if (old == nullptr) {
+                return false;
+            }
+
+            link->store(old->next.load(std::memory_order_relaxed),
+                        std::memory_order_release);
+            --stripe.size;
+        }
+
+        domain.Retire(old);
+        return true;
+    }
+
+    // snapshot of each bucket, not of whole map
+    template <typename F>
+    void for_each(F&& func) {
+        RcuReadGuard guard(domain);
+        Table* current = table.load(std::memory_order_acquire);
+        for (size_t i = 0; i < current->num_buckets; ++i) {
+            Node* node = current->buckets[i].load(std::memory_order_acquire);
+            for (; node != nullptr;
+                 node = node->next.load(std::memory_order_acquire)) {
+                func(node->key, node->value);
+            }
+        }
+    }
+
+    size_t size() const {
+        size_t sum = 0;
+        for (size_t i = 0; i < num_stripes; ++i) {
+            sum += stripes[i].size.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t bucket_count() {
+        RcuReadGuard guard(domain);
+        return table.load(std::memory_order_acquire)->num_buckets;
+    }
+
+    // rehash to at least num_buckets, readers are not blocked
+    void rehash(size_t num_buckets) {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        for (size_t i = 0; i < num_stripes; ++i) {
+            locks.emplace_back(stripes[i].mutex);
+        }
+
+        Table* old = table.load(std::memory_order_relaxed);
+        num_buckets = std::max(num_stripes, ceil_pow2(num_buckets));
+        if (num_buckets == old->num_buckets) {
+            return;
+        }
+
+        // nodes are copied, readers may still walk old chains
+        Table* fresh = new Table(num_buckets);
+        for (size_t i = 0; i < old->num_buckets; ++i) {
+            Node* node = old->buckets[i].load(std::memory_order_relaxed);
+            for (; node != nullptr;
+                 node = node->next.load(std::memory_order_relaxed)) {
+                std::atomic<Node*>& bucket = fresh->bucket(node->hash);
+                Node* copy = new Node(node->hash, node->key, node->value);
+                copy->next.store(bucket.load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+                bucket.store(copy, std::memory_order_relaxed);
+            }
+        }
+        table.store(fresh, std::memory_order_release);
+
+        locks.clear();
+        domain.Retire(old);
+    }
+
+private:
+    // average chain length which triggers rehash
+    static constexpr size_t load_factor = 2;
+
+    struct Node {
+        size_t hash;
+        key_type const key;
+        mapped_type const value;
+        std::atomic<Node*> next;
+
+        template <typename V>
+        Node(size_t hash, key_type const& key, V&& value)
+            : hash(hash), key(key), value(std::forward<V>(value)),
+              next(nullptr) {
+            // Do Nothing
+        }
+    };
+
+    // owns nodes linked in its buckets
+    struct Table {
+        size_t num_buckets;
+        std::unique_ptr<std::atomic<Node*>[]> buckets;
+
+        Table(size_t num_buckets)
+            : num_buckets(num_buckets),
+              buckets(std::make_unique<std::atomic<Node*>[]>(num_buckets)) {
+            for (size_t i = 0; i < num_buckets; ++i) {
+                buckets[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        ~Table() {
+            for (size_t i = 0; i < num_buckets; ++i) {
+                Node* node = buckets[i].load(std::memory_order_relaxed);
+                while (node != nullptr) {
+                    Node* next = node->next.load(std::memory_order_relaxed);
+                    delete node;
+                    node = next;
+                }
+            }
+        }
+
+        std::atomic<Node*>& bucket(size_t hash) {
+            return buckets[hash & (num_buckets - 1)];
+        }
+    };
+
+    struct alignas(platform::cache_line) Stripe {
+        std::mutex mutex;
+        std::atomic<size_t> size = 0;
+    };
+
+    Hash hasher;
+    KeyEqual equal;
+
+    size_t num_stripes;
+    std::unique_ptr<Stripe[]> stripes;
+
+    std::atomic<Table*> table;
+    RcuDomain domain;
+
+    static size_t ceil_pow2(size_t value) {
+        size_t pow = 1;
+        while (pow < value) {
+            pow <<= 1;
+        }
+        return pow;
+    }
+
+    // spread bits, so low bits choosing bucket and stripe are mixed
+    size_t hash_of(key_type const& key) const {
+        constexpr size_t half = sizeof(size_t) * 4;
+
+        size_t hash = hasher(key);
+        hash ^= hash >> half;
+        hash *= static_cast<size_t>(0x9e3779b97f4a7c15ull);
+        hash ^= hash >> half;
+        return hash;
+    }
+
+    // buckets are multiple of stripes, so stripe is kept on rehash
+    Stripe& stripe_of(size_t hash) {
+        return stripes[hash & (num_stripes - 1)];
+    }
+
+    // Node of the key and link pointing to it, or link to insert at.
+    // Caller holds stripe, so table is not replaced meanwhile.
+    Node* locate(size_t hash, key_type const& key, std::atomic<Node*>*& link) {
+        Table* current = table.load(std::memory_order_relaxed);
+        link = &current->bucket(hash);
+        Node* node = link->load(std::memory_order_relaxed);
+        for (; node != nullptr;
+             node = node->next.load(std::memory_order_relaxed)) {
+            if (node->hash == hash && equal(node->key, key)) {
+                return node;
+            }
+            link = &node->next;
+        }
+        link = &current->bucket(hash);
+        return nullptr;
+    }
+
+    // stripe covers 1 / num_stripes of buckets
+    void grow(Stripe& stripe) {
+        size_t num_buckets = bucket_count();
+        if (stripe.size.load(std::memory_order_relaxed) * num_stripes
+            > num_buckets * load_factor) {
+            rehash(num_buckets * 2);
+        }
+    }
+};
+
+
+// File backed queue, written to segment files `path.N` which are rotated
+// when full and removed when consumed. Segment indices of head and tail
+// are kept in `path.meta`, so queue is restored on reopen.
+template <typename T>
+class MappedQueue {
+public:
+    using value_type = T;
+
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "MappedQueue base type must be trivially copyable");
+
+    MappedQueue(std::string const& path,
+                size_t segment_size = 4096,
+                size_t max_segments = 0,
+                size_t sync_every = 0)
+        : path(path), segment_size(segment_size), max_segments(max_segments),
+          sync_every(sync_every), num_commit(0),
+          meta(path + ".meta", sizeof(Header)) {
+        init_header(meta_header());
+
+        tail_seg = open_segment(meta_header().tail);
+        if (meta_header().head == meta_header().tail) {
+            head_seg = tail_seg;
+        }
+        else {
+            head_seg = open_segment(meta_header().head);
+        }
+    }
+
+    MappedQueue(MappedQueue const&) = delete;
+    MappedQueue(MappedQueue&&) = delete;
+
+    MappedQueue& operator=(MappedQueue const&) = delete;
+    MappedQueue& operator=(MappedQueue&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        reserve_back() = T(std::forward<U>(args)...);
+        commit_back();
+    }
+
+    // slot which will be published by next commit_back
+    T& reserve_back() {
+        if (tail_seg->header().tail == segment_size) {
+            rotate();
+        }
+        return tail_seg->slots()[tail_seg->header().tail];
+    }
+
+    void commit_back() {
+        tail_seg->header().tail += 1;
+        if (sync_every > 0 && ++num_commit % sync_every == 0) {
+            tail_seg->file.sync();
+        }
+    }
+
+    void pop_front() {
+        Header& header = head_seg->header();
+        header.head += 1;
+
+        if (header.head == segment_size && head_seg != tail_seg) {
+            uint64_t next = head_seg->index + 1;
+            std::string name = segment_name(head_seg->index);
+
+            meta_header().head = next;
+            head_seg = next == tail_seg->index ? tail_seg : open_segment(next);
+            std::remove(name.c_str());
+        }
+    }
+
+    T& front() {
+        return head_seg->slots()[head_seg->header().head];
+    }
+
+    T const& front() const {
+        return head_seg->slots()[head_seg->header().head];
+    }
+
+    size_t size() const {
+        Header const& head = head_seg->header();
+        Header const& tail = tail_seg->header();
+        if (head_seg == tail_seg) {
+            return tail.tail - head.head;
+        }
+        return (segment_size - head.head)
+               + (tail_seg->index - head_seg->index - 1) * segment_size
+               + tail.tail;
+    }
+
+    // size with remaining writable slots, segments are reused as a whole
+    size_t max_size() const {
+        if (max_segments == 0) {
+            return std::numeric_limits<size_t>::max();
+        }
+
+        size_t live = tail_seg->index - head_seg->index + 1;
+        if (live > max_segments) {
+            return size();
+        }
+        return size() + (max_segments - live) * segment_size
+               + (segment_size - tail_seg->header().tail);
+    }
+
+private:
+    struct Header {
+        uint64_t magic;
+        uint64_t value_size;
+        uint64_t segment_size;
+        uint64_t head;  // segment index on meta, read offset on segment
+        uint64_t tail;  // segment index on meta, write offset on segment
+    };
+
+    static constexpr uint64_t magic_number = 0x4d41505045445155;
+    static constexpr size_t data_offset =
+        (sizeof(Header) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+    struct Segment {
+        uint64_t index;
+        platform::MappedFile file;
+
+        Segment(uint64_t index, std::string const& name, size_t size)
+            : index(index), file(name, size) {
+            // Do Nothing
+        }
+
+        Header& header() const {
+            return *static_cast<Header*>(file.data());
+        }
+
+        T* slots() const {
+            return reinterpret_cast<T*>(static_cast<char*>(file.data())
+                                        + data_offset);
+        }
+    };
+
+    std::string path;
+    size_t segment_size;
+    size_t max_segments;
+    size_t sync_every;
+    size_t num_commit;
+
+    platform::MappedFile meta;
+    std::shared_ptr<Segment> head_seg;
+    std::shared_ptr<Segment> tail_seg;
+
+    Header& meta_header() {
+        return *static_cast<Header*>(meta.data());
+    }
+
+    std::string segment_name(uint64_t index) const {
+        return path + "." + std::to_string(index);
+    }
+
+    void init_header(Header& header) {
+        if (header.magic == 0) {
+            header.magic = magic_number;
+            header.value_size = sizeof(T);
+            header.segment_size = segment_size;
+            header.head = 0;
+            header.tail = 0;
+        }
+        else if (header.magic != magic_number
+                 || header.value_size != sizeof(T)
+                 || header.segment_size != segment_size) {
+            throw std::runtime_error("MappedQueue: incompatible file " + path);
+        }
+    }
+
+    std::shared_ptr<Segment> open_segment(uint64_t index) {
+        auto segment = std::make_shared<Segment>(
+            index, segment_name(index), data_offset + segment_size * sizeof(T));
+        init_header(segment->header());
+        return segment;
+    }
+
+    void rotate() {
+        std::shared_ptr<Segment> next = open_segment(tail_seg->index + 1);
+        meta_header().tail = next->index;
+
+        if (head_seg == tail_seg && head_seg->header().head == segment_size) {
+            std::string name = segment_name(head_seg->index);
+
+            meta_header().head = next->index;
+            head_seg = next;
+            tail_seg = next;
+            std::remove(name.c_str());
+        }
+        else {
+            if (sync_every > 0) {
+                tail_seg->file.sync();
+            }
+            tail_seg = next;
+        }
+    }
+};
+
+
+// Process safe ring buffer, whole state lives in named shared memory.
+// Same interface with ThreadSafe, so it could be used as channel buffer.
+template <typename T>
+class SharedRingBuffer {
+public:
+    using value_type = T;
+
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "SharedRingBuffer base type must be trivially copyable");
+
+    SharedRingBuffer(std::string const& name, size_t size_buffer)
+        : memory(name, data_offset + size_buffer * sizeof(T)),
+          state(static_cast<State*>(memory.data())),
+          buffer(reinterpret_cast<T*>(static_cast<char*>(memory.data())
+                                      + data_offset)) {
+        if (memory.owner()) {
+            new (state) State(size_buffer);
+            state->ready.store(magic_number, std::memory_order_release);
+        }
+        else {
+            while (state->ready.load(std::memory_order_acquire)
+                   != magic_number) {
+                std::this_thread::yield();
+            }
+            if (state->value_size != sizeof(T)
+                || state->size_buffer != size_buffer) {
+                throw std::runtime_error("SharedRingBuffer: incompatible "
+                                         + name);
+            }
+        }
+    }
+
+    ~SharedRingBuffer() {
+        if (memory.owner()) {
+            close();
+        }
+    }
+
+    SharedRingBuffer(SharedRingBuffer const&) = delete;
+    SharedRingBuffer(SharedRingBuffer&&) = delete;
+
+    SharedRingBuffer& operator=(SharedRingBuffer const&) = delete;
+    SharedRingBuffer& operator=(SharedRingBuffer&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait(lock, [&] {
+            return !state->runnable || state->num_data < state->size_buffer;
+        });
+
+        if (state->runnable) {
+            put_back(std::forward<U>(args)...);
+        }
+        state->cond.notify_all();
+    }
+
+    template <typename... U>
+    bool try_emplace_back(U&&... args) {
+        std::unique_lock lock(state->mutex);
+        if (!state->runnable || state->num_data >= state->size_buffer) {
+            return false;
+        }
+
+        put_back(std::forward<U>(args)...);
+        state->cond.notify_all();
+        return true;
+    }
+
+    template <typename Clock, typename Duration, typename... U>
+    bool emplace_back_until(
+        std::chrono::time_point<Clock, Duration> const& time, U&&... args) {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait_until(lock, time, [&] {
+            return !state->runnable || state->num_data < state->size_buffer;
+        });
+
+        if (!state->runnable || state->num_data >= state->size_buffer) {
+            return false;
+        }
+
+        put_back(std::forward<U>(args)...);
+        state->cond.notify_all();
+        return true;
+    }
+
+    std::optional<value_type> pop_front() {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait(
+            lock, [&] { return !state->runnable || state->num_data > 0; });
+
+        return take_front();
+    }
+
+    std::optional<value_type> try_pop() {
+        std::unique_lock lock(state->mutex);
+        return take_front();
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> pop_front_until(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait_until(lock, time, [&] {
+            return !state->runnable || state->num_data > 0;
+        });
+
+        return take_front();
+    }
+
+    template <typename F>
+    bool consume_front(F&& func) {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait(
+            lock, [&] { return !state->runnable || state->num_data > 0; });
+
+        if (state->num_data == 0) {
+            return false;
+        }
+
+        func(buffer[state->ptr_head]);
+        advance_head();
+        return true;
+    }
+
+    void close() {
+        std::unique_lock lock(state->mutex);
+        state->runnable = false;
+        state->cond.notify_all();
+    }
+
+    bool runnable() const {
+        return state->runnable;
+    }
+
+    bool readable() {
+        std::unique_lock lock(state->mutex);
+        return state->runnable || state->num_data > 0;
+    }
+
+private:
+    struct State {
+        std::atomic<uint64_t> ready;
+        uint64_t value_size;
+        uint64_t size_buffer;
+
+        platform::ProcessMutex mutex;
+        platform::ProcessCondition cond;
+
+        bool runnable;
+        uint64_t num_data;
+        uint64_t ptr_head;
+        uint64_t ptr_tail;
+
+        State(size_t size_buffer)
+            : ready(0), value_size(sizeof(T)), size_buffer(size_buffer),
+              runnable(true), num_data(0), ptr_head(0), ptr_tail(0) {
+            // Do Nothing
+        }
+    };
+
+    static constexpr uint64_t magic_number = 0x5348415245445247;
+    static constexpr size_t data_offset =
+        (sizeof(State) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "SharedRingBuffer requires address free atomics");
+
+    platform::SharedMemory memory;
+    State* state;
+    T* buffer;
+
+    template <typename... U>
+    void put_back(U&&... args) {
+        buffer[state->ptr_tail] = T(std::forward<U>(args)...);
+        state->num_data += 1;
+        state->ptr_tail = (state->ptr_tail + 1) % state->size_buffer;
+    }
+
+    std::optional<value_type> take_front() {
+        if (state->num_data == 0) {
+            return std::nullopt;
+        }
+
+        std::optional<value_type> given(buffer[state->ptr_head]);
+        advance_head();
+        return given;
+    }
+
+    void advance_head() {
+        state->num_data -= 1;
+        state->ptr_head = (state->ptr_head + 1) % state->size_buffer;
+        state->cond.notify_all();
+    }
+};
+
+
+namespace LockFree {
+    template <typename T>
+    struct Node {
+        T data;
+        std::atomic<Node*> next;
+
+        Node() : data(), next(nullptr) {
+            // Do Nothing
+        }
+
+        template <typename... U>
+        Node(U&&... data) : data(std::forward<U>(data)...), next(nullptr) {
+            // Do Nothing
+        }
+    };
+
+    template <typename T>
+    class List {
+    public:
+        List()
+            : m_head(nullptr), m_popped(0), m_tail(nullptr), m_pushed(0),
+              m_runnable(true) {
+            // Do Nothing
+        }
+
+        ~List() {
+            m_runnable.store(false, std::memory_order_release);
+
+            Node<T>* node = m_head.load();
+            while (node != nullptr) {
+                Node<T>* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+
+        List(List const&) = delete;
+        List(List&&) = delete;
+
+        List& operator=(List const&) = delete;
+        List& operator=(List&&) = delete;
+
+        void push_back(T const& data) {
+            push_node(new Node<T>(data));
+        }
+
+        void push_back(T&& data) {
+            push_node(new Node<T>(std::move(data)));
+        }
+
+        template <typename... U>
+        void emplace_back(U&&... args) {
+            push_node(new Node<T>(std::forward<U>(args)...));
+        }
+
+        // tail is swapped first and linked after, consumer which takes
+        // the swapped out node waits for the link before releasing it
+        void push_node(Node<T>* node) {
+            if (!runnable()) {
+                delete node;
+                return;
+            }
+
+            Node<T>* prev = m_tail.exchange(node, std::memory_order_acq_rel);
+            if (prev != nullptr) {
+                prev->next.store(node, std::memory_order_release);
+            }
+            else {
+                m_head.store(node, std::memory_order_release);
+            }
+            m_pushed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template <typename U = decltype(platform::prevent_deadlock)>
+        std::optional<T> pop_front(U const& prevent_deadlock
+                                   = platform::prevent_deadlock) {
+            Node<T>* node = nullptr;
+            while (readable() && (node = pop_node()) == nullptr) {
+                std::this_thread::sleep_for(prevent_deadlock);
+            }
+            return release(node);
+        }
+
+        std::optional<T> try_pop() {
+            return release(pop_node());
+        }
+
+        size_t size() const {
+            size_t popped = m_popped.load(std::memory_order_relaxed);
+            size_t pushed = m_pushed.load(std::memory_order_relaxed);
+            return pushed > popped ? pushed - popped : 0;
+        }
+
+        Node<T>* head() {
+            return m_head.load(std::memory_order_relaxed);
+        }
+
+        Node<T>* tail() {
+            return m_tail.load(std::memory_order_relaxed);
+        }
+
+        bool runnable() const {
+            return m_runnable.load(std::memory_order_relaxed);
+        }
+
+        bool readable() const {
+            return runnable()
+                   || m_head.load(std::memory_order_relaxed) != nullptr;
+        }
+
+        void interrupt() {
+            m_runnable.store(false, std::memory_order_relaxed);
+        }
+
+        void resume() {
+            m_runnable.store(true, std::memory_order_relaxed);
+        }
+
+    private:
+        // detach head, nullptr if list is empty
+        Node<T>* pop_node() {
+            Node<T>* node = m_head.load(std::memory_order_acquire);
+            while (node != nullptr) {
+                Node<T>* next = node->next.load(std::memory_order_acquire);
+                if (!m_head.compare_exchange_weak(node,
+                                                  next,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_acquire)) {
+                    continue;
+                }
+
+                Node<T>* last = node;
+                if (next == nullptr
+                    && !m_tail.compare_exchange_strong(
+                        last,
+                        nullptr,
+                        std::memory_order_acq_rel,
+                        std::memory_order_relaxed)) {
+                    // producer swapped tail but not linked yet
+                    while ((next = node->next.load(std::memory_order_acquire))
+                           == nullptr) {
+                        std::this_thread::yield();
+                    }
+                    m_head.store(next, std::memory_order_release);
+                }
+
+                m_popped.fetch_add(1, std::memory_order_relaxed);
+                return node;
+            }
+            return nullptr;
+        }
+
+        static std::optional<T> release(Node<T>* node) {
+            if (node == nullptr) {
+                return std::nullopt;
+            }
+
+            std::optional<T> res(std::move(node->data));
+            delete node;
+            return res;
+        }
+
+        // consumer, producer and shared flag on separate cache lines,
+        // size is split into counters owned by each side
+        alignas(platform::cache_line) std::atomic<Node<T>*> m_head;
+        std::atomic<size_t> m_popped;
+
+        alignas(platform::cache_line) std::atomic<Node<T>*> m_tail;
+        std::atomic<size_t> m_pushed;
+
+        alignas(platform::cache_line) std::atomic<bool> m_runnable;
+    };
+}  // namespace LockFree
+
+
+template <typename T>
+using TSMappedQueue = ThreadSafe<MappedQueue<T>>;
+
+template <typename T>
+using MappedChannel = Channel<TSMappedQueue<T>>;
+
+
+// Test and test-and-set spinlock, waiters spin on plain load
+// so the cache line is not bounced until the lock looks free.
+class SpinLock {
+public:
+    SpinLock() : locked(false) {
+        // Do Nothing
+    }
+
+    SpinLock(SpinLock const&) = delete;
+    SpinLock(SpinLock&&) = delete;
+
+    SpinLock& operator=(SpinLock const&) = delete;
+    SpinLock& operator=(SpinLock&&) = delete;
+
+    void lock() {
+        while (locked.exchange(true, std::memory_order_acquire)) {
+            for (size_t spin = 0; locked.load(std::memory_order_relaxed);
+                 ++spin) {
+                if (spin < max_spin) {
+                    platform::cpu_relax();
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    bool try_lock() {
+        return !locked.load(std::memory_order_relaxed)
+               && !locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        locked.store(false, std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t max_spin = 64;
+
+    std::atomic<bool> locked;
+};
+
+// Fair spinlock, threads are served in the order they took tickets.
+class TicketLock {
+public:
+    TicketLock() : next(0), serving(0) {
+        // Do Nothing
+    }
+
+    TicketLock(TicketLock const&) = delete;
+    TicketLock(TicketLock&&) = delete;
+
+    TicketLock& operator=(TicketLock const&) = delete;
+    TicketLock& operator=(TicketLock&&) = delete;
+
+    void lock() {
+        size_t ticket = next.fetch_add(1, std::memory_order_relaxed);
+        for (size_t spin = 0;
+             serving.load(std::memory_order_acquire) != ticket;
+             ++spin) {
+            if (spin < max_spin) {
+                platform::cpu_relax();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // take ticket only if it would be served right now
+    bool try_lock() {
+        size_t ticket = serving.load(std::memory_order_acquire);
+        return next.compare_exchange_strong(
+            ticket, ticket + 1, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        serving.store(serving.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t max_spin = 64;
+
+    alignas(platform::cache_line) std::atomic<size_t> next;
+    alignas(platform::cache_line) std::atomic<size_t> serving;
+};
+
+// Spin shortly for lock held over a few instructions, then park.
+// Unlock touches the park mutex only if some thread is parked.
+class AdaptiveMutex {
+public:
+    AdaptiveMutex() : locked(false), num_parked(0) {
+        // Do Nothing
+    }
+
+    AdaptiveMutex(AdaptiveMutex const&) = delete;
+    AdaptiveMutex(AdaptiveMutex&&) = delete;
+
+    AdaptiveMutex& operator=(AdaptiveMutex const&) = delete;
+    AdaptiveMutex& operator=(AdaptiveMutex&&) = delete;
+
+    void lock() {
+        for (size_t spin = 0; spin < max_spin; ++spin) {
+            if (try_lock()) {
+                return;
+            }
+            platform::cpu_relax();
+        }
+
+        ++num_parked;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock lock(mutex);
+            cond.wait(lock, [&] { return try_lock(); });
+        }
+        --num_parked;
+    }
+
+    bool try_lock() {
+        return !locked.load(std::memory_order_relaxed)
+               && !locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        locked.store(false, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (num_parked.load() > 0) {
+            std::unique_lock lock(mutex);
+            cond.notify_one();
+        }
+    }
+
+private:
+    static constexpr size_t max_spin = 128;
+
+    std::atomic<bool> locked;
+    std::atomic<size_t> num_parked;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+// Reader writer lock with reader counts spread over cache line lanes,
+// so readers of different cores do not bounce a shared counter.
+// Writers are preferred, reader backs off while writer is present.
+class ShardedSharedMutex {
+public:
+    ShardedSharedMutex()
+        : ShardedSharedMutex(
+            std::max(1u, std::thread::hardware_concurrency())) {
+        // Do Nothing
+    }
+
+    // lanes are rounded up to power of two
+    ShardedSharedMutex(size_t num_lanes)
+        : num_lanes(ceil_pow2(num_lanes)),
+          lanes(std::make_unique<Lane[]>(this->num_lanes)), writer(false) {
+        // Do Nothing
+    }
+
+    ShardedSharedMutex(ShardedSharedMutex const&) = delete;
+    ShardedSharedMutex(ShardedSharedMutex&&) = delete;
+
+    ShardedSharedMutex& operator=(ShardedSharedMutex const&) = delete;
+    ShardedSharedMutex& operator=(ShardedSharedMutex&&) = delete;
+
+    void lock() {
+        writer_mutex.lock();
+        writer.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        readers_left.wait([&] { return num_readers() == 0; });
+    }
+
+    bool try_lock() {
+        if (!writer_mutex.try_lock()) {
+            return false;
+        }
+        writer.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (num_readers() > 0) {
+            unlock();
+            return false;
+        }
+        return true;
+    }
+
+    void unlock() {
+        writer.store(false, std::memory_order_release);
+        writer_mutex.unlock();
+        writer_left.notify();
+    }
+
+    void lock_shared() {
+        while (!try_lock_shared()) {
+            writer_left.wait(
+                [&] { return !writer.load(std::memory_order_acquire); });
+        }
+    }
+
+    // Count first and check writer after, writer does the reverse,
+    // so either of them sees the other.
+    bool try_lock_shared() {
+        std::atomic<size_t>& readers = lane().readers;
+        readers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!writer.load(std::memory_order_acquire)) {
+            return true;
+        }
+        unlock_shared();
+        return false;
+    }
+
+    void unlock_shared() {
+        lane().readers.fetch_sub(1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writer.load(std::memory_order_relaxed)) {
+            readers_left.notify();
+        }
+    }
+
+private:
+    struct alignas(platform::cache_line) Lane {
+        std::atomic<size_t> readers = 0;
+    };
+
+    size_t num_lanes;
+    std::unique_ptr<Lane[]> lanes;
+
+    alignas(platform::cache_line) std::atomic<bool> writer;
+    std::mutex writer_mutex;
+
+    Policy::Adaptive readers_left;
+    Policy::Adaptive writer_left;
+
+    static size_t ceil_pow2(size_t value) {
+        size_t pow = 1;
+        while (pow < value) {
+            pow <<= 1;
+        }
+        return pow;
+    }
+
+    // reader unlocks on the lane it locked, thread hash is cached
+    Lane& lane() {
+        return lanes[platform::thread_hash() & (num_lanes - 1)];
+    }
+
+    size_t num_readers() const {
+        size_t sum = 0;
+        for (size_t i = 0; i < num_lanes; ++i) {
+            sum += lanes[i].readers.load(std::memory_order_acquire);
+        }
+        return sum;
+    }
+};
+
+
+// Pool of reusable objects as golang sync.Pool.
+// Threads keep objects in their own lane, lane over capacity hands half
+// of it to shared stock in one batch and empty lane takes one batch back,
+// so objects returned by consumer reach producer without per object lock.
+// Trim drops stock unused since previous Trim, call it on idle or timer.
+template <typename T>
+class ObjectPool {
+public:
+    // returns object to the pool instead of freeing it
+    struct Recycler {
+        ObjectPool* pool = nullptr;
+
+        void operator()(T* ptr) const {
+            if (pool != nullptr) {
+                pool->recycle(ptr);
+            }
+            else {
+                delete ptr;
+            }
+        }
+    };
+
+    // pool should outlive its handles
+    using Handle = std::unique_ptr<T, Recycler>;
+
+    // reset clears returned object, e.g. buffer keeps capacity only
+    ObjectPool(std::function<std::unique_ptr<T>()> factory = nullptr,
+               std::function<void(T&)> reset = nullptr,
+               size_t capacity = 64)
+        : factory(std::move(factory)), reset(std::move(reset)),
+          capacity(std::max<size_t>(capacity, 2)),
+          num_lanes(std::max(1u, std::thread::hardware_concurrency())),
+          lanes(std::make_unique<Lane[]>(num_lanes)) {
+        // Do Nothing
+    }
+
+    ~ObjectPool() {
+        for (size_t i = 0; i < num_lanes; ++i) {
+            release(lanes[i].cache);
+        }
+        for (auto& batch : stock) {
+            release(batch);
+        }
+        for (auto& batch : victim) {
+            release(batch);
+        }
+    }
+
+    ObjectPool(ObjectPool const&) = delete;
+    ObjectPool(ObjectPool&&) = delete;
+
+    ObjectPool& operator=(ObjectPool const&) = delete;
+    ObjectPool& operator=(ObjectPool&&) = delete;
+
+    // cached object if any, otherwise made by factory
+    Handle Get() {
+        Lane& own = lane();
+        {
+            std::unique_lock lock(own.lock);
+            if (own.cache.empty()) {
+                refill(own);
+            }
+            if (!own.cache.empty()) {
+                T* ptr = own.cache.back();
+                own.cache.pop_back();
+                return Handle(ptr, Recycler{ this });
+            }
+        }
+
+        std::unique_ptr<T> made =
+            factory ? factory() : std::make_unique<T>();
+        return Handle(made.release(), Recycler{ this });
+    }
+
+    // Free batches untouched since previous Trim, then age the rest.
+    // Objects cached in lanes are bounded by capacity and kept.
+    void Trim() {
+        std::vector<std::vector<T*>> expired;
+        {
+            std::unique_lock lock(mutex);
+            expired.swap(victim);
+            victim.swap(stock);
+        }
+        for (auto& batch : expired) {
+            release(batch);
+        }
+    }
+
+private:
+    struct alignas(platform::cache_line) Lane {
+        SpinLock lock;
+        std::vector<T*> cache;
+    };
+
+    std::function<std::unique_ptr<T>()> factory;
+    std::function<void(T&)> reset;
+    size_t capacity;
+
+    size_t num_lanes;
+    std::unique_ptr<Lane[]> lanes;
+
+    std::mutex mutex;
+    std::vector<std::vector<T*>> stock;
+    std::vector<std::vector<T*>> victim;
+
+    Lane& lane() {
+        return lanes[platform::thread_hash() % num_lanes];
+    }
+
+    // take one batch from shared stock, newer one first
+    void refill(Lane& own) {
+        std::unique_lock lock(mutex);
+        for (auto* from : { &stock, &victim }) {
+            if (!from->empty()) {
+                own.cache.swap(from->back());
+                from->pop_back();
+                return;
+            }
+        }
+    }
+
+    void recycle(T* ptr) {
+        if (reset) {
+            try {
+                reset(*ptr);
+            }
+            catch (...) {
+                delete ptr;
+                return;
+            }
+        }
+
+        std::vector<T*> batch;
+        {
+            Lane& own = lane();
+            std::unique_lock lock(own.lock);
+            own.cache.push_back(ptr);
+            if (own.cache.size() < capacity) {
+                return;
+            }
+
+            // hand older half over, so lane keeps the warm ones
+            size_t half = own.cache.size() / 2;
+            batch.assign(own.cache.begin(), own.cache.begin() + half);
+            own.cache.erase(own.cache.begin(), own.cache.begin() + half);
+        }
+
+        std::unique_lock lock(mutex);
+        stock.push_back(std::move(batch));
+    }
+
+    static void release(std::vector<T*>& batch) {
+        for (T* ptr : batch) {
+            delete ptr;
+        }
+        batch.clear();
+    }
+};
+
+// handle of pooled object, movable through channels as payload
+template <typename T>
+using Pooled = typename ObjectPool<T>::Handle;
+
+
+using ull = unsigned long long;
+
+// Counter of pending works, waiters park until it drops to zero.
+class WaitGroup {
+public:
+    WaitGroup() : visit(0) {
+        // Do Nothing
+    }
+
+    WaitGroup(ull visit) : visit(visit) {
+        // Do Nothing
+    }
+
+    ull Add() {
+        return (visit += 1);
+    }
+
+    ull Done() {
+        ull remain = (visit -= 1);
+        if (remain == 0) {
+            waiter.notify();
+        }
+        return remain;
+    }
+
+    void Wait() {
+        Trace::Span span("WaitGroup::Wait");
+        waiter.wait([&] { return visit == 0; });
+    }
+
+private:
+    std::atomic<ull> visit;
+    Policy::Adaptive waiter;
+};
+
+
+// pool type which has GetNumThreads, to split overloads with and without pool
+template <typename Pool>
+using pool_threads_t = decltype(std::declval<Pool&>().GetNumThreads());
+
+// Split [0, count) into contiguous chunks of at least grain elements,
+// one per worker and one for the caller, and wait them with WaitGroup.
+// Tasks should not block on the same pool, workers would be exhausted.
+template <typename Pool, typename F, typename = pool_threads_t<Pool>>
+void parallel_for(Pool& pool, size_t count, F&& func, size_t grain = 1) {
+    if (count == 0) {
+        return;
+    }
+
+    size_t num_chunks = std::min(pool.GetNumThreads() + 1,
+                                 std::max<size_t>(count / grain, 1));
+    if (num_chunks == 1) {
+        func(size_t(0), count);
+        return;
+    }
+
+    std::mutex mutex;
+    std::exception_ptr error;
+    auto run = [&](size_t chunk) {
+        try {
+            func(count * chunk / num_chunks, count * (chunk + 1) / num_chunks);
+        }
+        catch (...) {
+            std::unique_lock lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    WaitGroup wg(num_chunks - 1);
+    for (size_t i = 1; i < num_chunks; ++i) {
+        pool.Add([&, i] {
+            run(i);
+            wg.Done();
+        });
+    }
+    run(0);
+    wg.Wait();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Reduce with independent accumulators, so dependency chain is broken
+// and compiler could keep them in vector lanes.
+// Op should be associative and commutative as std::reduce.
+template <typename Iter, typename T, typename Op>
+T reduce_leaf(Iter first, Iter last, T init, Op op) {
+    constexpr size_t lanes = 4;
+
+    size_t size = std::distance(first, last);
+    if (size < 2 * lanes) {
+        return std::accumulate(first, last, init, op);
+    }
+
+    T acc[lanes] = { T(first[0]), T(first[1]), T(first[2]), T(first[3]) };
+
+    size_t i = lanes;
+    for (; i + lanes <= size; i += lanes) {
+        acc[0] = op(acc[0], first[i]);
+        acc[1] = op(acc[1], first[i + 1]);
+        acc[2] = op(acc[2], first[i + 2]);
+        acc[3] = op(acc[3], first[i + 3]);
+    }
+    for (; i < size; ++i) {
+        acc[0] = op(acc[0], first[i]);
+    }
+    return op(init, op(op(acc[0], acc[1]), op(acc[2], acc[3])));
+}
+
+template <typename Pool,
+          typename Iter,
+          typename T,
+          typename Op = std::plus<>,
+          typename = pool_threads_t<Pool>>
+T parallel_reduce(Pool& pool, Iter first, Iter last, T init, Op op = Op()) {
+    constexpr size_t grain = 1 << 14;
+    size_t size = std::distance(first, last);
+
+    size_t num_chunks =
+        std::min(pool.GetNumThreads() + 1, std::max<size_t>(size / grain, 1));
+    std::vector<std::optional<T>> partial(num_chunks);
+
+    parallel_for(pool, num_chunks, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            Iter lo = first + size * chunk / num_chunks;
+            Iter hi = first + size * (chunk + 1) / num_chunks;
+            if (lo != hi) {
+                partial[chunk] = reduce_leaf(lo + 1, hi, T(*lo), op);
+            }
+        }
+    });
+
+    for (auto& value : partial) {
+        if (value.has_value()) {
+            init = op(init, std::move(value.value()));
+        }
+    }
+    return init;
+}
+
+// three passes, chunk sums in parallel, scan of sums in caller,
+// then each chunk scans from its offset in parallel
+template <typename Pool,
+          typename Iter,
+          typename OutIter,
+          typename Op = std::plus<>,
+          typename = pool_threads_t<Pool>>
+OutIter parallel_inclusive_scan(
+    Pool& pool, Iter first, Iter last, OutIter d_first, Op op = Op()) {
+    using T = typename std::iterator_traits<Iter>::value_type;
+    constexpr size_t grain = 1 << 14;
+
+    size_t size = std::distance(first, last);
+    size_t num_chunks =
+        std::min(pool.GetNumThreads() + 1, std::max<size_t>(size / grain, 1));
+    if (num_chunks == 1) {
+        return std::inclusive_scan(first, last, d_first, op);
+    }
+
+    auto bound = [&](size_t chunk) { return size * chunk / num_chunks; };
+
+    std::vector<std::optional<T>> sums(num_chunks);
+    parallel_for(pool, num_chunks - 1, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            Iter lo = first + bound(chunk);
+            Iter hi = first + bound(chunk + 1);
+            sums[chunk] = reduce_leaf(lo + 1, hi, T(*lo), op);
+        }
+    });
+
+    for (size_t chunk = 1; chunk < num_chunks - 1; ++chunk) {
+        sums[chunk] = op(sums[chunk - 1].value(), sums[chunk].value());
+    }
+
+    parallel_for(pool, num_chunks, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            Iter lo = first + bound(chunk);
+            Iter hi = first + bound(chunk + 1);
+            OutIter out = d_first + bound(chunk);
+            if (chunk == 0) {
+                std::inclusive_scan(lo, hi, out, op);
+            }
+            else {
+                std::inclusive_scan(lo, hi, out, op, sums[chunk - 1].value());
+            }
+        }
+    });
+    return d_first + size;
+}
+
+// Sort chunks in parallel, then merge sorted runs pairwise in rounds.
+// Each merge is split at binary searched points, so last rounds with
+// few runs still keep all workers busy. Not stable.
+template <typename Pool,
+          typename Iter,
+          typename Compare = std::less<>,
+          typename = pool_threads_t<Pool>>
+void parallel_sort(Pool& pool,
+                   Iter first,
+                   Iter last,
+                   Compare comp = Compare()) {
+    using T = typename std::iterator_traits<Iter>::value_type;
+    constexpr size_t grain = 1 << 14;
+
+    size_t size = std::distance(first, last);
+    size_t num_runs =
+        std::min(pool.GetNumThreads() + 1, std::max<size_t>(size / grain, 1));
+    if (num_runs == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<size_t> bounds;
+    for (size_t run = 0; run <= num_runs; ++run) {
+        bounds.push_back(size * run / num_runs);
+    }
+
+    parallel_for(pool, num_runs, [&](size_t begin, size_t end) {
+        for (size_t run = begin; run < end; ++run) {
+            std::sort(first + bounds[run], first + bounds[run + 1], comp);
+        }
+    });
+
+    // merge [a_lo, a_hi) and [b_lo, b_hi) into buffer from out
+    struct Job {
+        size_t a_lo, a_hi, b_lo, b_hi, out;
+    };
+
+    std::vector<T> buffer(size);
+    std::vector<Job> jobs;
+    while (bounds.size() > 2) {
+        size_t num_pairs = bounds.size() / 2;
+        size_t parts = (num_runs + num_pairs - 1) / num_pairs;
+
+        jobs.clear();
+        std::vector<size_t> merged{ 0 };
+        for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+            size_t lo = bounds[i];
+            size_t mid = bounds[i + 1];
+            size_t hi = i + 2 < bounds.size() ? bounds[i + 2] : mid;
+            merged.push_back(hi);
+
+            // split longer run evenly and shorter one at lower bound of
+            // splitter, so every part merges only its own elements
+            bool a_longer = mid - lo >= hi - mid;
+            size_t long_lo = a_longer ? lo : mid;
+            size_t long_hi = a_longer ? mid : hi;
+            size_t short_lo = a_longer ? mid : lo;
+            size_t short_hi = a_longer ? hi : mid;
+
+            size_t prev_long = long_lo;
+            size_t prev_short = short_lo;
+            for (size_t part = 1; part <= parts; ++part) {
+                size_t at_long =
+                    long_lo + (long_hi - long_lo) * part / parts;
+                size_t at_short = short_hi;
+                if (at_long < long_hi) {
+                    at_short = std::lower_bound(first + short_lo,
+                                                first + short_hi,
+                                                first[at_long],
+                                                comp)
+                               - first;
+                }
+
+                size_t out = lo + (prev_long - long_lo)
+                             + (prev_short - short_lo);
+                if (a_longer) {
+                    jobs.push_back(
+                        { prev_long, at_long, prev_short, at_short, out });
+                }
+                else {
+                    jobs.push_back(
+                        { prev_short, at_short, prev_long, at_long, out });
+                }
+                prev_long = at_long;
+                prev_short = at_short;
+            }
+        }
+
+        parallel_for(pool, jobs.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Job const& job = jobs[i];
+                std::merge(std::make_move_iterator(first + job.a_lo),
+                           std::make_move_iterator(first + job.a_hi),
+                           std::make_move_iterator(first + job.b_lo),
+                           std::make_move_iterator(first + job.b_hi),
+                           buffer.begin() + job.out,
+                           comp);
+            }
+        });
+
+        parallel_for(
+            pool,
+            size,
+            [&](size_t begin, size_t end) {
+                std::move(buffer.begin() + begin,
+                          buffer.begin() + end,
+                          first + begin);
+            },
+            grain);
+
+        bounds.swap(merged);
+    }
+}
+
+template <typename Iter,
+          typename Compare = std::less<>,
+          typename = typename std::iterator_traits<Iter>::iterator_category>
+void parallel_sort(Iter first, Iter last, Compare comp = Compare()) {
+    ThreadPool<void> pool(std::max(1u, std::thread::hardware_concurrency())
+                          - 1);
+    parallel_sort(pool, first, last, comp);
+}
+
+template <typename Iter,
+          typename OutIter,
+          typename Op = std::plus<>,
+          typename = typename std::iterator_traits<Iter>::iterator_category>
+OutIter parallel_inclusive_scan(Iter first,
+                                Iter last,
+                                OutIter d_first,
+                                Op op = Op()) {
+    ThreadPool<void> pool(std::max(1u, std::thread::hardware_concurrency())
+                          - 1);
+    return parallel_inclusive_scan(pool, first, last, d_first, op);
+}
+
+template <typename Iter,
+          typename T,
+          typename Op = std::plus<>,
+          typename = typename std::iterator_traits<Iter>::iterator_category>
+T parallel_reduce(Iter first, Iter last, T init, Op op = Op()) {
+    ThreadPool<void> pool(std::max(1u, std::thread::hardware_concurrency())
+                          - 1);
+    return parallel_reduce(pool, first, last, std::move(init), op);
+}
+
+
+struct WalkOptions {
+    // depth of directories to descend, 0 for entries of root only
+    size_t max_depth = std::numeric_limits<size_t>::max();
+    // number of subdirectories to descend per directory
+    size_t max_fanout = std::numeric_limits<size_t>::max();
+    // number of directories read at the same time
+    size_t max_concurrency = std::thread::hardware_concurrency();
+    // number of directories taken from shared queue at once
+    size_t batch_size = 16;
+    bool follow_symlinks = false;
+};
+
+// Walk directory tree with bounded number of workers, caller included.
+// Each worker accumulates visited entries into its own copy of init,
+// and results are merged with reduce once per worker.
+template <typename Pool, typename T, typename Visit, typename Reduce>
+T parallel_walk(Pool& pool,
+                std::filesystem::path const& root,
+                T init,
+                Visit&& visit,
+                Reduce&& reduce,
+                WalkOptions const& options = WalkOptions()) {
+    namespace fs = std::filesystem;
+    using dir_t = std::pair<fs::path, size_t>;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    std::vector<dir_t> pending{ dir_t(root, 0) };
+    size_t active = 0;
+
+    T result = init;
+    std::exception_ptr error;
+
+    auto walk_dir = [&](dir_t const& dir,
+                        T& local,
+                        std::vector<dir_t>& found) {
+        auto const& [path, depth] = dir;
+        auto flag = fs::directory_options::skip_permission_denied;
+        if (options.follow_symlinks) {
+            flag |= fs::directory_options::follow_directory_symlink;
+        }
+
+        std::error_code ec;
+        size_t fanout = 0;
+        for (fs::directory_iterator iter(path, flag, ec), end;
+             !ec && iter != end;
+             iter.increment(ec)) {
+            fs::directory_entry const& entry = *iter;
+            visit(local, entry);
+
+            if (depth < options.max_depth && fanout < options.max_fanout) {
+                std::error_code type_ec;
+                bool is_dir = entry.is_directory(type_ec)
+                              && (options.follow_symlinks
+                                  || !entry.is_symlink(type_ec));
+                if (is_dir) {
+                    found.emplace_back(entry.path(), depth + 1);
+                    ++fanout;
+                }
+            }
+        }
+    };
+
+    auto worker = [&] {
+        T local = init;
+        std::vector<dir_t> batch;
+        std::vector<dir_t> found;
+
+        std::unique_lock lock(mutex);
+        while (true) {
+            cond.wait(lock, [&] { return !pending.empty() || active == 0; });
+            if (pending.empty()) {
+                break;
+            }
+
+            size_t num = std::min(std::max<size_t>(options.batch_size, 1),
+                                  pending.size());
+            batch.assign(std::make_move_iterator(pending.end() - num),
+                         std::make_move_iterator(pending.end()));
+            pending.resize(pending.size() - num);
+
+            ++active;
+            lock.unlock();
+
+            try {
+                for (auto const& dir : batch) {
+                    walk_dir(dir, local, found);
+                }
+            }
+            catch (...) {
+                lock.lock();
+                if (!error) {
+                    error = std::current_exception();
+                }
+                pending.clear();
+                found.clear();
+                lock.unlock();
+            }
+            batch.clear();
+
+            lock.lock();
+            --active;
+            pending.insert(pending.end(),
+                           std::make_move_iterator(found.begin()),
+                           std::make_move_iterator(found.end()));
+            found.clear();
+            cond.notify_all();
+        }
+        result = reduce(std::move(result), std::move(local));
+    };
+
+    size_t num_workers = std::min(std::max<size_t>(options.max_concurrency, 1),
+                                  pool.GetNumThreads() + 1);
+
+    std::vector<std::future<void>> futs;
+    for (size_t i = 1; i < num_workers; ++i) {
+        futs.emplace_back(pool.Add(worker));
+    }
+    worker();
+
+    for (auto& fut : futs) {
+        fut.get();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return result;
+}
+
+template <typename T, typename Visit, typename Reduce>
+T parallel_walk(std::filesystem::path const& root,
+                T init,
+                Visit&& visit,
+                Reduce&& reduce,
+                WalkOptions const& options = WalkOptions()) {
+    ThreadPool<void> pool(std::max<size_t>(options.max_concurrency, 1) - 1);
+    return parallel_walk(pool,
+                         root,
+                         std::move(init),
+                         std::forward<Visit>(visit),
+                         std::forward<Reduce>(reduce),
+                         options);
+}
+
+template <typename Visit>
+void parallel_walk(std::filesystem::path const& root,
+                   Visit&& visit,
+                   WalkOptions const& options = WalkOptions()) {
+    parallel_walk(
+        root,
+        0,
+        [&](int&, std::filesystem::directory_entry const& entry) {
+            visit(entry);
+        },
+        [](int, int) { return 0; },
+        options);
+}
+
+
+namespace Pipeline {
+    // Threads and links of single pipeline.
+    // Failure of any stage closes every link, so all stages drain and stop.
+    class Runtime {
+    public:
+        Runtime() = default;
+
+        ~Runtime() {
+            Abort();
+            Join();
+        }
+
+        Runtime(Runtime const&) = delete;
+        Runtime(Runtime&&) = delete;
+
+        Runtime& operator=(Runtime const&) = delete;
+        Runtime& operator=(Runtime&&) = delete;
+
+        template <typename F>
+        void Spawn(F&& func) {
+            std::unique_lock lock(mutex);
+            threads.emplace_back(
+                [this, func = std::forward<F>(func)]() mutable {
+                    try {
+                        func();
+                    }
+                    catch (...) {
+                        Fail(std::current_exception());
+                    }
+                });
+        }
+
+        template <typename C>
+        void Own(std::shared_ptr<C> const& channel) {
+            std::unique_lock lock(mutex);
+            closers.emplace_back([channel] { channel->Close(); });
+        }
+
+        void Fail(std::exception_ptr except) {
+            {
+                std::unique_lock lock(mutex);
+                if (!error) {
+                    error = except;
+                }
+            }
+            Abort();
+        }
+
+        void Abort() {
+            std::vector<std::function<void()>> closing;
+            {
+                std::unique_lock lock(mutex);
+                closing = closers;
+            }
+            for (auto& close : closing) {
+                close();
+            }
+        }
+
+        void Join() {
+            std::vector<std::thread> joining;
+            {
+                std::unique_lock lock(mutex);
+                joining.swap(threads);
+            }
+            for (auto& thread : joining) {
+                thread.join();
+            }
+        }
+
+        void Wait() {
+            Join();
+
+            std::unique_lock lock(mutex);
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+    private:
+        std::mutex mutex;
+        std::exception_ptr error;
+        std::vector<std::thread> threads;
+        std::vector<std::function<void()>> closers;
+    };
+
+    // Output of a stage, links to the next stage with bounded channel.
+    template <typename T>
+    class Flow {
+    public:
+        using value_type = T;
+
+        Flow(std::shared_ptr<Runtime> runtime, size_t capacity)
+            : runtime(std::move(runtime)), capacity(capacity),
+              channel(std::make_shared<RChannel<T>>(capacity)) {
+            this->runtime->Own(channel);
+        }
+
+        RChannel<T>& Output() const {
+            return *channel;
+        }
+
+        std::shared_ptr<Runtime> runtime;
+        size_t capacity;
+        std::shared_ptr<RChannel<T>> channel;
+    };
+
+    // Handle of terminated pipeline, waits all stages on destruction.
+    class Completion {
+    public:
+        Completion(std::shared_ptr<Runtime> runtime)
+            : runtime(std::move(runtime)) {
+            // Do Nothing
+        }
+
+        ~Completion() {
+            if (runtime != nullptr) {
+                runtime->Join();
+            }
+        }
+
+        Completion(Completion const&) = delete;
+        Completion(Completion&&) = default;
+
+        Completion& operator=(Completion const&) = delete;
+        Completion& operator=(Completion&&) = default;
+
+        // wait until sink consumes all, rethrow first failure of stages
+        void Wait() {
+            runtime->Wait();
+        }
+
+    private:
+        std::shared_ptr<Runtime> runtime;
+    };
+
+    template <typename F>
+    struct MapStage {
+        F func;
+        size_t parallelism;
+        bool ordered;
+    };
+
+    template <typename F>
+    struct FilterStage {
+        F pred;
+        size_t parallelism;
+    };
+
+    struct BatchStage {
+        size_t size;
+    };
+
+    template <typename F>
+    struct SinkStage {
+        F func;
+        size_t parallelism;
+    };
+
+    // generator returns std::optional<T>, std::nullopt for end of stream
+    template <typename F>
+    auto source(F&& gen, size_t capacity = 64) {
+        using T = typename std::invoke_result_t<std::decay_t<F>&>::value_type;
+
+        Flow<T> flow(std::make_shared<Runtime>(), capacity);
+        flow.runtime->Spawn(
+            [gen = std::forward<F>(gen), out = flow.channel]() mutable {
+                for (auto item = gen(); item.has_value() && out->Runnable();
+                     item = gen()) {
+                    out->Add(std::move(item.value()));
+                }
+                out->Close();
+            });
+        return flow;
+    }
+
+    template <typename C>
+    auto from(C container, size_t capacity = 64) {
+        auto data = std::make_shared<C>(std::move(container));
+        return source(
+            [data, iter = data->begin()]() mutable {
+                using T = typename C::value_type;
+                if (iter == data->end()) {
+                    return std::optional<T>();
+                }
+                return std::optional<T>(*iter++);
+            },
+            capacity);
+    }
+
+    template <typename F>
+    auto map(F&& func, size_t parallelism = 1) {
+        return MapStage<std::decay_t<F>>{ std::forward<F>(func),
+                                          parallelism,
+                                          false };
+    }
+
+    // parallel map which keeps order of the input
+    template <typename F>
+    auto ordered_map(F&& func, size_t parallelism = 1) {
+        return MapStage<std::decay_t<F>>{ std::forward<F>(func),
+                                          parallelism,
+                                          true };
+    }
+
+    template <typename F>
+    auto filter(F&& pred, size_t parallelism = 1) {
+        return FilterStage<std::decay_t<F>>{ std::forward<F>(pred),
+                                             parallelism };
+    }
+
+    inline BatchStage batch(size_t size) {
+        return BatchStage{ size };
+    }
+
+    template <typename F>
+    auto sink(F&& func, size_t parallelism = 1) {
+        return SinkStage<std::decay_t<F>>{ std::forward<F>(func),
+                                           parallelism };
+    }
+
+    // run body(input, output) on workers, last finished one closes output
+    template <typename U, typename T, typename Body>
+    Flow<U> spawn_stage(Flow<T> const& flow, size_t parallelism, Body body) {
+        Flow<U> next(flow.runtime, flow.capacity);
+        parallelism = std::max<size_t>(parallelism, 1);
+
+        auto remaining = std::make_shared<std::atomic<size_t>>(parallelism);
+        for (size_t i = 0; i < parallelism; ++i) {
+            flow.runtime->Spawn(
+                [=, in = flow.channel, out = next.channel]() mutable {
+                    body(*in, *out);
+                    if (--*remaining == 0) {
+                        out->Close();
+                    }
+                });
+        }
+        return next;
+    }
+
+    template <typename T, typename F>
+    auto operator|(Flow<T> const& flow, MapStage<F> const& stage) {
+        using U = std::decay_t<std::invoke_result_t<F&, T>>;
+        static_assert(!std::is_void_v<U>, "use sink for void function");
+
+        if (!stage.ordered || stage.parallelism <= 1) {
+            return spawn_stage<U>(
+                flow,
+                stage.parallelism,
+                [func = stage.func](RChannel<T>& in, RChannel<U>& out) mutable {
+                    for (auto& item : in) {
+                        out.Add(func(std::move(item)));
+                    }
+                });
+        }
+
+        // results are reordered with futures of thread pool
+        auto pool = std::make_shared<ThreadPool<U>>(stage.parallelism,
+                                                    flow.capacity);
+        auto order = std::make_shared<RChannel<std::future<U>>>(flow.capacity);
+        flow.runtime->Own(order);
+
+        auto func = std::make_shared<F>(stage.func);
+
+        flow.runtime->Spawn([pool, order, func, in = flow.channel] {
+            for (auto& item : *in) {
+                order->Add(pool->Add([func, item = std::move(item)]() mutable {
+                    return (*func)(std::move(item));
+                }));
+            }
+            order->Close();
+        });
+
+        return spawn_stage<U>(
+            flow, 1, [pool, order](RChannel<T>&, RChannel<U>& out) {
+                for (auto& fut : *order) {
+                    out.Add(fut.get());
+                }
+            });
+    }
+
+    template <typename T, typename F>
+    Flow<T> operator|(Flow<T> const& flow, FilterStage<F> const& stage) {
+        return spawn_stage<T>(
+            flow,
+            stage.parallelism,
+            [pred = stage.pred](RChannel<T>& in, RChannel<T>& out) mutable {
+                for (auto& item : in) {
+                    if (pred(item)) {
+                        out.Add(std::move(item));
+                    }
+                }
+            });
+    }
+
+    template <typename T>
+    Flow<std::vector<T>> operator|(Flow<T> const& flow,
+                                   BatchStage const& stage) {
+        size_t size = std::max<size_t>(stage.size, 1);
+        return spawn_stage<std::vector<T>>(
+            flow, 1, [size](RChannel<T>& in, RChannel<std::vector<T>>& out) {
+                std::vector<T> chunk;
+                for (auto& item : in) {
+                    chunk.push_back(std::move(item));
+                    if (chunk.size() == size) {
+                        out.Add(std::move(chunk));
+                        chunk = std::vector<T>();
+                    }
+                }
+                if (!chunk.empty()) {
+                    out.Add(std::move(chunk));
+                }
+            });
+    }
 
-        if (m_runnable) {
-            buffer.emplace_back(std::forward<U>(args)...);
+    template <typename T, typename F>
+    Completion operator|(Flow<T> const& flow, SinkStage<F> const& stage) {
+        size_t parallelism = std::max<size_t>(stage.parallelism, 1);
+        for (size_t i = 0; i < parallelism; ++i) {
+            flow.runtime->Spawn(
+                [func = stage.func, in = flow.channel]() mutable {
+                    for (auto& item : *in) {
+                        func(std::move(item));
+                    }
+                });
         }
-        cond.notify_all();
+        return Completion(flow.runtime);
     }
+}  // namespace Pipeline
+
+
+namespace Policy {
+    // bounded queue with capacity fixed at compile time
+    template <typename T,
+              size_t Capacity,
+              typename Producers,
+              typename Consumers,
+              typename Wait,
+              typename Alloc>
+    class FixedQueue
+        : public BoundedQueue<T, Producers, Consumers, Wait, Alloc> {
+    public:
+        FixedQueue(Alloc const& alloc = Alloc())
+            : BoundedQueue<T, Producers, Consumers, Wait, Alloc>(Capacity,
+                                                                 alloc) {
+            // Do Nothing
+        }
+    };
 
-    void push_back(value_type const& value) {
-        std::unique_lock lock(mutex);
-        cond.wait(lock, [&] {
-            return !m_runnable || buffer.size() < buffer.max_size();
-        });
+    template <typename T>
+    struct Type {
+        using type = T;
+    };
 
-        if (m_runnable) {
-            buffer.push_back(value);
+    // pick container which has only synchronization the topology needs
+    template <typename T,
+              size_t Capacity,
+              typename Producers,
+              typename Consumers,
+              typename Wait,
+              typename Alloc>
+    constexpr auto select_container() {
+        static_assert(std::is_same_v<Producers, Single>
+                          || std::is_same_v<Producers, Multi>,
+                      "Producers must be Policy::Single or Policy::Multi");
+        static_assert(std::is_same_v<Consumers, Single>
+                          || std::is_same_v<Consumers, Multi>,
+                      "Consumers must be Policy::Single or Policy::Multi");
+        static_assert(std::is_same_v<Wait, Spin>
+                          || std::is_same_v<Wait, Park>,
+                      "Wait must be Policy::Spin or Policy::Park");
+
+        if constexpr (Capacity == unbounded
+                      && std::is_same_v<Consumers, Single>) {
+            return Type<LockFree::MpscQueue<T, Wait, Alloc>>();
+        }
+        else if constexpr (Capacity == unbounded) {
+            return Type<LockFree::SegmentQueue<T, Wait, Alloc>>();
+        }
+        else {
+            return Type<
+                FixedQueue<T, Capacity, Producers, Consumers, Wait, Alloc>>();
         }
-        cond.notify_all();
     }
 
-    void push_back(value_type&& value) {
-        std::unique_lock lock(mutex);
-        cond.wait(lock, [&] {
-            return !m_runnable || buffer.size() < buffer.max_size();
-        });
+    template <typename T,
+              size_t Capacity,
+              typename Producers,
+              typename Consumers,
+              typename Wait,
+              typename Alloc>
+    using container_t = typename decltype(
+        select_container<T, Capacity, Producers, Consumers, Wait, Alloc>())::
+        type;
+}  // namespace Policy
 
-        if (m_runnable) {
-            buffer.push_back(std::move(value));
-        }
-        cond.notify_all();
-    }
+template <typename T,
+          size_t Capacity = Policy::unbounded,
+          typename Producers = Policy::Multi,
+          typename Consumers = Policy::Multi,
+          typename Wait = Policy::Park,
+          typename Alloc = std::allocator<T>>
+using PolicyChannel = Channel<
+    Policy::container_t<T, Capacity, Producers, Consumers, Wait, Alloc>>;
+
+
+// Token bucket as generic cell rate algorithm, state is single atomic
+// of theoretical arrival time, so acquire is one compare exchange.
+// Waiter reserves its slot and sleeps until it, no timer thread.
+class RateLimiter {
+public:
+    using clock = std::chrono::steady_clock;
 
-    std::optional<value_type> pop_front() {
-        std::unique_lock lock(mutex);
-        cond.wait(lock, [&] { return !m_runnable || buffer.size() > 0; });
+    // tokens per second, and how many could be taken at once after idle
+    RateLimiter(double rate, size_t burst = 1)
+        : start(clock::now()),
+          interval(static_cast<int64_t>(1e9 / std::max(rate, 1e-9))),
+          burst(std::max<size_t>(burst, 1)), tat(0) {
+        // Do Nothing
+    }
 
-        if (!m_runnable && buffer.size() == 0) {
-            return std::nullopt;
-        }
+    RateLimiter(RateLimiter const&) = delete;
+    RateLimiter(RateLimiter&&) = delete;
 
-        value_type given = std::move(buffer.front());
-        buffer.pop_front();
+    RateLimiter& operator=(RateLimiter const&) = delete;
+    RateLimiter& operator=(RateLimiter&&) = delete;
 
-        cond.notify_all();
-        return std::make_optional(std::move(given));
+    // more tokens than burst are taken on debt, later callers wait for it
+    void Acquire(size_t tokens = 1) {
+        int64_t at = 0;
+        reserve(tokens, [](int64_t) { return true; }, at);
+        sleep(at);
     }
 
-    std::optional<value_type> try_pop() {
-        std::unique_lock lock(mutex, std::try_to_lock);
-        if (lock.owns_lock() && buffer.size() > 0) {
-            value_type given = std::move(buffer.front());
-            buffer.pop_front();
+    bool TryAcquire(size_t tokens = 1) {
+        int64_t at = 0;
+        return reserve(tokens, [&](int64_t now) { return at <= now; }, at);
+    }
 
-            cond.notify_all();
-            return std::make_optional(std::move(given));
+    // fail at once if tokens would not be ready in timeout
+    template <typename Rep, typename Period>
+    bool AcquireFor(size_t tokens,
+                    std::chrono::duration<Rep, Period> const& timeout) {
+        int64_t limit =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timeout)
+                .count();
+
+        int64_t at = 0;
+        if (!reserve(tokens,
+                     [&](int64_t now) { return at - now <= limit; },
+                     at)) {
+            return false;
         }
-        return std::nullopt;
+        sleep(at);
+        return true;
     }
 
-    void close() {
-        m_runnable = false;
-        cond.notify_all();
+    template <typename Rep, typename Period>
+    bool AcquireFor(std::chrono::duration<Rep, Period> const& timeout) {
+        return AcquireFor(1, timeout);
     }
 
-    bool runnable() const {
-        return m_runnable;
+    // give back tokens acquired but not used
+    void Release(size_t tokens = 1) {
+        int64_t cost = interval * static_cast<int64_t>(tokens);
+        int64_t given = tat.load();
+        while (!tat.compare_exchange_weak(given,
+                                          std::max<int64_t>(given - cost, 0))) {
+            // Do Nothing
+        }
     }
 
-    bool readable() {
-        std::unique_lock lock(mutex);
-        return m_runnable || buffer.size() > 0;
+    double GetRate() const {
+        return 1e9 / interval;
+    }
+
+    size_t GetBurst() const {
+        return burst;
     }
 
 private:
-    bool m_runnable;
-    Cont buffer;
+    clock::time_point start;
+    int64_t interval;
+    size_t burst;
 
-    Mutex mutex;
-    std::condition_variable cond;
-};
+    // nanoseconds from start when bucket is full again
+    std::atomic<int64_t> tat;
 
-template <typename T>
-using TSList = ThreadSafe<std::list<T>>;
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   clock::now() - start)
+            .count();
+    }
 
-template <typename T>
-using TSRingBuffer = ThreadSafe<RingBuffer<T>>;
+    // at is when reserved tokens are ready, accept decides on it
+    template <typename F>
+    bool reserve(size_t tokens, F&& accept, int64_t& at) {
+        int64_t cost = interval * static_cast<int64_t>(tokens);
+        int64_t tolerance = interval * static_cast<int64_t>(burst);
+
+        int64_t current = now();
+        int64_t given = tat.load();
+        while (true) {
+            int64_t next = std::max(given, current) + cost;
+            at = next - tolerance;
+            if (!accept(current)) {
+                return false;
+            }
+            if (tat.compare_exchange_weak(given, next)) {
+                return true;
+            }
+        }
+    }
 
+    void sleep(int64_t at) const {
+        int64_t wait = at - now();
+        if (wait > 0) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+        }
+    }
+};
 
+// Channel whose items are released at most at the rate of its limiter.
+// Token is taken before item and given back if there is none.
 template <typename Container>
-class Channel {
+class ThrottledChannel {
 public:
     using value_type = typename Container::value_type;
-    using iterator = ChannelIterator<value_type, Channel<Container>>;
+    using iterator = ChannelIterator<value_type, ThrottledChannel<Container>>;
 
     template <typename... U>
-    Channel(U&&... args) : buffer(std::forward<U>(args)...) {
+    ThrottledChannel(double rate, size_t burst, U&&... args)
+        : limiter(rate, burst), channel(std::forward<U>(args)...) {
         // Do Nothing
     }
 
-    Channel(Channel const&) = delete;
-    Channel(Channel&&) = delete;
-
-    Channel& operator=(const Channel&) = delete;
-    Channel& operator=(Channel&&) = delete;
-
     template <typename... U>
     void Add(U&&... args) {
-        buffer.emplace_back(std::forward<U>(args)...);
+        channel.Add(std::forward<U>(args)...);
+    }
+
+    template <typename... U>
+    bool TryAdd(U&&... args) {
+        return channel.TryAdd(std::forward<U>(args)...);
     }
 
     template <typename U>
-    Channel& operator<<(U&& task) {
-        Add(std::forward<U>(task));
+    ThrottledChannel& operator<<(U&& value) {
+        Add(std::forward<U>(value));
         return *this;
     }
 
     std::optional<value_type> Get() {
-        return buffer.pop_front();
+        limiter.Acquire();
+        return give_back(channel.Get());
     }
 
     std::optional<value_type> TryGet() {
-        return buffer.try_pop();
+        if (!limiter.TryAcquire()) {
+            return std::nullopt;
+        }
+        return give_back(channel.TryGet());
     }
 
-    Channel& operator>>(std::optional<value_type>& get) {
-        get = Get();
-        return *this;
+    template <typename Rep, typename Period>
+    std::optional<value_type> GetFor(
+        std::chrono::duration<Rep, Period> const& timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        if (!limiter.AcquireFor(timeout)) {
+            return std::nullopt;
+        }
+        return give_back(channel.GetUntil(deadline));
     }
 
-    Channel& operator>>(value_type& get) {
-        std::optional<value_type> res = Get();
-        if (res.has_value()) {
-            get = std::move(res.value());
-        }
+    ThrottledChannel& operator>>(std::optional<value_type>& get) {
+        get = Get();
         return *this;
     }
 
     void Close() {
-        buffer.close();
+        channel.Close();
     }
 
     bool Runnable() const {
-        return buffer.runnable();
+        return channel.Runnable();
     }
 
     bool Readable() {
-        return buffer.readable();
+        return channel.Readable();
+    }
+
+    RateLimiter& GetLimiter() {
+        return limiter;
     }
 
     iterator begin() {
@@ -311,358 +6041,693 @@ public:
     }
 
 private:
-    Container buffer;
+    RateLimiter limiter;
+    Channel<Container> channel;
+
+    std::optional<value_type> give_back(std::optional<value_type>&& given) {
+        if (!given.has_value()) {
+            limiter.Release();
+        }
+        return std::move(given);
+    }
 };
 
 template <typename T>
-using LChannel = Channel<TSList<T>>;
+using ThrottledRChannel = ThrottledChannel<TSRingBuffer<T>>;
 
 template <typename T>
-using RChannel = Channel<TSRingBuffer<T>>;
+using ThrottledLChannel = ThrottledChannel<TSList<T>>;
 
 
-namespace LockFree {
-    template <typename T>
-    struct Node {
-        T data;
-        std::atomic<Node*> next;
+template <typename T, typename F>
+struct Selectable {
+    T& channel;
+    F action;
 
-        Node() : data(), next(nullptr) {
-            // Do Nothing
-        }
+    template <typename Fs>
+    Selectable(T& channel, Fs&& action)
+        : channel(channel), action(std::forward<Fs>(action)) {
+        // Do Nothing
+    }
+};
 
-        template <typename... U>
-        Node(U&&... data) : data(std::forward<U>(data)...), next(nullptr) {
-            // Do Nothing
-        }
-    };
+struct DefaultSelectable {
+    bool Readable() const {
+        return true;
+    }
 
-    template <typename T>
-    class List {
-    public:
-        List() : m_head(nullptr), m_tail(nullptr), m_runnable(true), m_size(0) {
-            // Do Nothing
-        }
+    std::optional<void*> TryGet() const {
+        return { nullptr };
+    }
 
-        ~List() {
-            m_runnable.store(false, std::memory_order_release);
+    static DefaultSelectable channel;
+};
+inline DefaultSelectable DefaultSelectable::channel;
 
-            Node<T>* node = m_head.load();
-            while (node != nullptr) {
-                Node<T>* next = node->next;
-                delete node;
-                node = next;
+template <typename T>
+struct case_m {
+    T& channel;
+
+    case_m(T& channel) : channel(channel) {
+        // Do Nothing
+    }
+
+    template <typename F>
+    Selectable<T, F> operator>>(F&& action) {
+        return Selectable<T, F>(channel, std::forward<F>(action));
+    }
+};
+
+inline case_m default_m(DefaultSelectable::channel);
+
+template <typename A, typename V>
+auto select_invoke(A&& action, V&& value) {
+    if constexpr (std::is_invocable_v<A, V>) {
+        return action(value);
+    }
+    else if constexpr (std::is_invocable_v<A>) {
+        return action();
+    }
+    return;
+}
+
+template <typename... T>
+void select(T&&... matches) {
+    auto readable = [](auto&... selectable) {
+        return (selectable.channel.Readable() || ...);
+    };
+
+    bool run = true;
+    auto try_action = [&](auto& match) {
+        if (run) {
+            auto opt = match.channel.TryGet();
+            if (opt.has_value()) {
+                run = false;
+                select_invoke(match.action, opt.value());
             }
         }
+    };
 
-        List(List const&) = delete;
-        List(List&&) = delete;
+    while (!readable(matches...))
+        ;
+    (try_action(matches), ...);
+}
 
-        List& operator=(List const&) = delete;
-        List& operator=(List&&) = delete;
+// Select over channels registered at runtime.
+// Channels notify on add and close, ready ones are queued without scan.
+// Readiness is edge triggered, caller drains returned channel with TryGet
+// until it is empty. Unregister channel before it is destroyed.
+class Selector : public ChannelWatcher {
+public:
+    Selector() : num_active(0) {
+        // Do Nothing
+    }
 
-        void push_back(T const& data) {
-            push_node(new Node<T>(data));
+    ~Selector() {
+        for (size_t id = 0; id < entries.size(); ++id) {
+            Unregister(id);
         }
+    }
 
-        void push_back(T&& data) {
-            push_node(new Node<T>(std::move(data)));
-        }
+    Selector(Selector const&) = delete;
+    Selector(Selector&&) = delete;
+
+    Selector& operator=(Selector const&) = delete;
+    Selector& operator=(Selector&&) = delete;
+
+    // id of the channel, reused after unregister
+    template <typename C>
+    size_t Register(C& channel) {
+        size_t id;
+        {
+            std::unique_lock lock(mutex);
+            if (free_ids.empty()) {
+                id = entries.size();
+                entries.emplace_back();
+            }
+            else {
+                id = free_ids.back();
+                free_ids.pop_back();
+            }
 
-        template <typename... U>
-        void emplace_back(U&&... args) {
-            push_node(new Node<T>(std::forward<U>(args)...));
+            ++num_active;
+            entries[id].active = true;
+            entries[id].unwatch = [&channel] { channel.Unwatch(); };
         }
 
-        void push_node(Node<T>* node) {
-            bool run = false;
-            Node<T>* prev = nullptr;
-            do {
-                run = runnable();
-                prev = m_tail.load(std::memory_order_relaxed);
-            } while (
-                run
-                && !m_tail.compare_exchange_weak(prev,
-                                                 node,
-                                                 std::memory_order_relaxed,
-                                                 std::memory_order_relaxed));
-            if (run) {
-                if (prev != nullptr) {
-                    prev->next.store(node, std::memory_order_relaxed);
-                }
-                else {
-                    m_head.store(node, std::memory_order_relaxed);
-                }
-                ++m_size;
+        // items added before watch are drained with the first readiness
+        channel.Watch(this, id);
+        Notify(id);
+        return id;
+    }
+
+    void Unregister(size_t id) {
+        std::function<void()> unwatch;
+        {
+            std::unique_lock lock(mutex);
+            if (id >= entries.size() || !entries[id].active) {
+                return;
             }
+            entries[id].active = false;
+            unwatch = std::move(entries[id].unwatch);
         }
 
-        template <typename U = decltype(platform::prevent_deadlock)>
-        std::optional<T> pop_front(U const& prevent_deadlock
-                                   = platform::prevent_deadlock) {
-            bool run = false;
-            Node<T>* node = nullptr;
-            do {
-                std::this_thread::sleep_for(prevent_deadlock);
+        // notifier in flight may wait for the lock
+        unwatch();
+
+        std::unique_lock lock(mutex);
+        free_ids.push_back(id);
+        --num_active;
+    }
+
+    size_t Wait() {
+        std::unique_lock lock(mutex);
+        std::optional<size_t> id;
+        cond.wait(lock, [&] { return (id = take()).has_value(); });
+        return id.value();
+    }
+
+    template <typename Rep, typename Period>
+    std::optional<size_t> WaitFor(
+        std::chrono::duration<Rep, Period> const& timeout) {
+        std::unique_lock lock(mutex);
+        std::optional<size_t> id;
+        cond.wait_for(lock, timeout, [&] {
+            return (id = take()).has_value();
+        });
+        return id;
+    }
+
+    std::optional<size_t> TryWait() {
+        std::unique_lock lock(mutex);
+        return take();
+    }
+
+    size_t Size() {
+        std::unique_lock lock(mutex);
+        return num_active;
+    }
+
+    void Notify(size_t id) override {
+        std::unique_lock lock(mutex);
+        Entry& entry = entries[id];
+        if (entry.active && !entry.queued) {
+            entry.queued = true;
+            ready.push_back(id);
+            cond.notify_one();
+        }
+    }
+
+private:
+    struct Entry {
+        bool active = false;
+        bool queued = false;
+        std::function<void()> unwatch;
+    };
 
-                run = readable();
-                node = m_head.load(std::memory_order_relaxed);
-            } while (run
-                     && (!node
-                         || !m_head.compare_exchange_weak(
-                             node,
-                             node->next,
-                             std::memory_order_relaxed,
-                             std::memory_order_relaxed)));
-            if (run) {
-                if (node->next == nullptr) {
-                    m_tail.store(nullptr, std::memory_order_relaxed);
-                }
-                --m_size;
-                T res = std::move(node->data);
+    std::mutex mutex;
+    std::condition_variable cond;
 
-                delete node;
-                return std::make_optional(std::move(res));
-            }
-            return std::nullopt;
-        }
+    std::vector<Entry> entries;
+    std::vector<size_t> free_ids;
+    std::deque<size_t> ready;
+    size_t num_active;
 
-        std::optional<T> try_pop() {
-            Node<T>* node = m_head.load(std::memory_order_relaxed);
-            if (readable() && node
-                && m_head.compare_exchange_weak(node,
-                                                node->next,
-                                                std::memory_order_relaxed,
-                                                std::memory_order_relaxed)) {
-                if (node->next == nullptr) {
-                    m_tail.store(nullptr, std::memory_order_relaxed);
-                }
-                --m_size;
-                T res = std::move(node->data);
+    // front of ready queue, skip unregistered ones
+    std::optional<size_t> take() {
+        while (!ready.empty()) {
+            size_t id = ready.front();
+            ready.pop_front();
 
-                delete node;
-                return std::make_optional(std::move(res));
+            entries[id].queued = false;
+            if (entries[id].active) {
+                return id;
             }
-            return std::nullopt;
         }
+        return std::nullopt;
+    }
+};
 
-        size_t size() const {
-            return m_size.load(std::memory_order_relaxed);
-        }
 
-        Node<T>* head() {
-            return m_head.load(std::memory_order_relaxed);
-        }
+// Counting semaphore whose acquirers may take several permits at once.
+// Permits are taken with compare exchange, waiters park only when
+// there are not enough of them. Small requests may overtake large ones.
+class Semaphore {
+public:
+    Semaphore(size_t permits) : permits(permits) {
+        // Do Nothing
+    }
 
-        Node<T>* tail() {
-            return m_tail.load(std::memory_order_relaxed);
-        }
+    Semaphore(Semaphore const&) = delete;
+    Semaphore(Semaphore&&) = delete;
 
-        bool runnable() const {
-            return m_runnable.load(std::memory_order_relaxed);
-        }
+    Semaphore& operator=(Semaphore const&) = delete;
+    Semaphore& operator=(Semaphore&&) = delete;
 
-        bool readable() const {
-            return runnable()
-                   || m_head.load(std::memory_order_relaxed) != nullptr;
+    void Acquire(size_t n = 1) {
+        if (TryAcquire(n)) {
+            return;
         }
 
-        void interrupt() {
-            m_runnable.store(false, std::memory_order_relaxed);
+        Trace::Span span("Semaphore::Acquire");
+        waiter.wait([&] { return TryAcquire(n); });
+    }
+
+    bool TryAcquire(size_t n = 1) {
+        size_t given = permits.load(std::memory_order_relaxed);
+        while (given >= n) {
+            if (permits.compare_exchange_weak(
+                    given, given - n, std::memory_order_acquire)) {
+                return true;
+            }
         }
+        return false;
+    }
 
-        void resume() {
-            m_runnable.store(true, std::memory_order_relaxed);
+    template <typename Clock, typename Duration>
+    bool AcquireUntil(size_t n,
+                      std::chrono::time_point<Clock, Duration> const& time) {
+        if (TryAcquire(n)) {
+            return true;
         }
 
-    private:
-        std::atomic<Node<T>*> m_head;
-        std::atomic<Node<T>*> m_tail;
+        Trace::Span span("Semaphore::Acquire");
+        return waiter.wait_until(time, [&] { return TryAcquire(n); });
+    }
 
-        std::atomic<bool> m_runnable;
-        std::atomic<size_t> m_size;
-    };
-}  // namespace LockFree
+    template <typename Rep, typename Period>
+    bool AcquireFor(size_t n,
+                    std::chrono::duration<Rep, Period> const& timeout) {
+        return AcquireUntil(n, std::chrono::steady_clock::now() + timeout);
+    }
 
+    template <typename Rep, typename Period>
+    bool AcquireFor(std::chrono::duration<Rep, Period> const& timeout) {
+        return AcquireFor(1, timeout);
+    }
 
-template <typename T, typename F>
-struct Selectable {
-    T& channel;
-    F action;
+    void Release(size_t n = 1) {
+        permits.fetch_add(n, std::memory_order_release);
+        waiter.notify();
+    }
 
-    template <typename Fs>
-    Selectable(T& channel, Fs&& action)
-        : channel(channel), action(std::forward<Fs>(action)) {
-        // Do Nothing
+    size_t Available() const {
+        return permits.load(std::memory_order_relaxed);
     }
+
+private:
+    std::atomic<size_t> permits;
+    Policy::Adaptive waiter;
 };
 
-struct DefaultSelectable {
-    bool Readable() const {
-        return true;
+// RAII guard of permits, released on destruction.
+class SemaphoreGuard {
+public:
+    SemaphoreGuard(Semaphore& semaphore, size_t n = 1)
+        : semaphore(semaphore), n(n) {
+        semaphore.Acquire(n);
     }
 
-    std::optional<void*> TryGet() const {
-        return { nullptr };
+    ~SemaphoreGuard() {
+        semaphore.Release(n);
     }
 
-    static DefaultSelectable channel;
+    SemaphoreGuard(SemaphoreGuard const&) = delete;
+    SemaphoreGuard(SemaphoreGuard&&) = delete;
+
+    SemaphoreGuard& operator=(SemaphoreGuard const&) = delete;
+    SemaphoreGuard& operator=(SemaphoreGuard&&) = delete;
+
+private:
+    Semaphore& semaphore;
+    size_t n;
 };
-DefaultSelectable DefaultSelectable::channel;
+
 
 template <typename T>
-struct case_m {
-    T& channel;
+using SharedChannel = Channel<SharedRingBuffer<T>>;
 
-    case_m(T& channel) : channel(channel) {
+
+// Value guarded by reader writer lock, reachable only in the scope of
+// with_read and with_write, so it could not be touched without lock.
+// Mutex should meet SharedMutex, std::shared_mutex works as well.
+template <typename T, typename Mutex = ShardedSharedMutex>
+class Synchronized {
+public:
+    template <typename... U>
+    Synchronized(U&&... args) : value(std::forward<U>(args)...) {
         // Do Nothing
     }
 
+    Synchronized(Synchronized const&) = delete;
+    Synchronized(Synchronized&&) = delete;
+
+    Synchronized& operator=(Synchronized const&) = delete;
+    Synchronized& operator=(Synchronized&&) = delete;
+
+    // readers run concurrently, func gets const reference
+    template <typename F>
+    decltype(auto) with_read(F&& func) const {
+        std::shared_lock lock(mutex);
+        return func(std::as_const(value));
+    }
+
     template <typename F>
-    Selectable<T, F> operator>>(F&& action) {
-        return Selectable<T, F>(channel, std::forward<F>(action));
+    decltype(auto) with_write(F&& func) {
+        std::unique_lock lock(mutex);
+        return func(value);
+    }
+
+    T copy() const {
+        return with_read([](T const& given) { return given; });
+    }
+
+    template <typename U>
+    void assign(U&& given) {
+        with_write([&](T& value) { value = std::forward<U>(given); });
     }
+
+private:
+    mutable Mutex mutex;
+    T value;
 };
 
-inline case_m default_m(DefaultSelectable::channel);
 
-template <typename A, typename V>
-auto select_invoke(A&& action, V&& value) {
-    if constexpr (std::is_invocable_v<A, V>) {
-        return action(value);
+class TimerService;
+
+// Channel like handle of a timer, usable in select.
+// Holds at most one pending expiration, later ticks are dropped until read.
+class Timer {
+public:
+    using clock = std::chrono::steady_clock;
+
+    Timer(TimerService* service, clock::duration period)
+        : service(service), period(period), expire(0), bucket(nullptr),
+          m_runnable(true) {
+        // Do Nothing
     }
-    else if constexpr (std::is_invocable_v<A>) {
-        return action();
+
+    Timer(Timer const&) = delete;
+    Timer(Timer&&) = delete;
+
+    Timer& operator=(Timer const&) = delete;
+    Timer& operator=(Timer&&) = delete;
+
+    std::optional<clock::time_point> Get() {
+        std::unique_lock lock(mutex);
+        cond.wait(lock, [&] { return !m_runnable || value.has_value(); });
+        return take();
     }
-    return;
-}
 
-template <typename... T>
-void select(T&&... matches) {
-    auto readable = [](auto&... selectable) {
-        return (selectable.channel.Readable() || ...);
-    };
+    std::optional<clock::time_point> TryGet() {
+        std::unique_lock lock(mutex);
+        return take();
+    }
 
-    bool run = true;
-    auto try_action = [&](auto& match) {
-        if (run) {
-            auto opt = match.channel.TryGet();
-            if (opt.has_value()) {
-                run = false;
-                select_invoke(match.action, opt.value());
-            }
-        }
-    };
+    bool Runnable() const {
+        return m_runnable;
+    }
 
-    while (!readable(matches...))
-        ;
-    (try_action(matches), ...);
-}
+    bool Readable() {
+        std::unique_lock lock(mutex);
+        return m_runnable || value.has_value();
+    }
 
+    // cancel timer, return true if it was still scheduled
+    bool Stop();
 
-template <typename T,
-          template <typename> class ChannelType = RChannel>
-class ThreadPool {
+private:
+    friend class TimerService;
+    using bucket_type = std::list<std::shared_ptr<Timer>>;
+
+    std::atomic<TimerService*> service;
+    clock::duration period;
+
+    uint64_t expire;
+    bucket_type* bucket;
+    bucket_type::iterator pos;
+
+    std::atomic<bool> m_runnable;
+    std::optional<clock::time_point> value;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    std::optional<clock::time_point> take() {
+        std::optional<clock::time_point> given = value;
+        value.reset();
+        return given;
+    }
+
+    void fire(clock::time_point now, bool last) {
+        std::unique_lock lock(mutex);
+        value = now;
+        if (last) {
+            m_runnable = false;
+        }
+        cond.notify_all();
+    }
+
+    void close() {
+        std::unique_lock lock(mutex);
+        m_runnable = false;
+        cond.notify_all();
+    }
+};
+
+// Hierarchical timing wheel driven by single thread.
+// Insert and cancel are O(1), wheel sleeps while there is no timer.
+class TimerService {
 public:
-    ThreadPool() : ThreadPool(std::thread::hardware_concurrency()) {
+    using clock = Timer::clock;
+
+    TimerService() : TimerService(std::chrono::milliseconds(1)) {
         // Do Nothing
     }
 
-    template <typename... Args>
-    ThreadPool(size_t num_threads, Args&&... args)
-        : runnable(true), num_threads(num_threads),
-          channel(std::forward<Args>(args)...),
-          threads(std::make_unique<std::thread[]>(num_threads)) {
-        for (size_t i = 0; i < num_threads; ++i) {
-            threads[i] = std::thread([this] {
-                while (runnable) {
-                    auto given = channel.Get();
-                    if (!given.has_value()) {
-                        break;
-                    }
-                    given.value()();
-                }
-            });
-        }
+    TimerService(clock::duration resolution)
+        : resolution(resolution), runnable(true), num_timers(0), current(0),
+          start(clock::now()) {
+        worker = std::thread([this] { run(); });
     }
 
-    ~ThreadPool() {
+    ~TimerService() {
         Stop();
     }
 
-    ThreadPool(const ThreadPool&) = delete;
-    ThreadPool(ThreadPool&&) = delete;
+    TimerService(TimerService const&) = delete;
+    TimerService(TimerService&&) = delete;
 
-    ThreadPool& operator=(const ThreadPool&) = delete;
-    ThreadPool& operator=(ThreadPool&&) = delete;
+    TimerService& operator=(TimerService const&) = delete;
+    TimerService& operator=(TimerService&&) = delete;
 
-    template <typename F>
-    std::future<T> Add(F&& task) {
-        std::packaged_task<T()> ptask(std::forward<F>(task));
-        std::future<T> fut = ptask.get_future();
-        channel.Add(std::move(ptask));
-        return fut;
+    std::shared_ptr<Timer> After(clock::duration dur) {
+        return schedule(clock::now() + dur, clock::duration::zero());
     }
 
-    size_t GetNumThreads() const {
-        return num_threads;
+    std::shared_ptr<Timer> Deadline(clock::time_point time) {
+        return schedule(time, clock::duration::zero());
+    }
+
+    std::shared_ptr<Timer> Tick(clock::duration dur) {
+        dur = std::max(dur, resolution);
+        return schedule(clock::now() + dur, dur);
+    }
+
+    size_t Size() {
+        std::unique_lock lock(mutex);
+        return num_timers;
     }
 
     void Stop() {
-        if (threads != nullptr) {
+        {
+            std::unique_lock lock(mutex);
+            if (!runnable) {
+                return;
+            }
             runnable = false;
-            channel.Close();
 
-            for (size_t i = 0; i < num_threads; ++i) {
-                if (threads[i].joinable()) {
-                    threads[i].join();
+            for (auto& level : wheel) {
+                for (auto& bucket : level) {
+                    for (auto& timer : bucket) {
+                        timer->service = nullptr;
+                        timer->bucket = nullptr;
+                        timer->close();
+                    }
+                    bucket.clear();
                 }
             }
-            threads.reset();
+            num_timers = 0;
+            cond.notify_all();
+        }
+
+        if (worker.joinable()) {
+            worker.join();
         }
     }
 
 private:
-    bool runnable;
-    size_t num_threads;
+    friend class Timer;
+    using bucket_type = Timer::bucket_type;
 
-    ChannelType<std::packaged_task<T()>> channel;
-    std::unique_ptr<std::thread[]> threads;
-};
+    static constexpr size_t num_bits = 6;
+    static constexpr size_t num_slots = 1 << num_bits;
+    static constexpr size_t num_levels = 4;
+    static constexpr uint64_t max_delta = 1ull << (num_bits * num_levels);
 
-template <typename T>
-using LThreadPool = ThreadPool<T, LChannel>;
+    clock::duration resolution;
+    bool runnable;
+    size_t num_timers;
 
+    uint64_t current;
+    clock::time_point start;
+    bucket_type wheel[num_levels][num_slots];
 
-using ull = unsigned long long;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread worker;
 
-class WaitGroup {
-public:
-    WaitGroup() : visit(0) {
-        // Do Nothing
+    uint64_t floor_tick(clock::time_point time) const {
+        if (time <= start) {
+            return 0;
+        }
+        return (time - start) / resolution;
     }
 
-    WaitGroup(ull visit) : visit(visit) {
-        // Do Nothing
+    uint64_t ceil_tick(clock::time_point time) const {
+        if (time <= start) {
+            return 0;
+        }
+        return (time - start + resolution - clock::duration(1)) / resolution;
     }
 
-    ull Add() {
-        return (visit += 1);
+    std::shared_ptr<Timer> schedule(clock::time_point time,
+                                    clock::duration period) {
+        auto timer = std::make_shared<Timer>(this, period);
+
+        std::unique_lock lock(mutex);
+        if (!runnable) {
+            timer->service = nullptr;
+            timer->close();
+            return timer;
+        }
+
+        if (num_timers == 0) {
+            // wheel is empty, catch up idle time
+            current = std::max(current, floor_tick(clock::now()));
+        }
+        timer->expire = std::max(ceil_tick(time), current + 1);
+
+        bucket_type single;
+        single.push_back(timer);
+        insert(single, single.begin());
+
+        if (num_timers++ == 0) {
+            cond.notify_all();
+        }
+        return timer;
     }
 
-    ull Done() {
-        return (visit -= 1);
+    bool cancel(Timer& timer) {
+        std::unique_lock lock(mutex);
+        if (timer.bucket == nullptr) {
+            return false;
+        }
+
+        timer.bucket->erase(timer.pos);
+        timer.bucket = nullptr;
+        --num_timers;
+        return true;
     }
 
-    void Wait() {
-        while (visit > 0) {
-            std::this_thread::yield();
+    // move timer from given bucket to the slot of its expiration
+    void insert(bucket_type& from, bucket_type::iterator iter) {
+        Timer& timer = **iter;
+        uint64_t delta = timer.expire - current;
+
+        uint64_t place = timer.expire;
+        if (delta >= max_delta) {
+            place = current + max_delta - 1;
+            delta = max_delta - 1;
+        }
+
+        size_t level = 0;
+        while (delta >= (1ull << (num_bits * (level + 1)))) {
+            ++level;
         }
+
+        bucket_type& target =
+            wheel[level][(place >> (num_bits * level)) & (num_slots - 1)];
+        target.splice(target.end(), from, iter);
+
+        timer.bucket = &target;
+        timer.pos = iter;
     }
 
-private:
-    std::atomic<ull> visit;
+    void advance(clock::time_point now) {
+        ++current;
+        for (size_t level = 1; level < num_levels; ++level) {
+            if ((current & ((1ull << (num_bits * level)) - 1)) != 0) {
+                break;
+            }
+
+            bucket_type moving;
+            moving.splice(moving.end(),
+                          wheel[level][(current >> (num_bits * level))
+                                       & (num_slots - 1)]);
+            while (!moving.empty()) {
+                insert(moving, moving.begin());
+            }
+        }
+
+        bucket_type expired;
+        expired.splice(expired.end(), wheel[0][current & (num_slots - 1)]);
+        while (!expired.empty()) {
+            Timer& timer = *expired.front();
+            if (timer.period > clock::duration::zero()) {
+                timer.fire(now, false);
+                timer.expire =
+                    current
+                    + std::max<uint64_t>(1, timer.period / resolution);
+                insert(expired, expired.begin());
+            }
+            else {
+                timer.fire(now, true);
+                timer.bucket = nullptr;
+                expired.pop_front();
+                --num_timers;
+            }
+        }
+    }
+
+    void run() {
+        std::unique_lock lock(mutex);
+        while (runnable) {
+            if (num_timers == 0) {
+                cond.wait(lock, [&] { return !runnable || num_timers > 0; });
+                continue;
+            }
+
+            clock::time_point now = clock::now();
+            uint64_t target = floor_tick(now);
+            while (current < target && num_timers > 0) {
+                advance(now);
+            }
+            cond.wait_until(lock, start + (current + 1) * resolution);
+        }
+    }
 };
 
+inline bool Timer::Stop() {
+    bool scheduled = false;
+    TimerService* owner = service;
+    if (owner != nullptr) {
+        scheduled = owner->cancel(*this);
+    }
+
+    close();
+    return scheduled;
+}
+
 
 #endif
@@ -0,0 +1,4 @@
+#include "concurrency.hpp"
+#include "extern_template.hpp"
+
+CONCURRENCY_INSTANTIATE(template)
\ No newline at end of file
@@ -0,0 +1,110 @@
+// C++20 module interface, headers stay in global module fragment
+// so that code including them and importing the module agree.
+module;
+
+#include "concurrency.hpp"
+
+export module concurrency;
+
+export using ::ull;
+
+export using ::Actor;
+export using ::AdaptiveMutex;
+export using ::Barrier;
+export using ::BlockingRegion;
+export using ::BoundedQueue;
+export using ::Channel;
+export using ::ChannelIterator;
+export using ::ChannelWatcher;
+export using ::ConcurrentHashMap;
+export using ::InboxThreadPool;
+export using ::Latch;
+export using ::LChannel;
+export using ::LThreadPool;
+export using ::MappedChannel;
+export using ::MappedQueue;
+export using ::MpscChannel;
+export using ::ObjectPool;
+export using ::PolicyChannel;
+export using ::Pooled;
+export using ::RateLimiter;
+export using ::RChannel;
+export using ::RcuCell;
+export using ::RcuDomain;
+export using ::RcuReadGuard;
+export using ::RingBuffer;
+export using ::SegmentChannel;
+export using ::Semaphore;
+export using ::SemaphoreGuard;
+export using ::ShardedChannel;
+export using ::ShardedQueue;
+export using ::ShardedSharedMutex;
+export using ::SharedChannel;
+export using ::SharedRingBuffer;
+export using ::SpinLock;
+export using ::Synchronized;
+export using ::TaskBatch;
+export using ::ThreadPool;
+export using ::ThreadSafe;
+export using ::ThrottledChannel;
+export using ::ThrottledLChannel;
+export using ::ThrottledRChannel;
+export using ::TicketLock;
+export using ::Timer;
+export using ::TimerService;
+export using ::TSList;
+export using ::TSMappedQueue;
+export using ::TSRingBuffer;
+export using ::WaitGroup;
+export using ::WalkOptions;
+
+export using ::parallel_for;
+export using ::parallel_inclusive_scan;
+export using ::parallel_reduce;
+export using ::parallel_sort;
+export using ::parallel_walk;
+
+export using ::case_m;
+export using ::default_m;
+export using ::DefaultSelectable;
+export using ::select;
+export using ::Selectable;
+export using ::Selector;
+
+export namespace LockFree {
+    using LockFree::IntrusiveMpsc;
+    using LockFree::List;
+    using LockFree::MpscHook;
+    using LockFree::MpscQueue;
+    using LockFree::SegmentQueue;
+}  // namespace LockFree
+
+export namespace Pipeline {
+    using Pipeline::batch;
+    using Pipeline::Completion;
+    using Pipeline::filter;
+    using Pipeline::Flow;
+    using Pipeline::from;
+    using Pipeline::map;
+    using Pipeline::operator|;
+    using Pipeline::ordered_map;
+    using Pipeline::Runtime;
+    using Pipeline::sink;
+    using Pipeline::source;
+}  // namespace Pipeline
+
+export namespace Policy {
+    using Policy::Adaptive;
+    using Policy::Multi;
+    using Policy::Park;
+    using Policy::Single;
+    using Policy::Spin;
+    using Policy::unbounded;
+}  // namespace Policy
+
+export namespace Trace {
+    using Trace::dump;
+    using Trace::enabled;
+    using Trace::Recorder;
+    using Trace::Span;
+}  // namespace Trace
\ No newline at end of file
@@ -1,14 +1,48 @@
 #ifndef CONCURRENCY_HPP
 #define CONCURRENCY_HPP
 
+#include "impl/platform/config.hpp"
 #include "impl/platform/constant.hpp"
+#include "impl/platform/cpu.hpp"
+#include "impl/platform/mapped_file.hpp"
+#include "impl/platform/shared_memory.hpp"
+#include "impl/container/bounded_queue.hpp"
+#include "impl/container/concurrent_map.hpp"
+#include "impl/container/mapped_queue.hpp"
 #include "impl/container/ring_buffer.hpp"
+#include "impl/container/sharded_queue.hpp"
+#include "impl/container/shared_ring_buffer.hpp"
 #include "impl/container/thread_safe.hpp"
 #include "impl/lockfree/list.hpp"
+#include "impl/lockfree/mpsc_queue.hpp"
+#include "impl/lockfree/segment_queue.hpp"
+#include "impl/actor.hpp"
+#include "impl/barrier.hpp"
 #include "impl/channel_iter.hpp"
 #include "impl/channel.hpp"
+#include "impl/mapped_channel.hpp"
+#include "impl/mutex.hpp"
+#include "impl/object_pool.hpp"
+#include "impl/parallel_algorithm.hpp"
+#include "impl/parallel_walk.hpp"
+#include "impl/pipeline.hpp"
+#include "impl/policy.hpp"
+#include "impl/policy_channel.hpp"
+#include "impl/rate_limiter.hpp"
+#include "impl/rcu.hpp"
 #include "impl/select.hpp"
+#include "impl/semaphore.hpp"
+#include "impl/shared_channel.hpp"
+#include "impl/synchronized.hpp"
 #include "impl/thread_pool.hpp"
+#include "impl/timer.hpp"
+#include "impl/trace.hpp"
 #include "impl/wait_group.hpp"
 
+// defined by concurrency library target, which has them compiled
+#ifdef CONCURRENCY_EXTERN_TEMPLATE
+#include "extern_template.hpp"
+CONCURRENCY_INSTANTIATE(extern template)
+#endif
+
 #endif
\ No newline at end of file
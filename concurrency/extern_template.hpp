@@ -0,0 +1,24 @@
+#ifndef CONCURRENCY_EXTERN_TEMPLATE_HPP
+#define CONCURRENCY_EXTERN_TEMPLATE_HPP
+
+#include <functional>
+
+#include "impl/channel.hpp"
+#include "impl/thread_pool.hpp"
+
+// Common specializations compiled once into concurrency library.
+// Units linking it declare them extern and skip instantiation,
+// library defines them in concurrency.cpp.
+#define CONCURRENCY_INSTANTIATE(prefix)                         \
+    prefix class RingBuffer<int>;                               \
+    prefix class ThreadSafe<RingBuffer<int>>;                   \
+    prefix class Channel<TSRingBuffer<int>>;                    \
+    prefix class RingBuffer<std::function<void()>>;             \
+    prefix class ThreadSafe<RingBuffer<std::function<void()>>>; \
+    prefix class Channel<TSRingBuffer<std::function<void()>>>;  \
+    prefix class ThreadPool<void, RChannel>;                    \
+    prefix class ThreadPool<int, RChannel>;                     \
+    prefix class ThreadPool<void, LChannel>;                    \
+    prefix class InboxThreadPool<void>;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,158 @@
+#ifndef ACTOR_HPP
+#define ACTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "policy.hpp"
+#include "thread_pool.hpp"
+#include "lockfree/mpsc_queue.hpp"
+
+// Mailbox with behavior, scheduled onto shared pool only if it has messages.
+// Single activation runs at a time and handles up to batch_size messages,
+// so behavior needs no lock and many actors share few threads.
+// Pool should outlive the actor and the messages sent to it.
+template <typename Msg, typename Pool = ThreadPool<void>>
+class Actor {
+public:
+    template <typename F>
+    Actor(Pool& pool, F&& behavior, size_t batch_size = 64)
+        : state(std::make_shared<State>(
+            pool, std::forward<F>(behavior), batch_size)) {
+        // Do Nothing
+    }
+
+    // stop accepting, pending messages are still handled
+    ~Actor() {
+        Close();
+    }
+
+    Actor(Actor const&) = delete;
+    Actor(Actor&&) = default;
+
+    Actor& operator=(Actor const&) = delete;
+    Actor& operator=(Actor&&) = default;
+
+    template <typename... U>
+    bool Send(U&&... args) {
+        return state->send(std::forward<U>(args)...);
+    }
+
+    template <typename U>
+    Actor& operator<<(U&& msg) {
+        Send(std::forward<U>(msg));
+        return *this;
+    }
+
+    void Close() {
+        if (state != nullptr) {
+            state->runnable = false;
+        }
+    }
+
+    bool Runnable() const {
+        return state->runnable;
+    }
+
+    size_t Pending() const {
+        return state->pending;
+    }
+
+    // wait until mailbox is drained, rethrow first failure of behavior
+    void Wait() {
+        state->wait();
+    }
+
+private:
+    struct State : std::enable_shared_from_this<State> {
+        Pool& pool;
+        std::function<void(Msg&)> behavior;
+        size_t batch_size;
+
+        LockFree::MpscQueue<Msg, Policy::Spin> mailbox;
+        std::atomic<bool> runnable;
+
+        // sender publishes pending before it looks at scheduled,
+        // activation clears scheduled before it looks at pending
+        std::atomic<size_t> pending;
+        std::atomic<bool> scheduled;
+
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::exception_ptr error;
+
+        template <typename F>
+        State(Pool& pool, F&& behavior, size_t batch_size)
+            : pool(pool), behavior(std::forward<F>(behavior)),
+              batch_size(std::max<size_t>(batch_size, 1)), runnable(true),
+              pending(0), scheduled(false) {
+            // Do Nothing
+        }
+
+        template <typename... U>
+        bool send(U&&... args) {
+            if (!runnable
+                || !mailbox.try_emplace_back(std::forward<U>(args)...)) {
+                return false;
+            }
+
+            ++pending;
+            if (!scheduled.exchange(true)) {
+                schedule();
+            }
+            return true;
+        }
+
+        void schedule() {
+            pool.Add([self = this->shared_from_this()] { self->run(); });
+        }
+
+        void run() {
+            for (size_t i = 0; i < batch_size && pending > 0; ++i) {
+                try {
+                    mailbox.consume_front(behavior);
+                }
+                catch (...) {
+                    std::unique_lock lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                --pending;
+            }
+
+            // requeue behind other actors instead of holding the worker
+            if (pending > 0) {
+                schedule();
+                return;
+            }
+
+            scheduled = false;
+            if (pending > 0 && !scheduled.exchange(true)) {
+                schedule();
+                return;
+            }
+
+            std::unique_lock lock(mutex);
+            cond.notify_all();
+        }
+
+        void wait() {
+            std::unique_lock lock(mutex);
+            cond.wait(lock, [&] { return pending == 0 && !scheduled; });
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+
+    std::shared_ptr<State> state;
+};
+
+#endif
\ No newline at end of file
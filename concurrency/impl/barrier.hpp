@@ -0,0 +1,204 @@
+#ifndef BARRIER_HPP
+#define BARRIER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "platform/constant.hpp"
+#include "policy.hpp"
+#include "trace.hpp"
+
+// One shot counter, waiters are released once it counts down to zero.
+class Latch {
+public:
+    Latch(size_t expected) : count(expected) {
+        // Do Nothing
+    }
+
+    Latch(Latch const&) = delete;
+    Latch(Latch&&) = delete;
+
+    Latch& operator=(Latch const&) = delete;
+    Latch& operator=(Latch&&) = delete;
+
+    void CountDown(size_t n = 1) {
+        if (count.fetch_sub(n) == n) {
+            waiter.notify();
+        }
+    }
+
+    bool TryWait() const {
+        return count.load(std::memory_order_acquire) == 0;
+    }
+
+    void Wait() {
+        Trace::Span span("Latch::Wait");
+        waiter.wait([&] { return TryWait(); });
+    }
+
+    void ArriveAndWait(size_t n = 1) {
+        CountDown(n);
+        Wait();
+    }
+
+private:
+    std::atomic<size_t> count;
+    Policy::Adaptive waiter;
+};
+
+// Reusable barrier of fixed number of threads per phase.
+// Arrivals are combined in a tree of small counters, so threads hit
+// different cache lines and only the last of each node climbs up.
+// Last one at the root runs completion, resets counters and opens
+// the next phase.
+class Barrier {
+public:
+    Barrier(size_t expected, std::function<void()> completion = nullptr)
+        : expected(std::max<size_t>(expected, 1)),
+          completion(std::move(completion)), m_phase(0) {
+        build();
+    }
+
+    Barrier(Barrier const&) = delete;
+    Barrier(Barrier&&) = delete;
+
+    Barrier& operator=(Barrier const&) = delete;
+    Barrier& operator=(Barrier&&) = delete;
+
+    // arrive without waiting, returns phase token for Wait
+    size_t Arrive() {
+        size_t phase = m_phase.load(std::memory_order_acquire);
+
+        size_t node = 0;
+        bool last = seat(node);
+        while (last) {
+            node = nodes[node].parent;
+            if (node == npos) {
+                complete();
+                break;
+            }
+            Node& current = nodes[node];
+            size_t count =
+                current.count.fetch_add(1, std::memory_order_acq_rel) + 1;
+            last = count == current.capacity;
+        }
+        return phase;
+    }
+
+    void Wait(size_t phase) {
+        Trace::Span span("Barrier::Wait");
+        waiter.wait([&] {
+            return m_phase.load(std::memory_order_acquire) != phase;
+        });
+    }
+
+    void ArriveAndWait() {
+        Wait(Arrive());
+    }
+
+    size_t GetExpected() const {
+        return expected;
+    }
+
+    size_t GetPhase() const {
+        return m_phase.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t fan_in = 4;
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    struct alignas(platform::cache_line) Node {
+        std::atomic<size_t> count;
+        size_t capacity;
+        size_t parent;
+    };
+
+    size_t expected;
+    std::function<void()> completion;
+
+    size_t num_leaves;
+    size_t num_nodes;
+    std::unique_ptr<Node[]> nodes;
+
+    alignas(platform::cache_line) std::atomic<size_t> m_phase;
+    Policy::Adaptive waiter;
+
+    // leaves split arrivals evenly, each upper node counts its children
+    void build() {
+        std::vector<size_t> capacity;
+        std::vector<size_t> parent;
+
+        num_leaves = (expected + fan_in - 1) / fan_in;
+        for (size_t i = 0; i < num_leaves; ++i) {
+            capacity.push_back(expected * (i + 1) / num_leaves
+                               - expected * i / num_leaves);
+        }
+        parent.resize(num_leaves, npos);
+
+        size_t begin = 0;
+        size_t size = num_leaves;
+        while (size > 1) {
+            size_t next = (size + fan_in - 1) / fan_in;
+            size_t next_begin = capacity.size();
+            for (size_t i = 0; i < next; ++i) {
+                size_t lo = size * i / next;
+                size_t hi = size * (i + 1) / next;
+                capacity.push_back(hi - lo);
+                parent.push_back(npos);
+                for (size_t child = lo; child < hi; ++child) {
+                    parent[begin + child] = next_begin + i;
+                }
+            }
+            begin = next_begin;
+            size = next;
+        }
+
+        num_nodes = capacity.size();
+        nodes = std::make_unique<Node[]>(num_nodes);
+        for (size_t i = 0; i < num_nodes; ++i) {
+            nodes[i].count.store(0, std::memory_order_relaxed);
+            nodes[i].capacity = capacity[i];
+            nodes[i].parent = parent[i];
+        }
+    }
+
+    // Take a seat at leaf, starting from the one of this thread,
+    // true if it was the last seat there. Seats sum up to expected,
+    // so one is always left, and leaves counted over are reset with
+    // others at the end of phase.
+    bool seat(size_t& node) {
+        std::thread::id id = std::this_thread::get_id();
+        size_t start = std::hash<std::thread::id>()(id);
+        for (size_t i = 0;; ++i) {
+            node = (start + i) % num_leaves;
+            Node& leaf = nodes[node];
+            size_t taken = leaf.count.fetch_add(1, std::memory_order_acq_rel);
+            if (taken < leaf.capacity) {
+                return taken + 1 == leaf.capacity;
+            }
+        }
+    }
+
+    void complete() {
+        if (completion) {
+            completion();
+        }
+
+        for (size_t i = 0; i < num_nodes; ++i) {
+            nodes[i].count.store(0, std::memory_order_relaxed);
+        }
+
+        m_phase.fetch_add(1, std::memory_order_release);
+        waiter.notify();
+    }
+};
+
+#endif
\ No newline at end of file
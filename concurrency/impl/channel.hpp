@@ -1,10 +1,25 @@
 #ifndef CHANNEL_HPP
 #define CHANNEL_HPP
 
+#include <atomic>
+#include <chrono>
 #include <optional>
+#include <thread>
 
 #include "channel_iter.hpp"
+#include "container/sharded_queue.hpp"
 #include "container/thread_safe.hpp"
+#include "lockfree/mpsc_queue.hpp"
+#include "lockfree/segment_queue.hpp"
+
+// Observer of channel readiness, see Selector.
+class ChannelWatcher {
+public:
+    virtual void Notify(size_t key) = 0;
+
+protected:
+    ~ChannelWatcher() = default;
+};
 
 template <typename Container>
 class Channel {
@@ -13,7 +28,9 @@ public:
     using iterator = ChannelIterator<value_type, Channel<Container>>;
 
     template <typename... U>
-    Channel(U&&... args) : buffer(std::forward<U>(args)...) {
+    Channel(U&&... args)
+        : buffer(std::forward<U>(args)...), watcher(nullptr), notifying(0),
+          watch_key(0) {
         // Do Nothing
     }
 
@@ -26,6 +43,56 @@ public:
     template <typename... U>
     void Add(U&&... args) {
         buffer.emplace_back(std::forward<U>(args)...);
+        notify_watcher();
+    }
+
+    // Add range in one step, requires push_back_range from container,
+    // e.g. ThreadSafe. Returns number added, less only if closed.
+    template <typename It>
+    size_t AddBulk(It first, It last) {
+        size_t added = buffer.push_back_range(first, last);
+        if (added > 0) {
+            notify_watcher();
+        }
+        return added;
+    }
+
+    // return false instead of blocking if channel is full or closed
+    template <typename... U>
+    bool TryAdd(U&&... args) {
+        bool added = buffer.try_emplace_back(std::forward<U>(args)...);
+        if (added) {
+            notify_watcher();
+        }
+        return added;
+    }
+
+    template <typename Rep, typename Period, typename... U>
+    bool AddFor(std::chrono::duration<Rep, Period> const& timeout,
+                U&&... args) {
+        return AddUntil(std::chrono::steady_clock::now() + timeout,
+                        std::forward<U>(args)...);
+    }
+
+    template <typename Clock, typename Duration, typename... U>
+    bool AddUntil(std::chrono::time_point<Clock, Duration> const& time,
+                  U&&... args) {
+        bool added =
+            buffer.emplace_back_until(time, std::forward<U>(args)...);
+        if (added) {
+            notify_watcher();
+        }
+        return added;
+    }
+
+    auto Reserve() {
+        return buffer.reserve_back();
+    }
+
+    template <typename R>
+    void Commit(R& slot) {
+        slot.commit();
+        notify_watcher();
     }
 
     template <typename U>
@@ -42,6 +109,23 @@ public:
         return buffer.try_pop();
     }
 
+    template <typename Rep, typename Period>
+    std::optional<value_type> GetFor(
+        std::chrono::duration<Rep, Period> const& timeout) {
+        return GetUntil(std::chrono::steady_clock::now() + timeout);
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> GetUntil(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        return buffer.pop_front_until(time);
+    }
+
+    template <typename F>
+    bool Consume(F&& func) {
+        return buffer.consume_front(std::forward<F>(func));
+    }
+
     Channel& operator>>(std::optional<value_type>& get) {
         get = Get();
         return *this;
@@ -57,6 +141,7 @@ public:
 
     void Close() {
         buffer.close();
+        notify_watcher();
     }
 
     bool Runnable() const {
@@ -75,8 +160,39 @@ public:
         return iterator(*this, std::nullopt);
     }
 
+    // notify watcher with key after each add and close, one at a time
+    void Watch(ChannelWatcher* given, size_t key) {
+        watch_key = key;
+        watcher = given;
+    }
+
+    // waits notification in flight, so watcher could be released after
+    void Unwatch() {
+        watcher = nullptr;
+        while (notifying > 0) {
+            std::this_thread::yield();
+        }
+    }
+
 private:
     Container buffer;
+
+    std::atomic<ChannelWatcher*> watcher;
+    std::atomic<size_t> notifying;
+    size_t watch_key;
+
+    // unwatched channel pays a single load
+    void notify_watcher() {
+        if (watcher.load(std::memory_order_relaxed) == nullptr) {
+            return;
+        }
+
+        ++notifying;
+        if (ChannelWatcher* given = watcher.load()) {
+            given->Notify(watch_key);
+        }
+        --notifying;
+    }
 };
 
 template <typename T>
@@ -85,4 +201,13 @@ using LChannel = Channel<TSList<T>>;
 template <typename T>
 using RChannel = Channel<TSRingBuffer<T>>;
 
+template <typename T>
+using ShardedChannel = Channel<ShardedQueue<T>>;
+
+template <typename T>
+using MpscChannel = Channel<LockFree::MpscQueue<T>>;
+
+template <typename T>
+using SegmentChannel = Channel<LockFree::SegmentQueue<T>>;
+
 #endif
\ No newline at end of file
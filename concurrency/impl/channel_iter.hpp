@@ -24,8 +24,9 @@ public:
         return *this;
     }
 
+    // end of channel is only iterator without value
     bool operator!=(ChannelIterator const& other) const {
-        return item != other.item;
+        return item.has_value() != other.item.has_value();
     }
 
 private:
@@ -0,0 +1,267 @@
+#ifndef CONTAINER_BOUNDED_QUEUE_HPP
+#define CONTAINER_BOUNDED_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "../platform/constant.hpp"
+#include "../policy.hpp"
+
+// Bounded queue on ring of sequenced cells, sequence of a cell tells
+// whether it is free or published, so producers and consumers share no lock.
+// Single producer or consumer side moves its index without compare exchange.
+template <typename T,
+          typename Producers = Policy::Multi,
+          typename Consumers = Policy::Multi,
+          typename Wait = Policy::Park,
+          typename Alloc = std::allocator<T>>
+class BoundedQueue {
+public:
+    using value_type = T;
+
+    BoundedQueue(size_t size_buffer, Alloc const& alloc = Alloc())
+        : alloc(alloc), size_buffer(std::max<size_t>(size_buffer, 1)),
+          cells(cell_traits::allocate(this->alloc, this->size_buffer)),
+          m_runnable(true), head(0), tail(0) {
+        for (size_t i = 0; i < this->size_buffer; ++i) {
+            cell_traits::construct(this->alloc, cells + i);
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~BoundedQueue() {
+        close();
+        while (dequeue([](T&) {}))
+            ;
+
+        for (size_t i = 0; i < size_buffer; ++i) {
+            cell_traits::destroy(alloc, cells + i);
+        }
+        cell_traits::deallocate(alloc, cells, size_buffer);
+    }
+
+    BoundedQueue(BoundedQueue const&) = delete;
+    BoundedQueue(BoundedQueue&&) = delete;
+
+    BoundedQueue& operator=(BoundedQueue const&) = delete;
+    BoundedQueue& operator=(BoundedQueue&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        waiter.wait([&] {
+            return !m_runnable || enqueue(std::forward<U>(args)...);
+        });
+        waiter.notify();
+    }
+
+    void push_back(value_type const& value) {
+        emplace_back(value);
+    }
+
+    void push_back(value_type&& value) {
+        emplace_back(std::move(value));
+    }
+
+    template <typename... U>
+    bool try_emplace_back(U&&... args) {
+        if (!m_runnable || !enqueue(std::forward<U>(args)...)) {
+            return false;
+        }
+        waiter.notify();
+        return true;
+    }
+
+    template <typename Clock, typename Duration, typename... U>
+    bool emplace_back_until(
+        std::chrono::time_point<Clock, Duration> const& time, U&&... args) {
+        bool pushed = false;
+        waiter.wait_until(time, [&] {
+            if (!m_runnable) {
+                return true;
+            }
+            pushed = enqueue(std::forward<U>(args)...);
+            return pushed;
+        });
+
+        if (pushed) {
+            waiter.notify();
+        }
+        return pushed;
+    }
+
+    std::optional<value_type> pop_front() {
+        std::optional<value_type> given;
+        consume_front([&](value_type& item) { given = std::move(item); });
+        return given;
+    }
+
+    std::optional<value_type> try_pop() {
+        std::optional<value_type> given;
+        if (dequeue([&](value_type& item) { given = std::move(item); })) {
+            waiter.notify();
+        }
+        return given;
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> pop_front_until(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        std::optional<value_type> given;
+        auto take = [&](value_type& item) { given = std::move(item); };
+
+        bool consumed = false;
+        waiter.wait_until(time, [&] {
+            consumed = dequeue(take);
+            return consumed || !m_runnable;
+        });
+
+        if (consumed || dequeue(take)) {
+            waiter.notify();
+        }
+        return given;
+    }
+
+    // after close, items published before it are still consumed
+    template <typename F>
+    bool consume_front(F&& func) {
+        bool consumed = false;
+        waiter.wait([&] {
+            consumed = dequeue(func);
+            return consumed || !m_runnable;
+        });
+
+        if (!consumed) {
+            consumed = dequeue(func);
+        }
+        if (consumed) {
+            waiter.notify();
+        }
+        return consumed;
+    }
+
+    void close() {
+        m_runnable = false;
+        waiter.notify();
+    }
+
+    bool runnable() const {
+        return m_runnable;
+    }
+
+    bool readable() {
+        return m_runnable || size() > 0;
+    }
+
+    size_t size() const {
+        size_t popped = head.load();
+        size_t pushed = tail.load();
+        return pushed > popped ? pushed - popped : 0;
+    }
+
+    size_t max_size() const {
+        return size_buffer;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* get() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    using cell_alloc =
+        typename std::allocator_traits<Alloc>::template rebind_alloc<Cell>;
+    using cell_traits = std::allocator_traits<cell_alloc>;
+
+    static constexpr bool single_producer =
+        std::is_same_v<Producers, Policy::Single>;
+    static constexpr bool single_consumer =
+        std::is_same_v<Consumers, Policy::Single>;
+
+    cell_alloc alloc;
+    size_t size_buffer;
+    Cell* cells;
+
+    std::atomic<bool> m_runnable;
+    Wait waiter;
+
+    alignas(platform::cache_line) std::atomic<size_t> head;
+    alignas(platform::cache_line) std::atomic<size_t> tail;
+
+    // claim index of cell whose sequence is expected, false if not ready
+    template <bool single>
+    bool claim(std::atomic<size_t>& index, size_t offset, size_t& pos) {
+        pos = index.load(std::memory_order_relaxed);
+        while (true) {
+            size_t seq = cells[pos % size_buffer].sequence.load(
+                std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - (pos + offset));
+
+            if (diff < 0) {
+                return false;
+            }
+            if (diff > 0) {
+                pos = index.load(std::memory_order_relaxed);
+            }
+            else if constexpr (single) {
+                index.store(pos + 1, std::memory_order_relaxed);
+                return true;
+            }
+            else if (index.compare_exchange_weak(
+                         pos, pos + 1, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    // waiter may run enqueue and dequeue under its own lock,
+    // so they never notify and callers do it after the wait
+    template <typename... U>
+    bool enqueue(U&&... args) {
+        size_t pos;
+        if (!claim<single_producer>(tail, 0, pos)) {
+            return false;
+        }
+
+        Cell& cell = cells[pos % size_buffer];
+        new (cell.storage) T(std::forward<U>(args)...);
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename F>
+    bool dequeue(F&& func) {
+        size_t pos;
+        if (!claim<single_consumer>(head, 1, pos)) {
+            return false;
+        }
+
+        Cell& cell = cells[pos % size_buffer];
+        try {
+            func(*cell.get());
+        }
+        catch (...) {
+            release(cell, pos);
+            throw;
+        }
+        release(cell, pos);
+        return true;
+    }
+
+    void release(Cell& cell, size_t pos) {
+        cell.get()->~T();
+        cell.sequence.store(pos + size_buffer, std::memory_order_release);
+    }
+};
+
+#endif
\ No newline at end of file
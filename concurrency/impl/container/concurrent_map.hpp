@@ -0,0 +1,351 @@
+#ifndef CONTAINER_CONCURRENT_MAP_HPP
+#define CONTAINER_CONCURRENT_MAP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../platform/constant.hpp"
+#include "../rcu.hpp"
+
+// Hash map with lock free reads and lock striped writes.
+// Buckets are chains of immutable nodes, writers replace or unlink
+// nodes under the lock of bucket stripe and retire old ones to rcu
+// domain, so readers walk chains without any lock or retry.
+// Stripe of a bucket stays the same across rehash, rehash takes all
+// stripes and publishes copied table while readers keep the old one.
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class ConcurrentHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+
+    ConcurrentHashMap()
+        : ConcurrentHashMap(0) {
+        // Do Nothing
+    }
+
+    ConcurrentHashMap(size_t capacity,
+                      Hash const& hash = Hash(),
+                      KeyEqual const& equal = KeyEqual())
+        : hasher(hash), equal(equal),
+          num_stripes(ceil_pow2(
+              4 * std::max(1u, std::thread::hardware_concurrency()))),
+          stripes(std::make_unique<Stripe[]>(num_stripes)),
+          table(new Table(std::max(num_stripes, ceil_pow2(capacity)))) {
+        // Do Nothing
+    }
+
+    ~ConcurrentHashMap() {
+        delete table.load();
+    }
+
+    ConcurrentHashMap(ConcurrentHashMap const&) = delete;
+    ConcurrentHashMap(ConcurrentHashMap&&) = delete;
+
+    ConcurrentHashMap& operator=(ConcurrentHashMap const&) = delete;
+    ConcurrentHashMap& operator=(ConcurrentHashMap&&) = delete;
+
+    std::optional<mapped_type> find(key_type const& key) {
+        std::optional<mapped_type> given;
+        visit(key, [&](mapped_type const& value) { given = value; });
+        return given;
+    }
+
+    bool contains(key_type const& key) {
+        return visit(key, [](mapped_type const&) {});
+    }
+
+    // call func with value in place instead of copying it out,
+    // value may be replaced meanwhile but stays alive during func
+    template <typename F>
+    bool visit(key_type const& key, F&& func) {
+        size_t hash = hash_of(key);
+
+        RcuReadGuard guard(domain);
+        Table* current = table.load(std::memory_order_acquire);
+        Node* node = current->bucket(hash).load(std::memory_order_acquire);
+        for (; node != nullptr;
+             node = node->next.load(std::memory_order_acquire)) {
+            if (node->hash == hash && equal(node->key, key)) {
+                func(node->value);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // true if inserted, false if assigned
+    template <typename V>
+    bool insert_or_assign(key_type const& key, V&& value) {
+        size_t hash = hash_of(key);
+        Stripe& stripe = stripe_of(hash);
+
+        Node* old = nullptr;
+        {
+            std::unique_lock lock(stripe.mutex);
+            std::atomic<Node*>* link = nullptr;
+            old = locate(hash, key, link);
+
+            Node* node = new Node(hash, key, std::forward<V>(value));
+            if (old != nullptr) {
+                node->next.store(old->next.load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+                link->store(node, std::memory_order_release);
+            }
+            else {
+                node->next.store(link->load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+                link->store(node, std::memory_order_release);
+                ++stripe.size;
+            }
+        }
+
+        if (old != nullptr) {
+            domain.Retire(old);
+            return false;
+        }
+        grow(stripe);
+        return true;
+    }
+
+    // insert value made by func(key) if absent, func runs under lock
+    // so it is called once per key, returns value in the map
+    template <typename F>
+    mapped_type compute_if_absent(key_type const& key, F&& func) {
+        std::optional<mapped_type> given = find(key);
+        if (given.has_value()) {
+            return std::move(given.value());
+        }
+
+        size_t hash = hash_of(key);
+        Stripe& stripe = stripe_of(hash);
+        {
+            std::unique_lock lock(stripe.mutex);
+            std::atomic<Node*>* link = nullptr;
+            Node* old = locate(hash, key, link);
+            if (old != nullptr) {
+                return old->value;
+            }
+
+            Node* node = new Node(hash, key, func(key));
+            node->next.store(link->load(std::memory_order_relaxed),
+                             std::memory_order_relaxed);
+            link->store(node, std::memory_order_release);
+            ++stripe.size;
+
+            given.emplace(node->value);
+        }
+
+        grow(stripe);
+        return std::move(given.value());
+    }
+
+    bool erase(key_type const& key) {
+        size_t hash = hash_of(key);
+        Stripe& stripe = stripe_of(hash);
+
+        Node* old = nullptr;
+        {
+            std::unique_lock lock(stripe.mutex);
+            std::atomic<Node*>* link = nullptr;
+            old = locate(hash, key, link);
+            if (old == nullptr) {
+                return false;
+            }
+
+            link->store(old->next.load(std::memory_order_relaxed),
+                        std::memory_order_release);
+            --stripe.size;
+        }
+
+        domain.Retire(old);
+        return true;
+    }
+
+    // snapshot of each bucket, not of whole map
+    template <typename F>
+    void for_each(F&& func) {
+        RcuReadGuard guard(domain);
+        Table* current = table.load(std::memory_order_acquire);
+        for (size_t i = 0; i < current->num_buckets; ++i) {
+            Node* node = current->buckets[i].load(std::memory_order_acquire);
+            for (; node != nullptr;
+                 node = node->next.load(std::memory_order_acquire)) {
+                func(node->key, node->value);
+            }
+        }
+    }
+
+    size_t size() const {
+        size_t sum = 0;
+        for (size_t i = 0; i < num_stripes; ++i) {
+            sum += stripes[i].size.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t bucket_count() {
+        RcuReadGuard guard(domain);
+        return table.load(std::memory_order_acquire)->num_buckets;
+    }
+
+    // rehash to at least num_buckets, readers are not blocked
+    void rehash(size_t num_buckets) {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        for (size_t i = 0; i < num_stripes; ++i) {
+            locks.emplace_back(stripes[i].mutex);
+        }
+
+        Table* old = table.load(std::memory_order_relaxed);
+        num_buckets = std::max(num_stripes, ceil_pow2(num_buckets));
+        if (num_buckets == old->num_buckets) {
+            return;
+        }
+
+        // nodes are copied, readers may still walk old chains
+        Table* fresh = new Table(num_buckets);
+        for (size_t i = 0; i < old->num_buckets; ++i) {
+            Node* node = old->buckets[i].load(std::memory_order_relaxed);
+            for (; node != nullptr;
+                 node = node->next.load(std::memory_order_relaxed)) {
+                std::atomic<Node*>& bucket = fresh->bucket(node->hash);
+                Node* copy = new Node(node->hash, node->key, node->value);
+                copy->next.store(bucket.load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+                bucket.store(copy, std::memory_order_relaxed);
+            }
+        }
+        table.store(fresh, std::memory_order_release);
+
+        locks.clear();
+        domain.Retire(old);
+    }
+
+private:
+    // average chain length which triggers rehash
+    static constexpr size_t load_factor = 2;
+
+    struct Node {
+        size_t hash;
+        key_type const key;
+        mapped_type const value;
+        std::atomic<Node*> next;
+
+        template <typename V>
+        Node(size_t hash, key_type const& key, V&& value)
+            : hash(hash), key(key), value(std::forward<V>(value)),
+              next(nullptr) {
+            // Do Nothing
+        }
+    };
+
+    // owns nodes linked in its buckets
+    struct Table {
+        size_t num_buckets;
+        std::unique_ptr<std::atomic<Node*>[]> buckets;
+
+        Table(size_t num_buckets)
+            : num_buckets(num_buckets),
+              buckets(std::make_unique<std::atomic<Node*>[]>(num_buckets)) {
+            for (size_t i = 0; i < num_buckets; ++i) {
+                buckets[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        ~Table() {
+            for (size_t i = 0; i < num_buckets; ++i) {
+                Node* node = buckets[i].load(std::memory_order_relaxed);
+                while (node != nullptr) {
+                    Node* next = node->next.load(std::memory_order_relaxed);
+                    delete node;
+                    node = next;
+                }
+            }
+        }
+
+        std::atomic<Node*>& bucket(size_t hash) {
+            return buckets[hash & (num_buckets - 1)];
+        }
+    };
+
+    struct alignas(platform::cache_line) Stripe {
+        std::mutex mutex;
+        std::atomic<size_t> size = 0;
+    };
+
+    Hash hasher;
+    KeyEqual equal;
+
+    size_t num_stripes;
+    std::unique_ptr<Stripe[]> stripes;
+
+    std::atomic<Table*> table;
+    RcuDomain domain;
+
+    static size_t ceil_pow2(size_t value) {
+        size_t pow = 1;
+        while (pow < value) {
+            pow <<= 1;
+        }
+        return pow;
+    }
+
+    // spread bits, so low bits choosing bucket and stripe are mixed
+    size_t hash_of(key_type const& key) const {
+        constexpr size_t half = sizeof(size_t) * 4;
+
+        size_t hash = hasher(key);
+        hash ^= hash >> half;
+        hash *= static_cast<size_t>(0x9e3779b97f4a7c15ull);
+        hash ^= hash >> half;
+        return hash;
+    }
+
+    // buckets are multiple of stripes, so stripe is kept on rehash
+    Stripe& stripe_of(size_t hash) {
+        return stripes[hash & (num_stripes - 1)];
+    }
+
+    // Node of the key and link pointing to it, or link to insert at.
+    // Caller holds stripe, so table is not replaced meanwhile.
+    Node* locate(size_t hash, key_type const& key, std::atomic<Node*>*& link) {
+        Table* current = table.load(std::memory_order_relaxed);
+        link = &current->bucket(hash);
+        Node* node = link->load(std::memory_order_relaxed);
+        for (; node != nullptr;
+             node = node->next.load(std::memory_order_relaxed)) {
+            if (node->hash == hash && equal(node->key, key)) {
+                return node;
+            }
+            link = &node->next;
+        }
+        link = &current->bucket(hash);
+        return nullptr;
+    }
+
+    // stripe covers 1 / num_stripes of buckets
+    void grow(Stripe& stripe) {
+        size_t num_buckets = bucket_count();
+        if (stripe.size.load(std::memory_order_relaxed) * num_stripes
+            > num_buckets * load_factor) {
+            rehash(num_buckets * 2);
+        }
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,210 @@
+#ifndef CONTAINER_MAPPED_QUEUE_HPP
+#define CONTAINER_MAPPED_QUEUE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "../platform/mapped_file.hpp"
+
+// File backed queue, written to segment files `path.N` which are rotated
+// when full and removed when consumed. Segment indices of head and tail
+// are kept in `path.meta`, so queue is restored on reopen.
+template <typename T>
+class MappedQueue {
+public:
+    using value_type = T;
+
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "MappedQueue base type must be trivially copyable");
+
+    MappedQueue(std::string const& path,
+                size_t segment_size = 4096,
+                size_t max_segments = 0,
+                size_t sync_every = 0)
+        : path(path), segment_size(segment_size), max_segments(max_segments),
+          sync_every(sync_every), num_commit(0),
+          meta(path + ".meta", sizeof(Header)) {
+        init_header(meta_header());
+
+        tail_seg = open_segment(meta_header().tail);
+        if (meta_header().head == meta_header().tail) {
+            head_seg = tail_seg;
+        }
+        else {
+            head_seg = open_segment(meta_header().head);
+        }
+    }
+
+    MappedQueue(MappedQueue const&) = delete;
+    MappedQueue(MappedQueue&&) = delete;
+
+    MappedQueue& operator=(MappedQueue const&) = delete;
+    MappedQueue& operator=(MappedQueue&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        reserve_back() = T(std::forward<U>(args)...);
+        commit_back();
+    }
+
+    // slot which will be published by next commit_back
+    T& reserve_back() {
+        if (tail_seg->header().tail == segment_size) {
+            rotate();
+        }
+        return tail_seg->slots()[tail_seg->header().tail];
+    }
+
+    void commit_back() {
+        tail_seg->header().tail += 1;
+        if (sync_every > 0 && ++num_commit % sync_every == 0) {
+            tail_seg->file.sync();
+        }
+    }
+
+    void pop_front() {
+        Header& header = head_seg->header();
+        header.head += 1;
+
+        if (header.head == segment_size && head_seg != tail_seg) {
+            uint64_t next = head_seg->index + 1;
+            std::string name = segment_name(head_seg->index);
+
+            meta_header().head = next;
+            head_seg = next == tail_seg->index ? tail_seg : open_segment(next);
+            std::remove(name.c_str());
+        }
+    }
+
+    T& front() {
+        return head_seg->slots()[head_seg->header().head];
+    }
+
+    T const& front() const {
+        return head_seg->slots()[head_seg->header().head];
+    }
+
+    size_t size() const {
+        Header const& head = head_seg->header();
+        Header const& tail = tail_seg->header();
+        if (head_seg == tail_seg) {
+            return tail.tail - head.head;
+        }
+        return (segment_size - head.head)
+               + (tail_seg->index - head_seg->index - 1) * segment_size
+               + tail.tail;
+    }
+
+    // size with remaining writable slots, segments are reused as a whole
+    size_t max_size() const {
+        if (max_segments == 0) {
+            return std::numeric_limits<size_t>::max();
+        }
+
+        size_t live = tail_seg->index - head_seg->index + 1;
+        if (live > max_segments) {
+            return size();
+        }
+        return size() + (max_segments - live) * segment_size
+               + (segment_size - tail_seg->header().tail);
+    }
+
+private:
+    struct Header {
+        uint64_t magic;
+        uint64_t value_size;
+        uint64_t segment_size;
+        uint64_t head;  // segment index on meta, read offset on segment
+        uint64_t tail;  // segment index on meta, write offset on segment
+    };
+
+    static constexpr uint64_t magic_number = 0x4d41505045445155;
+    static constexpr size_t data_offset =
+        (sizeof(Header) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+    struct Segment {
+        uint64_t index;
+        platform::MappedFile file;
+
+        Segment(uint64_t index, std::string const& name, size_t size)
+            : index(index), file(name, size) {
+            // Do Nothing
+        }
+
+        Header& header() const {
+            return *static_cast<Header*>(file.data());
+        }
+
+        T* slots() const {
+            return reinterpret_cast<T*>(static_cast<char*>(file.data())
+                                        + data_offset);
+        }
+    };
+
+    std::string path;
+    size_t segment_size;
+    size_t max_segments;
+    size_t sync_every;
+    size_t num_commit;
+
+    platform::MappedFile meta;
+    std::shared_ptr<Segment> head_seg;
+    std::shared_ptr<Segment> tail_seg;
+
+    Header& meta_header() {
+        return *static_cast<Header*>(meta.data());
+    }
+
+    std::string segment_name(uint64_t index) const {
+        return path + "." + std::to_string(index);
+    }
+
+    void init_header(Header& header) {
+        if (header.magic == 0) {
+            header.magic = magic_number;
+            header.value_size = sizeof(T);
+            header.segment_size = segment_size;
+            header.head = 0;
+            header.tail = 0;
+        }
+        else if (header.magic != magic_number
+                 || header.value_size != sizeof(T)
+                 || header.segment_size != segment_size) {
+            throw std::runtime_error("MappedQueue: incompatible file " + path);
+        }
+    }
+
+    std::shared_ptr<Segment> open_segment(uint64_t index) {
+        auto segment = std::make_shared<Segment>(
+            index, segment_name(index), data_offset + segment_size * sizeof(T));
+        init_header(segment->header());
+        return segment;
+    }
+
+    void rotate() {
+        std::shared_ptr<Segment> next = open_segment(tail_seg->index + 1);
+        meta_header().tail = next->index;
+
+        if (head_seg == tail_seg && head_seg->header().head == segment_size) {
+            std::string name = segment_name(head_seg->index);
+
+            meta_header().head = next->index;
+            head_seg = next;
+            tail_seg = next;
+            std::remove(name.c_str());
+        }
+        else {
+            if (sync_every > 0) {
+                tail_seg->file.sync();
+            }
+            tail_seg = next;
+        }
+    }
+};
+
+#endif
\ No newline at end of file
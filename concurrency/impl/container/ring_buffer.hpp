@@ -29,8 +29,20 @@ public:
 
     template <typename... U>
     void emplace_back(U&&... args) {
-        buffer[ptr_tail] = T(std::forward<U>(args)...);
+        reserve_back() = T(std::forward<U>(args)...);
+        commit_back();
+    }
+
+    // slot which will be published by next commit_back
+    T& reserve_back() {
+        return buffer[ptr_tail];
+    }
+
+    T const& reserve_back() const {
+        return buffer[ptr_tail];
+    }
 
+    void commit_back() {
         num_data += 1;
         ptr_tail = (ptr_tail + 1) % size_buffer;
     }
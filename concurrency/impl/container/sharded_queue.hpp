@@ -0,0 +1,257 @@
+#ifndef CONTAINER_SHARDED_QUEUE_HPP
+#define CONTAINER_SHARDED_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+
+#include "../platform/constant.hpp"
+
+// Thread safe unbounded queue split into lanes, producer thread is hashed
+// to single lane and consumers sweep lanes from random start.
+// Order is kept per producer, not globally.
+template <typename T>
+class ShardedQueue {
+public:
+    using value_type = T;
+
+    ShardedQueue()
+        : ShardedQueue(std::max(1u, std::thread::hardware_concurrency())) {
+        // Do Nothing
+    }
+
+    ShardedQueue(size_t num_lanes)
+        : num_lanes(std::max<size_t>(num_lanes, 1)),
+          lanes(std::make_unique<Lane[]>(this->num_lanes)), m_runnable(true),
+          num_waiting(0), epoch(0) {
+        // Do Nothing
+    }
+
+    ~ShardedQueue() {
+        close();
+    }
+
+    ShardedQueue(ShardedQueue const&) = delete;
+    ShardedQueue(ShardedQueue&&) = delete;
+
+    ShardedQueue& operator=(ShardedQueue const&) = delete;
+    ShardedQueue& operator=(ShardedQueue&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        if (!runnable()) {
+            return;
+        }
+
+        Lane& lane = lanes[std::hash<std::thread::id>()(
+                               std::this_thread::get_id())
+                           % num_lanes];
+        {
+            std::unique_lock lock(lane.mutex);
+            lane.queue.emplace_back(std::forward<U>(args)...);
+        }
+
+        if (num_waiting.load() > 0) {
+            std::unique_lock lock(mutex);
+            ++epoch;
+            cond.notify_all();
+        }
+    }
+
+    // queue is unbounded, so only closed queue refuses
+    template <typename... U>
+    bool try_emplace_back(U&&... args) {
+        if (!runnable()) {
+            return false;
+        }
+        emplace_back(std::forward<U>(args)...);
+        return true;
+    }
+
+    template <typename Clock, typename Duration, typename... U>
+    bool emplace_back_until(std::chrono::time_point<Clock, Duration> const&,
+                            U&&... args) {
+        return try_emplace_back(std::forward<U>(args)...);
+    }
+
+    void push_back(value_type const& value) {
+        emplace_back(value);
+    }
+
+    void push_back(value_type&& value) {
+        emplace_back(std::move(value));
+    }
+
+    std::optional<value_type> pop_front() {
+        std::optional<value_type> given;
+        wait_for_item([&](value_type& item) { given = std::move(item); });
+        return given;
+    }
+
+    std::optional<value_type> try_pop() {
+        std::optional<value_type> given;
+        sweep([&](value_type& item) { given = std::move(item); });
+        return given;
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> pop_front_until(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        std::optional<value_type> given;
+        wait_for_item([&](value_type& item) { given = std::move(item); },
+                      &time);
+        return given;
+    }
+
+    template <typename F>
+    bool consume_front(F&& func) {
+        return wait_for_item(func);
+    }
+
+    void close() {
+        std::unique_lock lock(mutex);
+        m_runnable = false;
+        cond.notify_all();
+    }
+
+    bool runnable() const {
+        return m_runnable;
+    }
+
+    bool readable() {
+        if (runnable()) {
+            return true;
+        }
+        for (size_t i = 0; i < num_lanes; ++i) {
+            std::unique_lock lock(lanes[i].mutex);
+            if (!lanes[i].queue.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (size_t i = 0; i < num_lanes; ++i) {
+            std::unique_lock lock(lanes[i].mutex);
+            total += lanes[i].queue.size();
+        }
+        return total;
+    }
+
+private:
+    struct alignas(platform::cache_line) Lane {
+        std::mutex mutex;
+        std::deque<T> queue;
+    };
+
+    size_t num_lanes;
+    std::unique_ptr<Lane[]> lanes;
+
+    alignas(platform::cache_line) std::atomic<bool> m_runnable;
+    std::atomic<size_t> num_waiting;
+
+    alignas(platform::cache_line) std::mutex mutex;
+    std::condition_variable cond;
+    size_t epoch;
+
+    // take front of the first non-empty lane from random start,
+    // busy lanes are skipped first and locked on second pass
+    template <typename F>
+    bool sweep(F&& func) {
+        thread_local std::minstd_rand rng(static_cast<unsigned>(
+            std::hash<std::thread::id>()(std::this_thread::get_id())));
+        size_t start = rng() % num_lanes;
+
+        bool skipped = false;
+        for (size_t i = 0; i < num_lanes; ++i) {
+            Lane& lane = lanes[(start + i) % num_lanes];
+            std::unique_lock lock(lane.mutex, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                skipped = true;
+            }
+            else if (take(lane, func)) {
+                return true;
+            }
+        }
+
+        if (skipped) {
+            for (size_t i = 0; i < num_lanes; ++i) {
+                Lane& lane = lanes[(start + i) % num_lanes];
+                std::unique_lock lock(lane.mutex);
+                if (take(lane, func)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    template <typename F>
+    static bool take(Lane& lane, F& func) {
+        if (lane.queue.empty()) {
+            return false;
+        }
+        func(lane.queue.front());
+        lane.queue.pop_front();
+        return true;
+    }
+
+    // producer bumps epoch only if someone is waiting, so waiter reads
+    // epoch before sweeping to not miss items pushed after the sweep,
+    // wait forever if deadline is null
+    template <typename F,
+              typename Clock = std::chrono::steady_clock,
+              typename Duration = typename Clock::duration>
+    bool wait_for_item(
+        F&& func,
+        std::chrono::time_point<Clock, Duration> const* deadline = nullptr) {
+        while (true) {
+            if (sweep(func)) {
+                return true;
+            }
+
+            ++num_waiting;
+            size_t seen;
+            {
+                std::unique_lock lock(mutex);
+                seen = epoch;
+            }
+
+            bool found = sweep(func);
+            bool expired = false;
+            if (!found) {
+                std::unique_lock lock(mutex);
+                auto pred = [&] { return !m_runnable || epoch != seen; };
+                if (deadline == nullptr) {
+                    cond.wait(lock, pred);
+                }
+                else {
+                    expired = !cond.wait_until(lock, *deadline, pred);
+                }
+            }
+            --num_waiting;
+
+            if (found) {
+                return true;
+            }
+            if (expired) {
+                return sweep(func);
+            }
+            if (!runnable() && !readable()) {
+                return false;
+            }
+        }
+    }
+};
+
+#endif
\ No newline at end of file
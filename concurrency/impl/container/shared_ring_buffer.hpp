@@ -0,0 +1,213 @@
+#ifndef CONTAINER_SHARED_RING_BUFFER_HPP
+#define CONTAINER_SHARED_RING_BUFFER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "../platform/shared_memory.hpp"
+
+// Process safe ring buffer, whole state lives in named shared memory.
+// Same interface with ThreadSafe, so it could be used as channel buffer.
+template <typename T>
+class SharedRingBuffer {
+public:
+    using value_type = T;
+
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "SharedRingBuffer base type must be trivially copyable");
+
+    SharedRingBuffer(std::string const& name, size_t size_buffer)
+        : memory(name, data_offset + size_buffer * sizeof(T)),
+          state(static_cast<State*>(memory.data())),
+          buffer(reinterpret_cast<T*>(static_cast<char*>(memory.data())
+                                      + data_offset)) {
+        if (memory.owner()) {
+            new (state) State(size_buffer);
+            state->ready.store(magic_number, std::memory_order_release);
+        }
+        else {
+            while (state->ready.load(std::memory_order_acquire)
+                   != magic_number) {
+                std::this_thread::yield();
+            }
+            if (state->value_size != sizeof(T)
+                || state->size_buffer != size_buffer) {
+                throw std::runtime_error("SharedRingBuffer: incompatible "
+                                         + name);
+            }
+        }
+    }
+
+    ~SharedRingBuffer() {
+        if (memory.owner()) {
+            close();
+        }
+    }
+
+    SharedRingBuffer(SharedRingBuffer const&) = delete;
+    SharedRingBuffer(SharedRingBuffer&&) = delete;
+
+    SharedRingBuffer& operator=(SharedRingBuffer const&) = delete;
+    SharedRingBuffer& operator=(SharedRingBuffer&&) = delete;
+
+    template <typename... U>
+    void emplace_back(U&&... args) {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait(lock, [&] {
+            return !state->runnable || state->num_data < state->size_buffer;
+        });
+
+        if (state->runnable) {
+            put_back(std::forward<U>(args)...);
+        }
+        state->cond.notify_all();
+    }
+
+    template <typename... U>
+    bool try_emplace_back(U&&... args) {
+        std::unique_lock lock(state->mutex);
+        if (!state->runnable || state->num_data >= state->size_buffer) {
+            return false;
+        }
+
+        put_back(std::forward<U>(args)...);
+        state->cond.notify_all();
+        return true;
+    }
+
+    template <typename Clock, typename Duration, typename... U>
+    bool emplace_back_until(
+        std::chrono::time_point<Clock, Duration> const& time, U&&... args) {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait_until(lock, time, [&] {
+            return !state->runnable || state->num_data < state->size_buffer;
+        });
+
+        if (!state->runnable || state->num_data >= state->size_buffer) {
+            return false;
+        }
+
+        put_back(std::forward<U>(args)...);
+        state->cond.notify_all();
+        return true;
+    }
+
+    std::optional<value_type> pop_front() {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait(
+            lock, [&] { return !state->runnable || state->num_data > 0; });
+
+        return take_front();
+    }
+
+    std::optional<value_type> try_pop() {
+        std::unique_lock lock(state->mutex);
+        return take_front();
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> pop_front_until(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait_until(lock, time, [&] {
+            return !state->runnable || state->num_data > 0;
+        });
+
+        return take_front();
+    }
+
+    template <typename F>
+    bool consume_front(F&& func) {
+        std::unique_lock lock(state->mutex);
+        state->cond.wait(
+            lock, [&] { return !state->runnable || state->num_data > 0; });
+
+        if (state->num_data == 0) {
+            return false;
+        }
+
+        func(buffer[state->ptr_head]);
+        advance_head();
+        return true;
+    }
+
+    void close() {
+        std::unique_lock lock(state->mutex);
+        state->runnable = false;
+        state->cond.notify_all();
+    }
+
+    bool runnable() const {
+        return state->runnable;
+    }
+
+    bool readable() {
+        std::unique_lock lock(state->mutex);
+        return state->runnable || state->num_data > 0;
+    }
+
+private:
+    struct State {
+        std::atomic<uint64_t> ready;
+        uint64_t value_size;
+        uint64_t size_buffer;
+
+        platform::ProcessMutex mutex;
+        platform::ProcessCondition cond;
+
+        bool runnable;
+        uint64_t num_data;
+        uint64_t ptr_head;
+        uint64_t ptr_tail;
+
+        State(size_t size_buffer)
+            : ready(0), value_size(sizeof(T)), size_buffer(size_buffer),
+              runnable(true), num_data(0), ptr_head(0), ptr_tail(0) {
+            // Do Nothing
+        }
+    };
+
+    static constexpr uint64_t magic_number = 0x5348415245445247;
+    static constexpr size_t data_offset =
+        (sizeof(State) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "SharedRingBuffer requires address free atomics");
+
+    platform::SharedMemory memory;
+    State* state;
+    T* buffer;
+
+    template <typename... U>
+    void put_back(U&&... args) {
+        buffer[state->ptr_tail] = T(std::forward<U>(args)...);
+        state->num_data += 1;
+        state->ptr_tail = (state->ptr_tail + 1) % state->size_buffer;
+    }
+
+    std::optional<value_type> take_front() {
+        if (state->num_data == 0) {
+            return std::nullopt;
+        }
+
+        std::optional<value_type> given(buffer[state->ptr_head]);
+        advance_head();
+        return given;
+    }
+
+    void advance_head() {
+        state->num_data -= 1;
+        state->ptr_head = (state->ptr_head + 1) % state->size_buffer;
+        state->cond.notify_all();
+    }
+};
+
+#endif
\ No newline at end of file
@@ -1,22 +1,79 @@
 #ifndef CONTAINER_THREAD_SAFE_HPP
 #define CONTAINER_THREAD_SAFE_HPP
 
+#include <chrono>
 #include <condition_variable>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <type_traits>
 
 #include "ring_buffer.hpp"
+#include "../trace.hpp"
+#include "../platform/constant.hpp"
 
+// state is guarded by single mutex and kept together,
+// aligned to prevent false sharing with neighbor objects,
+// mutex other than std::mutex waits on std::condition_variable_any
 template <typename Cont, typename Mutex = std::mutex>
-class ThreadSafe {
+class alignas(platform::cache_line) ThreadSafe {
 public:
     using value_type = typename Cont::value_type;
 
+    // Exclusive borrow of the next back slot, publish it with commit.
+    // Lock is held while reservation alive, keep it short.
+    class Reservation {
+    public:
+        Reservation(ThreadSafe& parent, std::unique_lock<Mutex>&& lock)
+            : parent(parent), lock(std::move(lock)), committed(false) {
+            // Do Nothing
+        }
+
+        ~Reservation() {
+            if (lock.owns_lock()) {
+                lock.unlock();
+            }
+        }
+
+        Reservation(Reservation const&) = delete;
+        Reservation(Reservation&&) = default;
+
+        Reservation& operator=(Reservation const&) = delete;
+        Reservation& operator=(Reservation&&) = delete;
+
+        explicit operator bool() const {
+            return lock.owns_lock() && !committed;
+        }
+
+        value_type& operator*() {
+            return parent.buffer.reserve_back();
+        }
+
+        value_type* operator->() {
+            return &parent.buffer.reserve_back();
+        }
+
+        void commit() {
+            if (*this) {
+                parent.buffer.commit_back();
+                committed = true;
+
+                lock.unlock();
+                parent.cond.notify_all();
+            }
+        }
+
+    private:
+        ThreadSafe& parent;
+        std::unique_lock<Mutex> lock;
+        bool committed;
+    };
+
     template <typename... Args>
     ThreadSafe(Args&&... args)
-        : m_runnable(true), buffer(std::forward<Args>(args)...) {
+        : m_runnable(true), buffer(std::forward<Args>(args)...),
+          num_readers(0), num_writers(0) {
         // Do Nothing
     }
 
@@ -33,7 +90,7 @@ public:
     template <typename... U>
     void emplace_back(U&&... args) {
         std::unique_lock lock(mutex);
-        cond.wait(lock, [&] {
+        wait(lock, num_writers, [&] {
             return !m_runnable || buffer.size() < buffer.max_size();
         });
 
@@ -44,54 +101,126 @@ public:
     }
 
     void push_back(value_type const& value) {
+        emplace_back(value);
+    }
+
+    void push_back(value_type&& value) {
+        emplace_back(std::move(value));
+    }
+
+    // Push range under one lock, moved from if it is move iterator.
+    // Waits for room only when bounded buffer is full, wakes as many
+    // readers as pushed. Returns number pushed, less only if closed.
+    template <typename It>
+    size_t push_back_range(It first, It last) {
+        size_t pushed = 0;
         std::unique_lock lock(mutex);
-        cond.wait(lock, [&] {
-            return !m_runnable || buffer.size() < buffer.max_size();
-        });
+        while (first != last) {
+            wait(lock, num_writers, [&] {
+                return !m_runnable || buffer.size() < buffer.max_size();
+            });
+            if (!m_runnable) {
+                break;
+            }
 
-        if (m_runnable) {
-            buffer.push_back(value);
+            size_t added = 0;
+            for (; first != last && buffer.size() < buffer.max_size();
+                 ++first) {
+                buffer.emplace_back(*first);
+                ++added;
+            }
+            notify_readers(added);
+            pushed += added;
+        }
+        return pushed;
+    }
+
+    // fail only if buffer is full or closed, never on lock contention
+    template <typename... U>
+    bool try_emplace_back(U&&... args) {
+        std::unique_lock lock(mutex);
+        if (!m_runnable || buffer.size() >= buffer.max_size()) {
+            return false;
         }
+
+        buffer.emplace_back(std::forward<U>(args)...);
         cond.notify_all();
+        return true;
     }
 
-    void push_back(value_type&& value) {
+    template <typename Clock, typename Duration, typename... U>
+    bool emplace_back_until(
+        std::chrono::time_point<Clock, Duration> const& time, U&&... args) {
         std::unique_lock lock(mutex);
-        cond.wait(lock, [&] {
+        wait_until(lock, time, num_writers, [&] {
             return !m_runnable || buffer.size() < buffer.max_size();
         });
 
-        if (m_runnable) {
-            buffer.push_back(std::move(value));
+        if (!m_runnable || buffer.size() >= buffer.max_size()) {
+            return false;
         }
+
+        buffer.emplace_back(std::forward<U>(args)...);
         cond.notify_all();
+        return true;
     }
 
     std::optional<value_type> pop_front() {
         std::unique_lock lock(mutex);
-        cond.wait(lock, [&] { return !m_runnable || buffer.size() > 0; });
+        wait(lock, num_readers, [&] {
+            return !m_runnable || buffer.size() > 0;
+        });
+
+        return take_front();
+    }
+
+    // fail only if buffer is empty, never on lock contention
+    std::optional<value_type> try_pop() {
+        std::unique_lock lock(mutex);
+        return take_front();
+    }
+
+    template <typename Clock, typename Duration>
+    std::optional<value_type> pop_front_until(
+        std::chrono::time_point<Clock, Duration> const& time) {
+        std::unique_lock lock(mutex);
+        wait_until(lock, time, num_readers, [&] {
+            return !m_runnable || buffer.size() > 0;
+        });
+
+        return take_front();
+    }
+
+    // call func with front element in place, then pop it
+    template <typename F>
+    bool consume_front(F&& func) {
+        std::unique_lock lock(mutex);
+        wait(lock, num_readers, [&] {
+            return !m_runnable || buffer.size() > 0;
+        });
 
         if (!m_runnable && buffer.size() == 0) {
-            return std::nullopt;
+            return false;
         }
 
-        value_type given = std::move(buffer.front());
+        func(buffer.front());
         buffer.pop_front();
 
         cond.notify_all();
-        return std::make_optional(std::move(given));
+        return true;
     }
 
-    std::optional<value_type> try_pop() {
-        std::unique_lock lock(mutex, std::try_to_lock);
-        if (lock.owns_lock() && buffer.size() > 0) {
-            value_type given = std::move(buffer.front());
-            buffer.pop_front();
+    // requires reserve_back and commit_back from container, e.g. RingBuffer
+    Reservation reserve_back() {
+        std::unique_lock lock(mutex);
+        wait(lock, num_writers, [&] {
+            return !m_runnable || buffer.size() < buffer.max_size();
+        });
 
-            cond.notify_all();
-            return std::make_optional(std::move(given));
+        if (!m_runnable) {
+            lock.unlock();
         }
-        return std::nullopt;
+        return Reservation(*this, std::move(lock));
     }
 
     void close() {
@@ -113,7 +242,76 @@ private:
     Cont buffer;
 
     Mutex mutex;
-    std::condition_variable cond;
+    std::conditional_t<std::is_same_v<Mutex, std::mutex>,
+                       std::condition_variable,
+                       std::condition_variable_any>
+        cond;
+
+    // threads waiting on cond for item and for room, guarded by mutex
+    size_t num_readers;
+    size_t num_writers;
+
+    // traced as channel block only if it really waits
+    template <typename Pred>
+    void wait(std::unique_lock<Mutex>& lock, size_t& waiting, Pred pred) {
+        if (pred()) {
+            return;
+        }
+
+        ++waiting;
+        if constexpr (Trace::enabled) {
+            Trace::Span span("channel.block");
+            cond.wait(lock, pred);
+        }
+        else {
+            cond.wait(lock, pred);
+        }
+        --waiting;
+    }
+
+    template <typename Clock, typename Duration, typename Pred>
+    void wait_until(std::unique_lock<Mutex>& lock,
+                    std::chrono::time_point<Clock, Duration> const& time,
+                    size_t& waiting,
+                    Pred pred) {
+        if (pred()) {
+            return;
+        }
+
+        ++waiting;
+        if constexpr (Trace::enabled) {
+            Trace::Span span("channel.block");
+            cond.wait_until(lock, time, pred);
+        }
+        else {
+            cond.wait_until(lock, time, pred);
+        }
+        --waiting;
+    }
+
+    // Wake n readers only. Writer could take the wake up of reader,
+    // so everyone is waked if any writer waits.
+    void notify_readers(size_t n) {
+        if (num_writers > 0 || n >= num_readers) {
+            cond.notify_all();
+            return;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            cond.notify_one();
+        }
+    }
+
+    std::optional<value_type> take_front() {
+        if (buffer.size() == 0) {
+            return std::nullopt;
+        }
+
+        std::optional<value_type> given(std::move(buffer.front()));
+        buffer.pop_front();
+
+        cond.notify_all();
+        return given;
+    }
 };
 
 template <typename T>
@@ -28,7 +28,9 @@ namespace LockFree {
     template <typename T>
     class List {
     public:
-        List() : m_head(nullptr), m_tail(nullptr), m_runnable(true), m_size(0) {
+        List()
+            : m_head(nullptr), m_popped(0), m_tail(nullptr), m_pushed(0),
+              m_runnable(true) {
             // Do Nothing
         }
 
@@ -62,80 +64,42 @@ namespace LockFree {
             push_node(new Node<T>(std::forward<U>(args)...));
         }
 
+        // tail is swapped first and linked after, consumer which takes
+        // the swapped out node waits for the link before releasing it
         void push_node(Node<T>* node) {
-            bool run = false;
-            Node<T>* prev = nullptr;
-            do {
-                run = runnable();
-                prev = m_tail.load(std::memory_order_relaxed);
-            } while (
-                run
-                && !m_tail.compare_exchange_weak(prev,
-                                                 node,
-                                                 std::memory_order_relaxed,
-                                                 std::memory_order_relaxed));
-            if (run) {
-                if (prev != nullptr) {
-                    prev->next.store(node, std::memory_order_relaxed);
-                }
-                else {
-                    m_head.store(node, std::memory_order_relaxed);
-                }
-                ++m_size;
+            if (!runnable()) {
+                delete node;
+                return;
             }
+
+            Node<T>* prev = m_tail.exchange(node, std::memory_order_acq_rel);
+            if (prev != nullptr) {
+                prev->next.store(node, std::memory_order_release);
+            }
+            else {
+                m_head.store(node, std::memory_order_release);
+            }
+            m_pushed.fetch_add(1, std::memory_order_relaxed);
         }
 
         template <typename U = decltype(platform::prevent_deadlock)>
         std::optional<T> pop_front(U const& prevent_deadlock
                                    = platform::prevent_deadlock) {
-            bool run = false;
             Node<T>* node = nullptr;
-            do {
+            while (readable() && (node = pop_node()) == nullptr) {
                 std::this_thread::sleep_for(prevent_deadlock);
-
-                run = readable();
-                node = m_head.load(std::memory_order_relaxed);
-            } while (run
-                     && (!node
-                         || !m_head.compare_exchange_weak(
-                             node,
-                             node->next,
-                             std::memory_order_relaxed,
-                             std::memory_order_relaxed)));
-            if (run) {
-                if (node->next == nullptr) {
-                    m_tail.store(nullptr, std::memory_order_relaxed);
-                }
-                --m_size;
-                T res = std::move(node->data);
-
-                delete node;
-                return std::make_optional(std::move(res));
             }
-            return std::nullopt;
+            return release(node);
         }
 
         std::optional<T> try_pop() {
-            Node<T>* node = m_head.load(std::memory_order_relaxed);
-            if (readable() && node
-                && m_head.compare_exchange_weak(node,
-                                                node->next,
-                                                std::memory_order_relaxed,
-                                                std::memory_order_relaxed)) {
-                if (node->next == nullptr) {
-                    m_tail.store(nullptr, std::memory_order_relaxed);
-                }
-                --m_size;
-                T res = std::move(node->data);
-
-                delete node;
-                return std::make_optional(std::move(res));
-            }
-            return std::nullopt;
+            return release(pop_node());
         }
 
         size_t size() const {
-            return m_size.load(std::memory_order_relaxed);
+            size_t popped = m_popped.load(std::memory_order_relaxed);
+            size_t pushed = m_pushed.load(std::memory_order_relaxed);
+            return pushed > popped ? pushed - popped : 0;
         }
 
         Node<T>* head() {
@@ -164,11 +128,58 @@ namespace LockFree {
         }
 
     private:
-        std::atomic<Node<T>*> m_head;
-        std::atomic<Node<T>*> m_tail;
+        // detach head, nullptr if list is empty
+        Node<T>* pop_node() {
+            Node<T>* node = m_head.load(std::memory_order_acquire);
+            while (node != nullptr) {
+                Node<T>* next = node->next.load(std::memory_order_acquire);
+                if (!m_head.compare_exchange_weak(node,
+                                                  next,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_acquire)) {
+                    continue;
+                }
+
+                Node<T>* last = node;
+                if (next == nullptr
+                    && !m_tail.compare_exchange_strong(
+                        last,
+                        nullptr,
+                        std::memory_order_acq_rel,
+                        std::memory_order_relaxed)) {
+                    // producer swapped tail but not linked yet
+                    while ((next = node->next.load(std::memory_order_acquire))
+                           == nullptr) {
+                        std::this_thread::yield();
+                    }
+                    m_head.store(next, std::memory_order_release);
+                }
+
+                m_popped.fetch_add(1, std::memory_order_relaxed);
+                return node;
+            }
+            return nullptr;
+        }
+
+        static std::optional<T> release(Node<T>* node) {
+            if (node == nullptr) {
+                return std::nullopt;
+            }
+
+            std::optional<T> res(std::move(node->data));
+            delete node;
+            return res;
+        }
+
+        // consumer, producer and shared flag on separate cache lines,
+        // size is split into counters owned by each side
+        alignas(platform::cache_line) std::atomic<Node<T>*> m_head;
+        std::atomic<size_t> m_popped;
+
+        alignas(platform::cache_line) std::atomic<Node<T>*> m_tail;
+        std::atomic<size_t> m_pushed;
 
-        std::atomic<bool> m_runnable;
-        std::atomic<size_t> m_size;
+        alignas(platform::cache_line) std::atomic<bool> m_runnable;
     };
 }  // namespace LockFree
 
@@ -0,0 +1,284 @@
+#ifndef LOCKFREE_MPSC_QUEUE_HPP
+#define LOCKFREE_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "../platform/constant.hpp"
+#include "../policy.hpp"
+
+namespace LockFree {
+    // Link embedded in the element of intrusive queue.
+    struct MpscHook {
+        std::atomic<MpscHook*> next;
+
+        MpscHook() : next(nullptr) {
+            // Do Nothing
+        }
+    };
+
+    // Vyukov style intrusive queue, T derives MpscHook and caller owns it.
+    // Push is single exchange, so it is wait free for any number of threads.
+    // Pop is for single consumer and uses no compare exchange.
+    template <typename T>
+    class IntrusiveMpsc {
+    public:
+        IntrusiveMpsc() : m_head(&stub), m_tail(&stub) {
+            // Do Nothing
+        }
+
+        IntrusiveMpsc(IntrusiveMpsc const&) = delete;
+        IntrusiveMpsc(IntrusiveMpsc&&) = delete;
+
+        IntrusiveMpsc& operator=(IntrusiveMpsc const&) = delete;
+        IntrusiveMpsc& operator=(IntrusiveMpsc&&) = delete;
+
+        void push(T* node) {
+            push_hook(node);
+        }
+
+        // nullptr only if queue is empty, waits for a producer which
+        // already took its place but has not linked it yet
+        T* pop() {
+            MpscHook* tail = m_tail;
+            MpscHook* next = tail->next.load(std::memory_order_acquire);
+
+            if (tail == &stub) {
+                if (next == nullptr) {
+                    if (m_head.load(std::memory_order_acquire) == &stub) {
+                        return nullptr;
+                    }
+                    next = wait_link(tail);
+                }
+                m_tail = next;
+                tail = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+
+            if (next == nullptr) {
+                if (tail == m_head.load(std::memory_order_acquire)) {
+                    // tail is last one, stub takes its place
+                    push_hook(&stub);
+                }
+                next = wait_link(tail);
+            }
+
+            m_tail = next;
+            return static_cast<T*>(tail);
+        }
+
+    private:
+        // producers on their own cache line, consumer owns the rest
+        alignas(platform::cache_line) std::atomic<MpscHook*> m_head;
+        alignas(platform::cache_line) MpscHook* m_tail;
+        MpscHook stub;
+
+        void push_hook(MpscHook* node) {
+            node->next.store(nullptr, std::memory_order_relaxed);
+            MpscHook* prev = m_head.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        static MpscHook* wait_link(MpscHook* node) {
+            MpscHook* next;
+            while ((next = node->next.load(std::memory_order_acquire))
+                   == nullptr) {
+                std::this_thread::yield();
+            }
+            return next;
+        }
+    };
+
+    // Unbounded channel buffer for many producers and single consumer,
+    // allocates one node per element over IntrusiveMpsc.
+    template <typename T,
+              typename Wait = Policy::Park,
+              typename Alloc = std::allocator<T>>
+    class MpscQueue {
+    public:
+        using value_type = T;
+
+        MpscQueue(Alloc const& alloc = Alloc())
+            : alloc(alloc), m_runnable(true), m_pushed(0), m_popped(0) {
+            // Do Nothing
+        }
+
+        ~MpscQueue() {
+            close();
+            while (Item* item = queue.pop()) {
+                destroy(item);
+            }
+        }
+
+        MpscQueue(MpscQueue const&) = delete;
+        MpscQueue(MpscQueue&&) = delete;
+
+        MpscQueue& operator=(MpscQueue const&) = delete;
+        MpscQueue& operator=(MpscQueue&&) = delete;
+
+        template <typename... U>
+        void emplace_back(U&&... args) {
+            try_emplace_back(std::forward<U>(args)...);
+        }
+
+        void push_back(value_type const& value) {
+            emplace_back(value);
+        }
+
+        void push_back(value_type&& value) {
+            emplace_back(std::move(value));
+        }
+
+        // queue is unbounded, so only closed queue refuses
+        template <typename... U>
+        bool try_emplace_back(U&&... args) {
+            if (!m_runnable) {
+                return false;
+            }
+
+            Item* item = item_traits::allocate(alloc, 1);
+            try {
+                item_traits::construct(alloc, item, std::forward<U>(args)...);
+            }
+            catch (...) {
+                item_traits::deallocate(alloc, item, 1);
+                throw;
+            }
+
+            queue.push(item);
+            m_pushed.fetch_add(1, std::memory_order_relaxed);
+            waiter.notify();
+            return true;
+        }
+
+        template <typename Clock, typename Duration, typename... U>
+        bool emplace_back_until(std::chrono::time_point<Clock, Duration> const&,
+                                U&&... args) {
+            return try_emplace_back(std::forward<U>(args)...);
+        }
+
+        std::optional<value_type> pop_front() {
+            std::optional<value_type> given;
+            consume_front([&](value_type& data) { given = std::move(data); });
+            return given;
+        }
+
+        std::optional<value_type> try_pop() {
+            std::optional<value_type> given;
+            if (Item* item = take()) {
+                given = std::move(item->data);
+                destroy(item);
+            }
+            return given;
+        }
+
+        template <typename Clock, typename Duration>
+        std::optional<value_type> pop_front_until(
+            std::chrono::time_point<Clock, Duration> const& time) {
+            Item* item = nullptr;
+            waiter.wait_until(time, [&] {
+                item = take();
+                return item != nullptr || !m_runnable;
+            });
+
+            if (item == nullptr) {
+                item = take();
+            }
+
+            std::optional<value_type> given;
+            if (item != nullptr) {
+                given = std::move(item->data);
+                destroy(item);
+            }
+            return given;
+        }
+
+        // after close, items pushed before it are still consumed
+        template <typename F>
+        bool consume_front(F&& func) {
+            Item* item = nullptr;
+            waiter.wait([&] {
+                item = take();
+                return item != nullptr || !m_runnable;
+            });
+
+            if (item == nullptr) {
+                item = take();
+            }
+            if (item == nullptr) {
+                return false;
+            }
+
+            try {
+                func(item->data);
+            }
+            catch (...) {
+                destroy(item);
+                throw;
+            }
+            destroy(item);
+            return true;
+        }
+
+        void close() {
+            m_runnable = false;
+            waiter.notify();
+        }
+
+        bool runnable() const {
+            return m_runnable;
+        }
+
+        bool readable() {
+            return m_runnable || size() > 0;
+        }
+
+        size_t size() const {
+            size_t popped = m_popped.load(std::memory_order_relaxed);
+            size_t pushed = m_pushed.load(std::memory_order_relaxed);
+            return pushed > popped ? pushed - popped : 0;
+        }
+
+    private:
+        struct Item : MpscHook {
+            T data;
+
+            template <typename... U>
+            Item(U&&... args) : data(std::forward<U>(args)...) {
+                // Do Nothing
+            }
+        };
+
+        using item_alloc =
+            typename std::allocator_traits<Alloc>::template rebind_alloc<Item>;
+        using item_traits = std::allocator_traits<item_alloc>;
+
+        item_alloc alloc;
+        IntrusiveMpsc<Item> queue;
+
+        std::atomic<bool> m_runnable;
+        Wait waiter;
+
+        alignas(platform::cache_line) std::atomic<size_t> m_pushed;
+        alignas(platform::cache_line) std::atomic<size_t> m_popped;
+
+        Item* take() {
+            Item* item = queue.pop();
+            if (item != nullptr) {
+                m_popped.fetch_add(1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        void destroy(Item* item) {
+            item_traits::destroy(alloc, item);
+            item_traits::deallocate(alloc, item, 1);
+        }
+    };
+}  // namespace LockFree
+
+#endif
\ No newline at end of file
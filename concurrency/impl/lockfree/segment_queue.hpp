@@ -0,0 +1,410 @@
+#ifndef LOCKFREE_SEGMENT_QUEUE_HPP
+#define LOCKFREE_SEGMENT_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "../platform/constant.hpp"
+#include "../policy.hpp"
+
+namespace LockFree {
+    // Unbounded MPMC queue over linked array segments.
+    // Producers fetch add a slot of the tail segment, consumers take
+    // written slots of the head segment in order with compare exchange.
+    // Drained segments are recycled through free list, so memory stays
+    // contiguous and allocation happens once per SegmentSize items.
+    template <typename T,
+              typename Wait = Policy::Park,
+              typename Alloc = std::allocator<T>,
+              size_t SegmentSize = 128>
+    class SegmentQueue {
+    public:
+        using value_type = T;
+
+        SegmentQueue(Alloc const& alloc = Alloc())
+            : alloc(alloc), seg_alloc(alloc), m_runnable(true),
+              free_lock(false), free_list(nullptr), m_popped(0),
+              m_pushed(0) {
+            Segment* seg = allocate();
+            m_head = seg;
+            m_tail = seg;
+        }
+
+        ~SegmentQueue() {
+            close();
+
+            Segment* seg = m_head.load();
+            while (seg != nullptr) {
+                Segment* next = seg->next.load();
+                size_t end = std::min(seg->enq_idx.load(), SegmentSize);
+                for (size_t i = seg->deq_idx.load(); i < end; ++i) {
+                    if (seg->slots[i].state.load() == written) {
+                        destroy(seg->slots[i]);
+                    }
+                }
+                deallocate(seg);
+                seg = next;
+            }
+
+            seg = free_list.load();
+            while (seg != nullptr) {
+                Segment* next = seg->free_next;
+                deallocate(seg);
+                seg = next;
+            }
+        }
+
+        SegmentQueue(SegmentQueue const&) = delete;
+        SegmentQueue(SegmentQueue&&) = delete;
+
+        SegmentQueue& operator=(SegmentQueue const&) = delete;
+        SegmentQueue& operator=(SegmentQueue&&) = delete;
+
+        template <typename... U>
+        void emplace_back(U&&... args) {
+            try_emplace_back(std::forward<U>(args)...);
+        }
+
+        void push_back(value_type const& value) {
+            emplace_back(value);
+        }
+
+        void push_back(value_type&& value) {
+            emplace_back(std::move(value));
+        }
+
+        // queue is unbounded, so only closed queue refuses
+        template <typename... U>
+        bool try_emplace_back(U&&... args) {
+            if (!m_runnable) {
+                return false;
+            }
+
+            while (true) {
+                Segment* seg = acquire(m_tail);
+                size_t idx = seg->enq_idx.fetch_add(1);
+                if (idx < SegmentSize) {
+                    Slot& slot = seg->slots[idx];
+                    try {
+                        traits::construct(alloc,
+                                          slot.ptr(),
+                                          std::forward<U>(args)...);
+                    }
+                    catch (...) {
+                        // consumers skip broken slot
+                        slot.state.store(broken, std::memory_order_release);
+                        release(seg);
+                        throw;
+                    }
+                    slot.state.store(written, std::memory_order_release);
+                    release(seg);
+                    break;
+                }
+
+                Segment* next = seg->next.load();
+                if (next == nullptr) {
+                    Segment* fresh = allocate();
+                    if (seg->next.compare_exchange_strong(next, fresh)) {
+                        next = fresh;
+                    }
+                    else {
+                        recycle(fresh);
+                    }
+                }
+                Segment* tail = seg;
+                m_tail.compare_exchange_strong(tail, next);
+                release(seg);
+            }
+
+            m_pushed.fetch_add(1, std::memory_order_relaxed);
+            waiter.notify();
+            return true;
+        }
+
+        template <typename Clock, typename Duration, typename... U>
+        bool emplace_back_until(std::chrono::time_point<Clock, Duration> const&,
+                                U&&... args) {
+            return try_emplace_back(std::forward<U>(args)...);
+        }
+
+        std::optional<value_type> pop_front() {
+            std::optional<value_type> given;
+            consume_front([&](value_type& data) { given = std::move(data); });
+            return given;
+        }
+
+        std::optional<value_type> try_pop() {
+            std::optional<value_type> given;
+            Taken taken;
+            if (take(taken)) {
+                consume(taken,
+                        [&](value_type& data) { given = std::move(data); });
+            }
+            return given;
+        }
+
+        template <typename Clock, typename Duration>
+        std::optional<value_type> pop_front_until(
+            std::chrono::time_point<Clock, Duration> const& time) {
+            Taken taken;
+            bool found = false;
+            waiter.wait_until(time, [&] {
+                found = take(taken);
+                return found || !m_runnable;
+            });
+
+            std::optional<value_type> given;
+            if (found || take(taken)) {
+                consume(taken,
+                        [&](value_type& data) { given = std::move(data); });
+            }
+            return given;
+        }
+
+        // after close, items pushed before it are still consumed
+        template <typename F>
+        bool consume_front(F&& func) {
+            Taken taken;
+            bool found = false;
+            waiter.wait([&] {
+                found = take(taken);
+                return found || !m_runnable;
+            });
+
+            if (!found && !take(taken)) {
+                return false;
+            }
+            consume(taken, std::forward<F>(func));
+            return true;
+        }
+
+        void close() {
+            m_runnable = false;
+            waiter.notify();
+        }
+
+        bool runnable() const {
+            return m_runnable;
+        }
+
+        bool readable() {
+            return m_runnable || size() > 0;
+        }
+
+        size_t size() const {
+            size_t popped = m_popped.load(std::memory_order_relaxed);
+            size_t pushed = m_pushed.load(std::memory_order_relaxed);
+            return pushed > popped ? pushed - popped : 0;
+        }
+
+    private:
+        static constexpr unsigned char empty = 0;
+        static constexpr unsigned char written = 1;
+        static constexpr unsigned char broken = 2;
+
+        struct Slot {
+            std::atomic<unsigned char> state;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* ptr() {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+        };
+
+        // Reference count in units of two, lowest bit marks retired one.
+        // Segment memory lives until queue is destroyed, so stale threads
+        // may count on recycled one, they validate it before use.
+        struct Segment {
+            alignas(platform::cache_line) std::atomic<size_t> enq_idx;
+            alignas(platform::cache_line) std::atomic<size_t> deq_idx;
+            alignas(platform::cache_line) std::atomic<Segment*> next;
+            std::atomic<size_t> refs;
+            Segment* free_next;
+
+            Slot slots[SegmentSize];
+
+            Segment() : refs(0), free_next(nullptr) {
+                reset();
+            }
+
+            void reset() {
+                enq_idx.store(0, std::memory_order_relaxed);
+                deq_idx.store(0, std::memory_order_relaxed);
+                next.store(nullptr, std::memory_order_relaxed);
+                for (Slot& slot : slots) {
+                    slot.state.store(empty, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        using traits = std::allocator_traits<Alloc>;
+        using seg_alloc_t =
+            typename traits::template rebind_alloc<Segment>;
+        using seg_traits = std::allocator_traits<seg_alloc_t>;
+
+        Alloc alloc;
+        seg_alloc_t seg_alloc;
+
+        std::atomic<bool> m_runnable;
+        Wait waiter;
+
+        // Push is lock free, single popper at a time under free_lock so
+        // top never comes back to the popper. On contention new segment
+        // is allocated instead, so no operation waits for the lock.
+        std::atomic<bool> free_lock;
+        std::atomic<Segment*> free_list;
+
+        alignas(platform::cache_line) std::atomic<Segment*> m_head;
+        std::atomic<size_t> m_popped;
+
+        alignas(platform::cache_line) std::atomic<Segment*> m_tail;
+        std::atomic<size_t> m_pushed;
+
+        // slot taken by consumer, its segment is counted until consumed
+        struct Taken {
+            Segment* seg = nullptr;
+            Slot* slot = nullptr;
+        };
+
+        // Take the next written slot, false if queue is empty.
+        // Runs in wait predicate, so it calls no user code.
+        bool take(Taken& taken) {
+            while (true) {
+                Segment* seg = acquire(m_head);
+                size_t idx = seg->deq_idx.load();
+
+                if (idx >= SegmentSize) {
+                    Segment* next = seg->next.load();
+                    if (next == nullptr) {
+                        release(seg);
+                        return false;
+                    }
+
+                    // unlinked from both ends before retirement
+                    Segment* head = seg;
+                    if (m_head.compare_exchange_strong(head, next)) {
+                        Segment* tail = seg;
+                        m_tail.compare_exchange_strong(tail, next);
+                        seg->refs.fetch_or(1);
+                    }
+                    release(seg);
+                    continue;
+                }
+
+                Slot& slot = seg->slots[idx];
+                unsigned char state =
+                    slot.state.load(std::memory_order_acquire);
+                if (state == empty) {
+                    if (idx >= seg->enq_idx.load()) {
+                        release(seg);
+                        return false;
+                    }
+
+                    // producer took the slot and writes it now
+                    release(seg);
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                if (!seg->deq_idx.compare_exchange_strong(idx, idx + 1)
+                    || state == broken) {
+                    release(seg);
+                    continue;
+                }
+
+                m_popped.fetch_add(1, std::memory_order_relaxed);
+                taken.seg = seg;
+                taken.slot = &slot;
+                return true;
+            }
+        }
+
+        template <typename F>
+        void consume(Taken& taken, F&& func) {
+            try {
+                func(*taken.slot->ptr());
+            }
+            catch (...) {
+                destroy(*taken.slot);
+                release(taken.seg);
+                throw;
+            }
+            destroy(*taken.slot);
+            release(taken.seg);
+        }
+
+        // count on the segment, valid while it is still linked at loc
+        Segment* acquire(std::atomic<Segment*>& loc) {
+            while (true) {
+                Segment* seg = loc.load();
+                seg->refs.fetch_add(2);
+                if (loc.load() == seg) {
+                    return seg;
+                }
+                release(seg);
+            }
+        }
+
+        // last one leaving retired segment recycles it
+        void release(Segment* seg) {
+            size_t refs = seg->refs.fetch_sub(2) - 2;
+            if (refs == 1 && seg->refs.compare_exchange_strong(refs, 0)) {
+                recycle(seg);
+            }
+        }
+
+        Segment* allocate() {
+            if (!free_lock.exchange(true, std::memory_order_acquire)) {
+                Segment* seg = free_list.load();
+                while (seg != nullptr
+                       && !free_list.compare_exchange_weak(seg,
+                                                           seg->free_next)) {
+                    // Do Nothing
+                }
+                free_lock.store(false, std::memory_order_release);
+
+                if (seg != nullptr) {
+                    seg->reset();
+                    return seg;
+                }
+            }
+
+            Segment* seg = seg_traits::allocate(seg_alloc, 1);
+            try {
+                seg_traits::construct(seg_alloc, seg);
+            }
+            catch (...) {
+                seg_traits::deallocate(seg_alloc, seg, 1);
+                throw;
+            }
+            return seg;
+        }
+
+        // stale threads may still count on it, so it is never freed
+        // before the queue, see Segment
+        void recycle(Segment* seg) {
+            Segment* top = free_list.load();
+            do {
+                seg->free_next = top;
+            } while (!free_list.compare_exchange_weak(top, seg));
+        }
+
+        void deallocate(Segment* seg) {
+            seg_traits::destroy(seg_alloc, seg);
+            seg_traits::deallocate(seg_alloc, seg, 1);
+        }
+
+        void destroy(Slot& slot) {
+            traits::destroy(alloc, slot.ptr());
+        }
+    };
+}  // namespace LockFree
+
+#endif
\ No newline at end of file
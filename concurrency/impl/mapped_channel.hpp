@@ -0,0 +1,14 @@
+#ifndef MAPPED_CHANNEL_HPP
+#define MAPPED_CHANNEL_HPP
+
+#include "channel.hpp"
+#include "container/mapped_queue.hpp"
+#include "container/thread_safe.hpp"
+
+template <typename T>
+using TSMappedQueue = ThreadSafe<MappedQueue<T>>;
+
+template <typename T>
+using MappedChannel = Channel<TSMappedQueue<T>>;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,275 @@
+#ifndef MUTEX_HPP
+#define MUTEX_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "platform/constant.hpp"
+#include "platform/cpu.hpp"
+#include "policy.hpp"
+
+// Test and test-and-set spinlock, waiters spin on plain load
+// so the cache line is not bounced until the lock looks free.
+class SpinLock {
+public:
+    SpinLock() : locked(false) {
+        // Do Nothing
+    }
+
+    SpinLock(SpinLock const&) = delete;
+    SpinLock(SpinLock&&) = delete;
+
+    SpinLock& operator=(SpinLock const&) = delete;
+    SpinLock& operator=(SpinLock&&) = delete;
+
+    void lock() {
+        while (locked.exchange(true, std::memory_order_acquire)) {
+            for (size_t spin = 0; locked.load(std::memory_order_relaxed);
+                 ++spin) {
+                if (spin < max_spin) {
+                    platform::cpu_relax();
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    bool try_lock() {
+        return !locked.load(std::memory_order_relaxed)
+               && !locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        locked.store(false, std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t max_spin = 64;
+
+    std::atomic<bool> locked;
+};
+
+// Fair spinlock, threads are served in the order they took tickets.
+class TicketLock {
+public:
+    TicketLock() : next(0), serving(0) {
+        // Do Nothing
+    }
+
+    TicketLock(TicketLock const&) = delete;
+    TicketLock(TicketLock&&) = delete;
+
+    TicketLock& operator=(TicketLock const&) = delete;
+    TicketLock& operator=(TicketLock&&) = delete;
+
+    void lock() {
+        size_t ticket = next.fetch_add(1, std::memory_order_relaxed);
+        for (size_t spin = 0;
+             serving.load(std::memory_order_acquire) != ticket;
+             ++spin) {
+            if (spin < max_spin) {
+                platform::cpu_relax();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // take ticket only if it would be served right now
+    bool try_lock() {
+        size_t ticket = serving.load(std::memory_order_acquire);
+        return next.compare_exchange_strong(
+            ticket, ticket + 1, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        serving.store(serving.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t max_spin = 64;
+
+    alignas(platform::cache_line) std::atomic<size_t> next;
+    alignas(platform::cache_line) std::atomic<size_t> serving;
+};
+
+// Spin shortly for lock held over a few instructions, then park.
+// Unlock touches the park mutex only if some thread is parked.
+class AdaptiveMutex {
+public:
+    AdaptiveMutex() : locked(false), num_parked(0) {
+        // Do Nothing
+    }
+
+    AdaptiveMutex(AdaptiveMutex const&) = delete;
+    AdaptiveMutex(AdaptiveMutex&&) = delete;
+
+    AdaptiveMutex& operator=(AdaptiveMutex const&) = delete;
+    AdaptiveMutex& operator=(AdaptiveMutex&&) = delete;
+
+    void lock() {
+        for (size_t spin = 0; spin < max_spin; ++spin) {
+            if (try_lock()) {
+                return;
+            }
+            platform::cpu_relax();
+        }
+
+        ++num_parked;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock lock(mutex);
+            cond.wait(lock, [&] { return try_lock(); });
+        }
+        --num_parked;
+    }
+
+    bool try_lock() {
+        return !locked.load(std::memory_order_relaxed)
+               && !locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        locked.store(false, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (num_parked.load() > 0) {
+            std::unique_lock lock(mutex);
+            cond.notify_one();
+        }
+    }
+
+private:
+    static constexpr size_t max_spin = 128;
+
+    std::atomic<bool> locked;
+    std::atomic<size_t> num_parked;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+// Reader writer lock with reader counts spread over cache line lanes,
+// so readers of different cores do not bounce a shared counter.
+// Writers are preferred, reader backs off while writer is present.
+class ShardedSharedMutex {
+public:
+    ShardedSharedMutex()
+        : ShardedSharedMutex(
+            std::max(1u, std::thread::hardware_concurrency())) {
+        // Do Nothing
+    }
+
+    // lanes are rounded up to power of two
+    ShardedSharedMutex(size_t num_lanes)
+        : num_lanes(ceil_pow2(num_lanes)),
+          lanes(std::make_unique<Lane[]>(this->num_lanes)), writer(false) {
+        // Do Nothing
+    }
+
+    ShardedSharedMutex(ShardedSharedMutex const&) = delete;
+    ShardedSharedMutex(ShardedSharedMutex&&) = delete;
+
+    ShardedSharedMutex& operator=(ShardedSharedMutex const&) = delete;
+    ShardedSharedMutex& operator=(ShardedSharedMutex&&) = delete;
+
+    void lock() {
+        writer_mutex.lock();
+        writer.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        readers_left.wait([&] { return num_readers() == 0; });
+    }
+
+    bool try_lock() {
+        if (!writer_mutex.try_lock()) {
+            return false;
+        }
+        writer.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (num_readers() > 0) {
+            unlock();
+            return false;
+        }
+        return true;
+    }
+
+    void unlock() {
+        writer.store(false, std::memory_order_release);
+        writer_mutex.unlock();
+        writer_left.notify();
+    }
+
+    void lock_shared() {
+        while (!try_lock_shared()) {
+            writer_left.wait(
+                [&] { return !writer.load(std::memory_order_acquire); });
+        }
+    }
+
+    // Count first and check writer after, writer does the reverse,
+    // so either of them sees the other.
+    bool try_lock_shared() {
+        std::atomic<size_t>& readers = lane().readers;
+        readers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!writer.load(std::memory_order_acquire)) {
+            return true;
+        }
+        unlock_shared();
+        return false;
+    }
+
+    void unlock_shared() {
+        lane().readers.fetch_sub(1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writer.load(std::memory_order_relaxed)) {
+            readers_left.notify();
+        }
+    }
+
+private:
+    struct alignas(platform::cache_line) Lane {
+        std::atomic<size_t> readers = 0;
+    };
+
+    size_t num_lanes;
+    std::unique_ptr<Lane[]> lanes;
+
+    alignas(platform::cache_line) std::atomic<bool> writer;
+    std::mutex writer_mutex;
+
+    Policy::Adaptive readers_left;
+    Policy::Adaptive writer_left;
+
+    static size_t ceil_pow2(size_t value) {
+        size_t pow = 1;
+        while (pow < value) {
+            pow <<= 1;
+        }
+        return pow;
+    }
+
+    // reader unlocks on the lane it locked, thread hash is cached
+    Lane& lane() {
+        return lanes[platform::thread_hash() & (num_lanes - 1)];
+    }
+
+    size_t num_readers() const {
+        size_t sum = 0;
+        for (size_t i = 0; i < num_lanes; ++i) {
+            sum += lanes[i].readers.load(std::memory_order_acquire);
+        }
+        return sum;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,179 @@
+#ifndef OBJECT_POOL_HPP
+#define OBJECT_POOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mutex.hpp"
+#include "platform/constant.hpp"
+#include "platform/cpu.hpp"
+
+// Pool of reusable objects as golang sync.Pool.
+// Threads keep objects in their own lane, lane over capacity hands half
+// of it to shared stock in one batch and empty lane takes one batch back,
+// so objects returned by consumer reach producer without per object lock.
+// Trim drops stock unused since previous Trim, call it on idle or timer.
+template <typename T>
+class ObjectPool {
+public:
+    // returns object to the pool instead of freeing it
+    struct Recycler {
+        ObjectPool* pool = nullptr;
+
+        void operator()(T* ptr) const {
+            if (pool != nullptr) {
+                pool->recycle(ptr);
+            }
+            else {
+                delete ptr;
+            }
+        }
+    };
+
+    // pool should outlive its handles
+    using Handle = std::unique_ptr<T, Recycler>;
+
+    // reset clears returned object, e.g. buffer keeps capacity only
+    ObjectPool(std::function<std::unique_ptr<T>()> factory = nullptr,
+               std::function<void(T&)> reset = nullptr,
+               size_t capacity = 64)
+        : factory(std::move(factory)), reset(std::move(reset)),
+          capacity(std::max<size_t>(capacity, 2)),
+          num_lanes(std::max(1u, std::thread::hardware_concurrency())),
+          lanes(std::make_unique<Lane[]>(num_lanes)) {
+        // Do Nothing
+    }
+
+    ~ObjectPool() {
+        for (size_t i = 0; i < num_lanes; ++i) {
+            release(lanes[i].cache);
+        }
+        for (auto& batch : stock) {
+            release(batch);
+        }
+        for (auto& batch : victim) {
+            release(batch);
+        }
+    }
+
+    ObjectPool(ObjectPool const&) = delete;
+    ObjectPool(ObjectPool&&) = delete;
+
+    ObjectPool& operator=(ObjectPool const&) = delete;
+    ObjectPool& operator=(ObjectPool&&) = delete;
+
+    // cached object if any, otherwise made by factory
+    Handle Get() {
+        Lane& own = lane();
+        {
+            std::unique_lock lock(own.lock);
+            if (own.cache.empty()) {
+                refill(own);
+            }
+            if (!own.cache.empty()) {
+                T* ptr = own.cache.back();
+                own.cache.pop_back();
+                return Handle(ptr, Recycler{ this });
+            }
+        }
+
+        std::unique_ptr<T> made =
+            factory ? factory() : std::make_unique<T>();
+        return Handle(made.release(), Recycler{ this });
+    }
+
+    // Free batches untouched since previous Trim, then age the rest.
+    // Objects cached in lanes are bounded by capacity and kept.
+    void Trim() {
+        std::vector<std::vector<T*>> expired;
+        {
+            std::unique_lock lock(mutex);
+            expired.swap(victim);
+            victim.swap(stock);
+        }
+        for (auto& batch : expired) {
+            release(batch);
+        }
+    }
+
+private:
+    struct alignas(platform::cache_line) Lane {
+        SpinLock lock;
+        std::vector<T*> cache;
+    };
+
+    std::function<std::unique_ptr<T>()> factory;
+    std::function<void(T&)> reset;
+    size_t capacity;
+
+    size_t num_lanes;
+    std::unique_ptr<Lane[]> lanes;
+
+    std::mutex mutex;
+    std::vector<std::vector<T*>> stock;
+    std::vector<std::vector<T*>> victim;
+
+    Lane& lane() {
+        return lanes[platform::thread_hash() % num_lanes];
+    }
+
+    // take one batch from shared stock, newer one first
+    void refill(Lane& own) {
+        std::unique_lock lock(mutex);
+        for (auto* from : { &stock, &victim }) {
+            if (!from->empty()) {
+                own.cache.swap(from->back());
+                from->pop_back();
+                return;
+            }
+        }
+    }
+
+    void recycle(T* ptr) {
+        if (reset) {
+            try {
+                reset(*ptr);
+            }
+            catch (...) {
+                delete ptr;
+                return;
+            }
+        }
+
+        std::vector<T*> batch;
+        {
+            Lane& own = lane();
+            std::unique_lock lock(own.lock);
+            own.cache.push_back(ptr);
+            if (own.cache.size() < capacity) {
+                return;
+            }
+
+            // hand older half over, so lane keeps the warm ones
+            size_t half = own.cache.size() / 2;
+            batch.assign(own.cache.begin(), own.cache.begin() + half);
+            own.cache.erase(own.cache.begin(), own.cache.begin() + half);
+        }
+
+        std::unique_lock lock(mutex);
+        stock.push_back(std::move(batch));
+    }
+
+    static void release(std::vector<T*>& batch) {
+        for (T* ptr : batch) {
+            delete ptr;
+        }
+        batch.clear();
+    }
+};
+
+// handle of pooled object, movable through channels as payload
+template <typename T>
+using Pooled = typename ObjectPool<T>::Handle;
+
+#endif
\ No newline at end of file
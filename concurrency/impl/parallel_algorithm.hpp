@@ -0,0 +1,322 @@
+#ifndef PARALLEL_ALGORITHM_HPP
+#define PARALLEL_ALGORITHM_HPP
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "wait_group.hpp"
+
+// pool type which has GetNumThreads, to split overloads with and without pool
+template <typename Pool>
+using pool_threads_t = decltype(std::declval<Pool&>().GetNumThreads());
+
+// Split [0, count) into contiguous chunks of at least grain elements,
+// one per worker and one for the caller, and wait them with WaitGroup.
+// Tasks should not block on the same pool, workers would be exhausted.
+template <typename Pool, typename F, typename = pool_threads_t<Pool>>
+void parallel_for(Pool& pool, size_t count, F&& func, size_t grain = 1) {
+    if (count == 0) {
+        return;
+    }
+
+    size_t num_chunks = std::min(pool.GetNumThreads() + 1,
+                                 std::max<size_t>(count / grain, 1));
+    if (num_chunks == 1) {
+        func(size_t(0), count);
+        return;
+    }
+
+    std::mutex mutex;
+    std::exception_ptr error;
+    auto run = [&](size_t chunk) {
+        try {
+            func(count * chunk / num_chunks, count * (chunk + 1) / num_chunks);
+        }
+        catch (...) {
+            std::unique_lock lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    WaitGroup wg(num_chunks - 1);
+    for (size_t i = 1; i < num_chunks; ++i) {
+        pool.Add([&, i] {
+            run(i);
+            wg.Done();
+        });
+    }
+    run(0);
+    wg.Wait();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Reduce with independent accumulators, so dependency chain is broken
+// and compiler could keep them in vector lanes.
+// Op should be associative and commutative as std::reduce.
+template <typename Iter, typename T, typename Op>
+T reduce_leaf(Iter first, Iter last, T init, Op op) {
+    constexpr size_t lanes = 4;
+
+    size_t size = std::distance(first, last);
+    if (size < 2 * lanes) {
+        return std::accumulate(first, last, init, op);
+    }
+
+    T acc[lanes] = { T(first[0]), T(first[1]), T(first[2]), T(first[3]) };
+
+    size_t i = lanes;
+    for (; i + lanes <= size; i += lanes) {
+        acc[0] = op(acc[0], first[i]);
+        acc[1] = op(acc[1], first[i + 1]);
+        acc[2] = op(acc[2], first[i + 2]);
+        acc[3] = op(acc[3], first[i + 3]);
+    }
+    for (; i < size; ++i) {
+        acc[0] = op(acc[0], first[i]);
+    }
+    return op(init, op(op(acc[0], acc[1]), op(acc[2], acc[3])));
+}
+
+template <typename Pool,
+          typename Iter,
+          typename T,
+          typename Op = std::plus<>,
+          typename = pool_threads_t<Pool>>
+T parallel_reduce(Pool& pool, Iter first, Iter last, T init, Op op = Op()) {
+    constexpr size_t grain = 1 << 14;
+    size_t size = std::distance(first, last);
+
+    size_t num_chunks =
+        std::min(pool.GetNumThreads() + 1, std::max<size_t>(size / grain, 1));
+    std::vector<std::optional<T>> partial(num_chunks);
+
+    parallel_for(pool, num_chunks, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            Iter lo = first + size * chunk / num_chunks;
+            Iter hi = first + size * (chunk + 1) / num_chunks;
+            if (lo != hi) {
+                partial[chunk] = reduce_leaf(lo + 1, hi, T(*lo), op);
+            }
+        }
+    });
+
+    for (auto& value : partial) {
+        if (value.has_value()) {
+            init = op(init, std::move(value.value()));
+        }
+    }
+    return init;
+}
+
+// three passes, chunk sums in parallel, scan of sums in caller,
+// then each chunk scans from its offset in parallel
+template <typename Pool,
+          typename Iter,
+          typename OutIter,
+          typename Op = std::plus<>,
+          typename = pool_threads_t<Pool>>
+OutIter parallel_inclusive_scan(
+    Pool& pool, Iter first, Iter last, OutIter d_first, Op op = Op()) {
+    using T = typename std::iterator_traits<Iter>::value_type;
+    constexpr size_t grain = 1 << 14;
+
+    size_t size = std::distance(first, last);
+    size_t num_chunks =
+        std::min(pool.GetNumThreads() + 1, std::max<size_t>(size / grain, 1));
+    if (num_chunks == 1) {
+        return std::inclusive_scan(first, last, d_first, op);
+    }
+
+    auto bound = [&](size_t chunk) { return size * chunk / num_chunks; };
+
+    std::vector<std::optional<T>> sums(num_chunks);
+    parallel_for(pool, num_chunks - 1, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            Iter lo = first + bound(chunk);
+            Iter hi = first + bound(chunk + 1);
+            sums[chunk] = reduce_leaf(lo + 1, hi, T(*lo), op);
+        }
+    });
+
+    for (size_t chunk = 1; chunk < num_chunks - 1; ++chunk) {
+        sums[chunk] = op(sums[chunk - 1].value(), sums[chunk].value());
+    }
+
+    parallel_for(pool, num_chunks, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            Iter lo = first + bound(chunk);
+            Iter hi = first + bound(chunk + 1);
+            OutIter out = d_first + bound(chunk);
+            if (chunk == 0) {
+                std::inclusive_scan(lo, hi, out, op);
+            }
+            else {
+                std::inclusive_scan(lo, hi, out, op, sums[chunk - 1].value());
+            }
+        }
+    });
+    return d_first + size;
+}
+
+// Sort chunks in parallel, then merge sorted runs pairwise in rounds.
+// Each merge is split at binary searched points, so last rounds with
+// few runs still keep all workers busy. Not stable.
+template <typename Pool,
+          typename Iter,
+          typename Compare = std::less<>,
+          typename = pool_threads_t<Pool>>
+void parallel_sort(Pool& pool,
+                   Iter first,
+                   Iter last,
+                   Compare comp = Compare()) {
+    using T = typename std::iterator_traits<Iter>::value_type;
+    constexpr size_t grain = 1 << 14;
+
+    size_t size = std::distance(first, last);
+    size_t num_runs =
+        std::min(pool.GetNumThreads() + 1, std::max<size_t>(size / grain, 1));
+    if (num_runs == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<size_t> bounds;
+    for (size_t run = 0; run <= num_runs; ++run) {
+        bounds.push_back(size * run / num_runs);
+    }
+
+    parallel_for(pool, num_runs, [&](size_t begin, size_t end) {
+        for (size_t run = begin; run < end; ++run) {
+            std::sort(first + bounds[run], first + bounds[run + 1], comp);
+        }
+    });
+
+    // merge [a_lo, a_hi) and [b_lo, b_hi) into buffer from out
+    struct Job {
+        size_t a_lo, a_hi, b_lo, b_hi, out;
+    };
+
+    std::vector<T> buffer(size);
+    std::vector<Job> jobs;
+    while (bounds.size() > 2) {
+        size_t num_pairs = bounds.size() / 2;
+        size_t parts = (num_runs + num_pairs - 1) / num_pairs;
+
+        jobs.clear();
+        std::vector<size_t> merged{ 0 };
+        for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+            size_t lo = bounds[i];
+            size_t mid = bounds[i + 1];
+            size_t hi = i + 2 < bounds.size() ? bounds[i + 2] : mid;
+            merged.push_back(hi);
+
+            // split longer run evenly and shorter one at lower bound of
+            // splitter, so every part merges only its own elements
+            bool a_longer = mid - lo >= hi - mid;
+            size_t long_lo = a_longer ? lo : mid;
+            size_t long_hi = a_longer ? mid : hi;
+            size_t short_lo = a_longer ? mid : lo;
+            size_t short_hi = a_longer ? hi : mid;
+
+            size_t prev_long = long_lo;
+            size_t prev_short = short_lo;
+            for (size_t part = 1; part <= parts; ++part) {
+                size_t at_long =
+                    long_lo + (long_hi - long_lo) * part / parts;
+                size_t at_short = short_hi;
+                if (at_long < long_hi) {
+                    at_short = std::lower_bound(first + short_lo,
+                                                first + short_hi,
+                                                first[at_long],
+                                                comp)
+                               - first;
+                }
+
+                size_t out = lo + (prev_long - long_lo)
+                             + (prev_short - short_lo);
+                if (a_longer) {
+                    jobs.push_back(
+                        { prev_long, at_long, prev_short, at_short, out });
+                }
+                else {
+                    jobs.push_back(
+                        { prev_short, at_short, prev_long, at_long, out });
+                }
+                prev_long = at_long;
+                prev_short = at_short;
+            }
+        }
+
+        parallel_for(pool, jobs.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Job const& job = jobs[i];
+                std::merge(std::make_move_iterator(first + job.a_lo),
+                           std::make_move_iterator(first + job.a_hi),
+                           std::make_move_iterator(first + job.b_lo),
+                           std::make_move_iterator(first + job.b_hi),
+                           buffer.begin() + job.out,
+                           comp);
+            }
+        });
+
+        parallel_for(
+            pool,
+            size,
+            [&](size_t begin, size_t end) {
+                std::move(buffer.begin() + begin,
+                          buffer.begin() + end,
+                          first + begin);
+            },
+            grain);
+
+        bounds.swap(merged);
+    }
+}
+
+template <typename Iter,
+          typename Compare = std::less<>,
+          typename = typename std::iterator_traits<Iter>::iterator_category>
+void parallel_sort(Iter first, Iter last, Compare comp = Compare()) {
+    ThreadPool<void> pool(std::max(1u, std::thread::hardware_concurrency())
+                          - 1);
+    parallel_sort(pool, first, last, comp);
+}
+
+template <typename Iter,
+          typename OutIter,
+          typename Op = std::plus<>,
+          typename = typename std::iterator_traits<Iter>::iterator_category>
+OutIter parallel_inclusive_scan(Iter first,
+                                Iter last,
+                                OutIter d_first,
+                                Op op = Op()) {
+    ThreadPool<void> pool(std::max(1u, std::thread::hardware_concurrency())
+                          - 1);
+    return parallel_inclusive_scan(pool, first, last, d_first, op);
+}
+
+template <typename Iter,
+          typename T,
+          typename Op = std::plus<>,
+          typename = typename std::iterator_traits<Iter>::iterator_category>
+T parallel_reduce(Iter first, Iter last, T init, Op op = Op()) {
+    ThreadPool<void> pool(std::max(1u, std::thread::hardware_concurrency())
+                          - 1);
+    return parallel_reduce(pool, first, last, std::move(init), op);
+}
+
+#endif
\ No newline at end of file
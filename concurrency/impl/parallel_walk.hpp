@@ -0,0 +1,178 @@
+#ifndef PARALLEL_WALK_HPP
+#define PARALLEL_WALK_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+struct WalkOptions {
+    // depth of directories to descend, 0 for entries of root only
+    size_t max_depth = std::numeric_limits<size_t>::max();
+    // number of subdirectories to descend per directory
+    size_t max_fanout = std::numeric_limits<size_t>::max();
+    // number of directories read at the same time
+    size_t max_concurrency = std::thread::hardware_concurrency();
+    // number of directories taken from shared queue at once
+    size_t batch_size = 16;
+    bool follow_symlinks = false;
+};
+
+// Walk directory tree with bounded number of workers, caller included.
+// Each worker accumulates visited entries into its own copy of init,
+// and results are merged with reduce once per worker.
+template <typename Pool, typename T, typename Visit, typename Reduce>
+T parallel_walk(Pool& pool,
+                std::filesystem::path const& root,
+                T init,
+                Visit&& visit,
+                Reduce&& reduce,
+                WalkOptions const& options = WalkOptions()) {
+    namespace fs = std::filesystem;
+    using dir_t = std::pair<fs::path, size_t>;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    std::vector<dir_t> pending{ dir_t(root, 0) };
+    size_t active = 0;
+
+    T result = init;
+    std::exception_ptr error;
+
+    auto walk_dir = [&](dir_t const& dir,
+                        T& local,
+                        std::vector<dir_t>& found) {
+        auto const& [path, depth] = dir;
+        auto flag = fs::directory_options::skip_permission_denied;
+        if (options.follow_symlinks) {
+            flag |= fs::directory_options::follow_directory_symlink;
+        }
+
+        std::error_code ec;
+        size_t fanout = 0;
+        for (fs::directory_iterator iter(path, flag, ec), end;
+             !ec && iter != end;
+             iter.increment(ec)) {
+            fs::directory_entry const& entry = *iter;
+            visit(local, entry);
+
+            if (depth < options.max_depth && fanout < options.max_fanout) {
+                std::error_code type_ec;
+                bool is_dir = entry.is_directory(type_ec)
+                              && (options.follow_symlinks
+                                  || !entry.is_symlink(type_ec));
+                if (is_dir) {
+                    found.emplace_back(entry.path(), depth + 1);
+                    ++fanout;
+                }
+            }
+        }
+    };
+
+    auto worker = [&] {
+        T local = init;
+        std::vector<dir_t> batch;
+        std::vector<dir_t> found;
+
+        std::unique_lock lock(mutex);
+        while (true) {
+            cond.wait(lock, [&] { return !pending.empty() || active == 0; });
+            if (pending.empty()) {
+                break;
+            }
+
+            size_t num = std::min(std::max<size_t>(options.batch_size, 1),
+                                  pending.size());
+            batch.assign(std::make_move_iterator(pending.end() - num),
+                         std::make_move_iterator(pending.end()));
+            pending.resize(pending.size() - num);
+
+            ++active;
+            lock.unlock();
+
+            try {
+                for (auto const& dir : batch) {
+                    walk_dir(dir, local, found);
+                }
+            }
+            catch (...) {
+                lock.lock();
+                if (!error) {
+                    error = std::current_exception();
+                }
+                pending.clear();
+                found.clear();
+                lock.unlock();
+            }
+            batch.clear();
+
+            lock.lock();
+            --active;
+            pending.insert(pending.end(),
+                           std::make_move_iterator(found.begin()),
+                           std::make_move_iterator(found.end()));
+            found.clear();
+            cond.notify_all();
+        }
+        result = reduce(std::move(result), std::move(local));
+    };
+
+    size_t num_workers = std::min(std::max<size_t>(options.max_concurrency, 1),
+                                  pool.GetNumThreads() + 1);
+
+    std::vector<std::future<void>> futs;
+    for (size_t i = 1; i < num_workers; ++i) {
+        futs.emplace_back(pool.Add(worker));
+    }
+    worker();
+
+    for (auto& fut : futs) {
+        fut.get();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return result;
+}
+
+template <typename T, typename Visit, typename Reduce>
+T parallel_walk(std::filesystem::path const& root,
+                T init,
+                Visit&& visit,
+                Reduce&& reduce,
+                WalkOptions const& options = WalkOptions()) {
+    ThreadPool<void> pool(std::max<size_t>(options.max_concurrency, 1) - 1);
+    return parallel_walk(pool,
+                         root,
+                         std::move(init),
+                         std::forward<Visit>(visit),
+                         std::forward<Reduce>(reduce),
+                         options);
+}
+
+template <typename Visit>
+void parallel_walk(std::filesystem::path const& root,
+                   Visit&& visit,
+                   WalkOptions const& options = WalkOptions()) {
+    parallel_walk(
+        root,
+        0,
+        [&](int&, std::filesystem::directory_entry const& entry) {
+            visit(entry);
+        },
+        [](int, int) { return 0; },
+        options);
+}
+
+#endif
\ No newline at end of file
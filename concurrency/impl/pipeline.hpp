@@ -0,0 +1,350 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "channel.hpp"
+#include "thread_pool.hpp"
+
+namespace Pipeline {
+    // Threads and links of single pipeline.
+    // Failure of any stage closes every link, so all stages drain and stop.
+    class Runtime {
+    public:
+        Runtime() = default;
+
+        ~Runtime() {
+            Abort();
+            Join();
+        }
+
+        Runtime(Runtime const&) = delete;
+        Runtime(Runtime&&) = delete;
+
+        Runtime& operator=(Runtime const&) = delete;
+        Runtime& operator=(Runtime&&) = delete;
+
+        template <typename F>
+        void Spawn(F&& func) {
+            std::unique_lock lock(mutex);
+            threads.emplace_back(
+                [this, func = std::forward<F>(func)]() mutable {
+                    try {
+                        func();
+                    }
+                    catch (...) {
+                        Fail(std::current_exception());
+                    }
+                });
+        }
+
+        template <typename C>
+        void Own(std::shared_ptr<C> const& channel) {
+            std::unique_lock lock(mutex);
+            closers.emplace_back([channel] { channel->Close(); });
+        }
+
+        void Fail(std::exception_ptr except) {
+            {
+                std::unique_lock lock(mutex);
+                if (!error) {
+                    error = except;
+                }
+            }
+            Abort();
+        }
+
+        void Abort() {
+            std::vector<std::function<void()>> closing;
+            {
+                std::unique_lock lock(mutex);
+                closing = closers;
+            }
+            for (auto& close : closing) {
+                close();
+            }
+        }
+
+        void Join() {
+            std::vector<std::thread> joining;
+            {
+                std::unique_lock lock(mutex);
+                joining.swap(threads);
+            }
+            for (auto& thread : joining) {
+                thread.join();
+            }
+        }
+
+        void Wait() {
+            Join();
+
+            std::unique_lock lock(mutex);
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+    private:
+        std::mutex mutex;
+        std::exception_ptr error;
+        std::vector<std::thread> threads;
+        std::vector<std::function<void()>> closers;
+    };
+
+    // Output of a stage, links to the next stage with bounded channel.
+    template <typename T>
+    class Flow {
+    public:
+        using value_type = T;
+
+        Flow(std::shared_ptr<Runtime> runtime, size_t capacity)
+            : runtime(std::move(runtime)), capacity(capacity),
+              channel(std::make_shared<RChannel<T>>(capacity)) {
+            this->runtime->Own(channel);
+        }
+
+        RChannel<T>& Output() const {
+            return *channel;
+        }
+
+        std::shared_ptr<Runtime> runtime;
+        size_t capacity;
+        std::shared_ptr<RChannel<T>> channel;
+    };
+
+    // Handle of terminated pipeline, waits all stages on destruction.
+    class Completion {
+    public:
+        Completion(std::shared_ptr<Runtime> runtime)
+            : runtime(std::move(runtime)) {
+            // Do Nothing
+        }
+
+        ~Completion() {
+            if (runtime != nullptr) {
+                runtime->Join();
+            }
+        }
+
+        Completion(Completion const&) = delete;
+        Completion(Completion&&) = default;
+
+        Completion& operator=(Completion const&) = delete;
+        Completion& operator=(Completion&&) = default;
+
+        // wait until sink consumes all, rethrow first failure of stages
+        void Wait() {
+            runtime->Wait();
+        }
+
+    private:
+        std::shared_ptr<Runtime> runtime;
+    };
+
+    template <typename F>
+    struct MapStage {
+        F func;
+        size_t parallelism;
+        bool ordered;
+    };
+
+    template <typename F>
+    struct FilterStage {
+        F pred;
+        size_t parallelism;
+    };
+
+    struct BatchStage {
+        size_t size;
+    };
+
+    template <typename F>
+    struct SinkStage {
+        F func;
+        size_t parallelism;
+    };
+
+    // generator returns std::optional<T>, std::nullopt for end of stream
+    template <typename F>
+    auto source(F&& gen, size_t capacity = 64) {
+        using T = typename std::invoke_result_t<std::decay_t<F>&>::value_type;
+
+        Flow<T> flow(std::make_shared<Runtime>(), capacity);
+        flow.runtime->Spawn(
+            [gen = std::forward<F>(gen), out = flow.channel]() mutable {
+                for (auto item = gen(); item.has_value() && out->Runnable();
+                     item = gen()) {
+                    out->Add(std::move(item.value()));
+                }
+                out->Close();
+            });
+        return flow;
+    }
+
+    template <typename C>
+    auto from(C container, size_t capacity = 64) {
+        auto data = std::make_shared<C>(std::move(container));
+        return source(
+            [data, iter = data->begin()]() mutable {
+                using T = typename C::value_type;
+                if (iter == data->end()) {
+                    return std::optional<T>();
+                }
+                return std::optional<T>(*iter++);
+            },
+            capacity);
+    }
+
+    template <typename F>
+    auto map(F&& func, size_t parallelism = 1) {
+        return MapStage<std::decay_t<F>>{ std::forward<F>(func),
+                                          parallelism,
+                                          false };
+    }
+
+    // parallel map which keeps order of the input
+    template <typename F>
+    auto ordered_map(F&& func, size_t parallelism = 1) {
+        return MapStage<std::decay_t<F>>{ std::forward<F>(func),
+                                          parallelism,
+                                          true };
+    }
+
+    template <typename F>
+    auto filter(F&& pred, size_t parallelism = 1) {
+        return FilterStage<std::decay_t<F>>{ std::forward<F>(pred),
+                                             parallelism };
+    }
+
+    inline BatchStage batch(size_t size) {
+        return BatchStage{ size };
+    }
+
+    template <typename F>
+    auto sink(F&& func, size_t parallelism = 1) {
+        return SinkStage<std::decay_t<F>>{ std::forward<F>(func),
+                                           parallelism };
+    }
+
+    // run body(input, output) on workers, last finished one closes output
+    template <typename U, typename T, typename Body>
+    Flow<U> spawn_stage(Flow<T> const& flow, size_t parallelism, Body body) {
+        Flow<U> next(flow.runtime, flow.capacity);
+        parallelism = std::max<size_t>(parallelism, 1);
+
+        auto remaining = std::make_shared<std::atomic<size_t>>(parallelism);
+        for (size_t i = 0; i < parallelism; ++i) {
+            flow.runtime->Spawn(
+                [=, in = flow.channel, out = next.channel]() mutable {
+                    body(*in, *out);
+                    if (--*remaining == 0) {
+                        out->Close();
+                    }
+                });
+        }
+        return next;
+    }
+
+    template <typename T, typename F>
+    auto operator|(Flow<T> const& flow, MapStage<F> const& stage) {
+        using U = std::decay_t<std::invoke_result_t<F&, T>>;
+        static_assert(!std::is_void_v<U>, "use sink for void function");
+
+        if (!stage.ordered || stage.parallelism <= 1) {
+            return spawn_stage<U>(
+                flow,
+                stage.parallelism,
+                [func = stage.func](RChannel<T>& in, RChannel<U>& out) mutable {
+                    for (auto& item : in) {
+                        out.Add(func(std::move(item)));
+                    }
+                });
+        }
+
+        // results are reordered with futures of thread pool
+        auto pool = std::make_shared<ThreadPool<U>>(stage.parallelism,
+                                                    flow.capacity);
+        auto order = std::make_shared<RChannel<std::future<U>>>(flow.capacity);
+        flow.runtime->Own(order);
+
+        auto func = std::make_shared<F>(stage.func);
+
+        flow.runtime->Spawn([pool, order, func, in = flow.channel] {
+            for (auto& item : *in) {
+                order->Add(pool->Add([func, item = std::move(item)]() mutable {
+                    return (*func)(std::move(item));
+                }));
+            }
+            order->Close();
+        });
+
+        return spawn_stage<U>(
+            flow, 1, [pool, order](RChannel<T>&, RChannel<U>& out) {
+                for (auto& fut : *order) {
+                    out.Add(fut.get());
+                }
+            });
+    }
+
+    template <typename T, typename F>
+    Flow<T> operator|(Flow<T> const& flow, FilterStage<F> const& stage) {
+        return spawn_stage<T>(
+            flow,
+            stage.parallelism,
+            [pred = stage.pred](RChannel<T>& in, RChannel<T>& out) mutable {
+                for (auto& item : in) {
+                    if (pred(item)) {
+                        out.Add(std::move(item));
+                    }
+                }
+            });
+    }
+
+    template <typename T>
+    Flow<std::vector<T>> operator|(Flow<T> const& flow,
+                                   BatchStage const& stage) {
+        size_t size = std::max<size_t>(stage.size, 1);
+        return spawn_stage<std::vector<T>>(
+            flow, 1, [size](RChannel<T>& in, RChannel<std::vector<T>>& out) {
+                std::vector<T> chunk;
+                for (auto& item : in) {
+                    chunk.push_back(std::move(item));
+                    if (chunk.size() == size) {
+                        out.Add(std::move(chunk));
+                        chunk = std::vector<T>();
+                    }
+                }
+                if (!chunk.empty()) {
+                    out.Add(std::move(chunk));
+                }
+            });
+    }
+
+    template <typename T, typename F>
+    Completion operator|(Flow<T> const& flow, SinkStage<F> const& stage) {
+        size_t parallelism = std::max<size_t>(stage.parallelism, 1);
+        for (size_t i = 0; i < parallelism; ++i) {
+            flow.runtime->Spawn(
+                [func = stage.func, in = flow.channel]() mutable {
+                    for (auto& item : *in) {
+                        func(std::move(item));
+                    }
+                });
+        }
+        return Completion(flow.runtime);
+    }
+}  // namespace Pipeline
+
+#endif
\ No newline at end of file
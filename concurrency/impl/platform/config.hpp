@@ -0,0 +1,14 @@
+#ifndef PLATFORM_CONFIG_HPP
+#define PLATFORM_CONFIG_HPP
+
+namespace platform {
+    // define CONCURRENCY_TRACE before include to record trace events,
+    // otherwise every trace call is discarded at compile time
+#ifdef CONCURRENCY_TRACE
+    constexpr bool trace = true;
+#else
+    constexpr bool trace = false;
+#endif
+}  // namespace platform
+
+#endif
\ No newline at end of file
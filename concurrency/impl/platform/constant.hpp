@@ -3,6 +3,7 @@
 
 // merge:include
 #include <chrono>
+#include <cstddef>
 // merge:end
 
 namespace platform {
@@ -13,6 +14,14 @@ namespace platform {
     // constexpr auto prevent_deadlock = 150us;  // for personal mac
     constexpr auto prevent_deadlock = 500us;  // for azure-pipeline mac
 #endif
+
+    // fixed instead of std::hardware_destructive_interference_size,
+    // which may vary with compiler flags and break ABI of headers
+#if defined(__APPLE__) && defined(__aarch64__)
+    constexpr size_t cache_line = 128;
+#else
+    constexpr size_t cache_line = 64;
+#endif
 }  // namespace platform
 
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef PLATFORM_CPU_HPP
+#define PLATFORM_CPU_HPP
+
+// merge:np_include
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) \
+    || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+// merge:end
+
+// merge:include
+#include <cstddef>
+#include <functional>
+#include <thread>
+// merge:end
+
+namespace platform {
+    // hint to cpu that caller is spinning, eases pipeline and sibling thread
+    inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) \
+    || defined(_M_IX86)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+
+    // Hash of calling thread id, cached and mixed so that low bits could
+    // pick a lane even if ids are aligned addresses.
+    inline size_t thread_hash() {
+        static thread_local size_t hash = [] {
+            constexpr size_t half = sizeof(size_t) * 4;
+
+            size_t given =
+                std::hash<std::thread::id>()(std::this_thread::get_id());
+            given *= static_cast<size_t>(0x9e3779b97f4a7c15ull);
+            return given ^ (given >> half);
+        }();
+        return hash;
+    }
+}  // namespace platform
+
+#endif
\ No newline at end of file
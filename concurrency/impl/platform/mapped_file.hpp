@@ -0,0 +1,93 @@
+#ifndef PLATFORM_MAPPED_FILE_HPP
+#define PLATFORM_MAPPED_FILE_HPP
+
+// merge:np_include
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+// merge:end
+
+// merge:include
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+// merge:end
+
+namespace platform {
+    // Read-write shared mapping of whole file, created and zero-filled
+    // up to given size if not exists.
+    class MappedFile {
+    public:
+        MappedFile(std::string const& path, size_t size)
+            : m_data(nullptr), m_size(size) {
+#if defined(__unix__) || defined(__APPLE__)
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), path);
+            }
+
+            struct stat st;
+            if (::fstat(fd, &st) < 0
+                || (static_cast<size_t>(st.st_size) < size
+                    && ::ftruncate(fd, size) < 0)) {
+                int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), path);
+            }
+
+            void* data = ::mmap(
+                nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            int err = errno;
+            ::close(fd);
+
+            if (data == MAP_FAILED) {
+                throw std::system_error(err, std::generic_category(), path);
+            }
+            m_data = data;
+#else
+            throw std::system_error(
+                std::make_error_code(std::errc::function_not_supported),
+                path);
+#endif
+        }
+
+        ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+            if (m_data != nullptr) {
+                ::msync(m_data, m_size, MS_SYNC);
+                ::munmap(m_data, m_size);
+            }
+#endif
+        }
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile(MappedFile&&) = delete;
+
+        MappedFile& operator=(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile&&) = delete;
+
+        void* data() const {
+            return m_data;
+        }
+
+        size_t size() const {
+            return m_size;
+        }
+
+        void sync(bool blocking = false) {
+#if defined(__unix__) || defined(__APPLE__)
+            ::msync(m_data, m_size, blocking ? MS_SYNC : MS_ASYNC);
+#endif
+        }
+
+    private:
+        void* m_data;
+        size_t m_size;
+    };
+}  // namespace platform
+
+#endif
\ No newline at end of file
@@ -0,0 +1,271 @@
+#ifndef PLATFORM_SHARED_MEMORY_HPP
+#define PLATFORM_SHARED_MEMORY_HPP
+
+// merge:np_include
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+// merge:end
+
+// merge:include
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+// merge:end
+
+namespace platform {
+#if defined(__unix__) || defined(__APPLE__)
+    // Named shared memory segment, first process creates and owns it.
+    // Owner unlinks the name on destruction, mapped processes keep using it.
+    class SharedMemory {
+    public:
+        SharedMemory(std::string const& name, size_t size)
+            : name(name), m_data(nullptr), m_size(size), m_owner(true) {
+            int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0 && errno == EEXIST) {
+                m_owner = false;
+                fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+            }
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), name);
+            }
+
+            int res = m_owner ? ::ftruncate(fd, size) : wait_size(fd, size);
+            if (res < 0) {
+                int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), name);
+            }
+
+            void* data = ::mmap(
+                nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            int err = errno;
+            ::close(fd);
+
+            if (data == MAP_FAILED) {
+                throw std::system_error(err, std::generic_category(), name);
+            }
+            m_data = data;
+        }
+
+        ~SharedMemory() {
+            ::munmap(m_data, m_size);
+            if (m_owner) {
+                ::shm_unlink(name.c_str());
+            }
+        }
+
+        SharedMemory(SharedMemory const&) = delete;
+        SharedMemory(SharedMemory&&) = delete;
+
+        SharedMemory& operator=(SharedMemory const&) = delete;
+        SharedMemory& operator=(SharedMemory&&) = delete;
+
+        void* data() const {
+            return m_data;
+        }
+
+        size_t size() const {
+            return m_size;
+        }
+
+        bool owner() const {
+            return m_owner;
+        }
+
+    private:
+        std::string name;
+        void* m_data;
+        size_t m_size;
+        bool m_owner;
+
+        // wait until owner truncates segment to given size
+        static int wait_size(int fd, size_t size) {
+            struct stat st;
+            do {
+                if (::fstat(fd, &st) < 0) {
+                    return -1;
+                }
+                std::this_thread::yield();
+            } while (static_cast<size_t>(st.st_size) < size);
+            return 0;
+        }
+    };
+
+    // Mutex placed in shared memory, constructed once by segment owner.
+    class ProcessMutex {
+    public:
+        ProcessMutex() {
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+
+            int res = pthread_mutex_init(&handle, &attr);
+            pthread_mutexattr_destroy(&attr);
+            if (res != 0) {
+                throw std::system_error(res, std::generic_category());
+            }
+        }
+
+        ~ProcessMutex() {
+            pthread_mutex_destroy(&handle);
+        }
+
+        ProcessMutex(ProcessMutex const&) = delete;
+        ProcessMutex(ProcessMutex&&) = delete;
+
+        ProcessMutex& operator=(ProcessMutex const&) = delete;
+        ProcessMutex& operator=(ProcessMutex&&) = delete;
+
+        void lock() {
+            pthread_mutex_lock(&handle);
+        }
+
+        bool try_lock() {
+            return pthread_mutex_trylock(&handle) == 0;
+        }
+
+        void unlock() {
+            pthread_mutex_unlock(&handle);
+        }
+
+        pthread_mutex_t* native_handle() {
+            return &handle;
+        }
+
+    private:
+        pthread_mutex_t handle;
+    };
+
+    // Condition variable placed in shared memory, pair of ProcessMutex.
+    class ProcessCondition {
+    public:
+        ProcessCondition() {
+            pthread_condattr_t attr;
+            pthread_condattr_init(&attr);
+            pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+
+            int res = pthread_cond_init(&handle, &attr);
+            pthread_condattr_destroy(&attr);
+            if (res != 0) {
+                throw std::system_error(res, std::generic_category());
+            }
+        }
+
+        ~ProcessCondition() {
+            pthread_cond_destroy(&handle);
+        }
+
+        ProcessCondition(ProcessCondition const&) = delete;
+        ProcessCondition(ProcessCondition&&) = delete;
+
+        ProcessCondition& operator=(ProcessCondition const&) = delete;
+        ProcessCondition& operator=(ProcessCondition&&) = delete;
+
+        template <typename Pred>
+        void wait(std::unique_lock<ProcessMutex>& lock, Pred pred) {
+            while (!pred()) {
+                pthread_cond_wait(&handle, lock.mutex()->native_handle());
+            }
+        }
+
+        // absolute timeout of pthread is measured by system clock
+        template <typename Clock, typename Duration, typename Pred>
+        bool wait_until(std::unique_lock<ProcessMutex>& lock,
+                        std::chrono::time_point<Clock, Duration> const& time,
+                        Pred pred) {
+            using namespace std::chrono;
+            auto left = duration_cast<system_clock::duration>(time
+                                                              - Clock::now());
+            auto real = system_clock::now() + left;
+            auto ns = duration_cast<nanoseconds>(real.time_since_epoch());
+
+            timespec spec;
+            spec.tv_sec = static_cast<time_t>(ns.count() / 1000000000);
+            spec.tv_nsec = static_cast<long>(ns.count() % 1000000000);
+
+            while (!pred()) {
+                int res = pthread_cond_timedwait(
+                    &handle, lock.mutex()->native_handle(), &spec);
+                if (res == ETIMEDOUT) {
+                    return pred();
+                }
+            }
+            return true;
+        }
+
+        void notify_all() {
+            pthread_cond_broadcast(&handle);
+        }
+
+    private:
+        pthread_cond_t handle;
+    };
+#else
+    class SharedMemory {
+    public:
+        SharedMemory(std::string const& name, size_t) {
+            throw std::system_error(
+                std::make_error_code(std::errc::function_not_supported),
+                name);
+        }
+
+        void* data() const {
+            return nullptr;
+        }
+
+        size_t size() const {
+            return 0;
+        }
+
+        bool owner() const {
+            return false;
+        }
+    };
+
+    class ProcessMutex {
+    public:
+        void lock() {
+            // Do Nothing
+        }
+
+        bool try_lock() {
+            return false;
+        }
+
+        void unlock() {
+            // Do Nothing
+        }
+    };
+
+    class ProcessCondition {
+    public:
+        template <typename Pred>
+        void wait(std::unique_lock<ProcessMutex>&, Pred) {
+            // Do Nothing
+        }
+
+        template <typename Time, typename Pred>
+        bool wait_until(std::unique_lock<ProcessMutex>&,
+                        Time const&,
+                        Pred pred) {
+            return pred();
+        }
+
+        void notify_all() {
+            // Do Nothing
+        }
+    };
+#endif
+}  // namespace platform
+
+#endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#ifndef POLICY_HPP
+#define POLICY_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+#include "platform/cpu.hpp"
+#include "trace.hpp"
+
+namespace Policy {
+    // capacity of channel without bound
+    constexpr size_t unbounded = 0;
+
+    // number of threads on producer or consumer side
+    struct Single {};
+    struct Multi {};
+
+    // Busy wait with yield, lowest latency but keeps the core busy.
+    class Spin {
+    public:
+        template <typename Pred>
+        void wait(Pred pred) {
+            if (pred()) {
+                return;
+            }
+
+            Trace::Span span("channel.block");
+            while (!pred()) {
+                std::this_thread::yield();
+            }
+        }
+
+        template <typename Clock, typename Duration, typename Pred>
+        bool wait_until(std::chrono::time_point<Clock, Duration> const& time,
+                        Pred pred) {
+            if (pred()) {
+                return true;
+            }
+
+            Trace::Span span("channel.block");
+            while (!pred()) {
+                if (Clock::now() >= time) {
+                    return pred();
+                }
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+        void notify() {
+            // Do Nothing
+        }
+    };
+
+    // Park on condition variable, notifier locks only if someone waits.
+    // Both sides fence between their store and load, so either waiter
+    // sees the new state or notifier sees the waiter.
+    class Park {
+    public:
+        Park() : num_waiting(0) {
+            // Do Nothing
+        }
+
+        Park(Park const&) = delete;
+        Park(Park&&) = delete;
+
+        Park& operator=(Park const&) = delete;
+        Park& operator=(Park&&) = delete;
+
+        template <typename Pred>
+        void wait(Pred pred) {
+            if (pred()) {
+                return;
+            }
+
+            Trace::Span span("channel.block");
+            ++num_waiting;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            {
+                std::unique_lock lock(mutex);
+                cond.wait(lock, pred);
+            }
+            --num_waiting;
+        }
+
+        template <typename Clock, typename Duration, typename Pred>
+        bool wait_until(std::chrono::time_point<Clock, Duration> const& time,
+                        Pred pred) {
+            if (pred()) {
+                return true;
+            }
+
+            Trace::Span span("channel.block");
+            ++num_waiting;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool res;
+            {
+                std::unique_lock lock(mutex);
+                res = cond.wait_until(lock, time, pred);
+            }
+            --num_waiting;
+            return res;
+        }
+
+        void notify() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (num_waiting.load() > 0) {
+                std::unique_lock lock(mutex);
+                cond.notify_all();
+            }
+        }
+
+    private:
+        std::atomic<size_t> num_waiting;
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+    // Spin shortly for the state changed in a few instructions, then park.
+    class Adaptive {
+    public:
+        template <typename Pred>
+        void wait(Pred pred) {
+            for (size_t spin = 0; spin < max_spin; ++spin) {
+                if (pred()) {
+                    return;
+                }
+                platform::cpu_relax();
+            }
+            park.wait(pred);
+        }
+
+        template <typename Clock, typename Duration, typename Pred>
+        bool wait_until(std::chrono::time_point<Clock, Duration> const& time,
+                        Pred pred) {
+            for (size_t spin = 0; spin < max_spin; ++spin) {
+                if (pred()) {
+                    return true;
+                }
+                platform::cpu_relax();
+            }
+            return park.wait_until(time, pred);
+        }
+
+        void notify() {
+            park.notify();
+        }
+
+    private:
+        static constexpr size_t max_spin = 128;
+
+        Park park;
+    };
+}  // namespace Policy
+
+#endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef POLICY_CHANNEL_HPP
+#define POLICY_CHANNEL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "channel.hpp"
+#include "policy.hpp"
+#include "container/bounded_queue.hpp"
+#include "lockfree/mpsc_queue.hpp"
+#include "lockfree/segment_queue.hpp"
+
+namespace Policy {
+    // bounded queue with capacity fixed at compile time
+    template <typename T,
+              size_t Capacity,
+              typename Producers,
+              typename Consumers,
+              typename Wait,
+              typename Alloc>
+    class FixedQueue
+        : public BoundedQueue<T, Producers, Consumers, Wait, Alloc> {
+    public:
+        FixedQueue(Alloc const& alloc = Alloc())
+            : BoundedQueue<T, Producers, Consumers, Wait, Alloc>(Capacity,
+                                                                 alloc) {
+            // Do Nothing
+        }
+    };
+
+    template <typename T>
+    struct Type {
+        using type = T;
+    };
+
+    // pick container which has only synchronization the topology needs
+    template <typename T,
+              size_t Capacity,
+              typename Producers,
+              typename Consumers,
+              typename Wait,
+              typename Alloc>
+    constexpr auto select_container() {
+        static_assert(std::is_same_v<Producers, Single>
+                          || std::is_same_v<Producers, Multi>,
+                      "Producers must be Policy::Single or Policy::Multi");
+        static_assert(std::is_same_v<Consumers, Single>
+                          || std::is_same_v<Consumers, Multi>,
+                      "Consumers must be Policy::Single or Policy::Multi");
+        static_assert(std::is_same_v<Wait, Spin>
+                          || std::is_same_v<Wait, Park>,
+                      "Wait must be Policy::Spin or Policy::Park");
+
+        if constexpr (Capacity == unbounded
+                      && std::is_same_v<Consumers, Single>) {
+            return Type<LockFree::MpscQueue<T, Wait, Alloc>>();
+        }
+        else if constexpr (Capacity == unbounded) {
+            return Type<LockFree::SegmentQueue<T, Wait, Alloc>>();
+        }
+        else {
+            return Type<
+                FixedQueue<T, Capacity, Producers, Consumers, Wait, Alloc>>();
+        }
+    }
+
+    template <typename T,
+              size_t Capacity,
+              typename Producers,
+              typename Consumers,
+              typename Wait,
+              typename Alloc>
+    using container_t = typename decltype(
+        select_container<T, Capacity, Producers, Consumers, Wait, Alloc>())::
+        type;
+}  // namespace Policy
+
+template <typename T,
+          size_t Capacity = Policy::unbounded,
+          typename Producers = Policy::Multi,
+          typename Consumers = Policy::Multi,
+          typename Wait = Policy::Park,
+          typename Alloc = std::allocator<T>>
+using PolicyChannel = Channel<
+    Policy::container_t<T, Capacity, Producers, Consumers, Wait, Alloc>>;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,230 @@
+#ifndef RATE_LIMITER_HPP
+#define RATE_LIMITER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "channel.hpp"
+#include "channel_iter.hpp"
+
+// Token bucket as generic cell rate algorithm, state is single atomic
+// of theoretical arrival time, so acquire is one compare exchange.
+// Waiter reserves its slot and sleeps until it, no timer thread.
+class RateLimiter {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // tokens per second, and how many could be taken at once after idle
+    RateLimiter(double rate, size_t burst = 1)
+        : start(clock::now()),
+          interval(static_cast<int64_t>(1e9 / std::max(rate, 1e-9))),
+          burst(std::max<size_t>(burst, 1)), tat(0) {
+        // Do Nothing
+    }
+
+    RateLimiter(RateLimiter const&) = delete;
+    RateLimiter(RateLimiter&&) = delete;
+
+    RateLimiter& operator=(RateLimiter const&) = delete;
+    RateLimiter& operator=(RateLimiter&&) = delete;
+
+    // more tokens than burst are taken on debt, later callers wait for it
+    void Acquire(size_t tokens = 1) {
+        int64_t at = 0;
+        reserve(tokens, [](int64_t) { return true; }, at);
+        sleep(at);
+    }
+
+    bool TryAcquire(size_t tokens = 1) {
+        int64_t at = 0;
+        return reserve(tokens, [&](int64_t now) { return at <= now; }, at);
+    }
+
+    // fail at once if tokens would not be ready in timeout
+    template <typename Rep, typename Period>
+    bool AcquireFor(size_t tokens,
+                    std::chrono::duration<Rep, Period> const& timeout) {
+        int64_t limit =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timeout)
+                .count();
+
+        int64_t at = 0;
+        if (!reserve(tokens,
+                     [&](int64_t now) { return at - now <= limit; },
+                     at)) {
+            return false;
+        }
+        sleep(at);
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool AcquireFor(std::chrono::duration<Rep, Period> const& timeout) {
+        return AcquireFor(1, timeout);
+    }
+
+    // give back tokens acquired but not used
+    void Release(size_t tokens = 1) {
+        int64_t cost = interval * static_cast<int64_t>(tokens);
+        int64_t given = tat.load();
+        while (!tat.compare_exchange_weak(given,
+                                          std::max<int64_t>(given - cost, 0))) {
+            // Do Nothing
+        }
+    }
+
+    double GetRate() const {
+        return 1e9 / interval;
+    }
+
+    size_t GetBurst() const {
+        return burst;
+    }
+
+private:
+    clock::time_point start;
+    int64_t interval;
+    size_t burst;
+
+    // nanoseconds from start when bucket is full again
+    std::atomic<int64_t> tat;
+
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   clock::now() - start)
+            .count();
+    }
+
+    // at is when reserved tokens are ready, accept decides on it
+    template <typename F>
+    bool reserve(size_t tokens, F&& accept, int64_t& at) {
+        int64_t cost = interval * static_cast<int64_t>(tokens);
+        int64_t tolerance = interval * static_cast<int64_t>(burst);
+
+        int64_t current = now();
+        int64_t given = tat.load();
+        while (true) {
+            int64_t next = std::max(given, current) + cost;
+            at = next - tolerance;
+            if (!accept(current)) {
+                return false;
+            }
+            if (tat.compare_exchange_weak(given, next)) {
+                return true;
+            }
+        }
+    }
+
+    void sleep(int64_t at) const {
+        int64_t wait = at - now();
+        if (wait > 0) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+        }
+    }
+};
+
+// Channel whose items are released at most at the rate of its limiter.
+// Token is taken before item and given back if there is none.
+template <typename Container>
+class ThrottledChannel {
+public:
+    using value_type = typename Container::value_type;
+    using iterator = ChannelIterator<value_type, ThrottledChannel<Container>>;
+
+    template <typename... U>
+    ThrottledChannel(double rate, size_t burst, U&&... args)
+        : limiter(rate, burst), channel(std::forward<U>(args)...) {
+        // Do Nothing
+    }
+
+    template <typename... U>
+    void Add(U&&... args) {
+        channel.Add(std::forward<U>(args)...);
+    }
+
+    template <typename... U>
+    bool TryAdd(U&&... args) {
+        return channel.TryAdd(std::forward<U>(args)...);
+    }
+
+    template <typename U>
+    ThrottledChannel& operator<<(U&& value) {
+        Add(std::forward<U>(value));
+        return *this;
+    }
+
+    std::optional<value_type> Get() {
+        limiter.Acquire();
+        return give_back(channel.Get());
+    }
+
+    std::optional<value_type> TryGet() {
+        if (!limiter.TryAcquire()) {
+            return std::nullopt;
+        }
+        return give_back(channel.TryGet());
+    }
+
+    template <typename Rep, typename Period>
+    std::optional<value_type> GetFor(
+        std::chrono::duration<Rep, Period> const& timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        if (!limiter.AcquireFor(timeout)) {
+            return std::nullopt;
+        }
+        return give_back(channel.GetUntil(deadline));
+    }
+
+    ThrottledChannel& operator>>(std::optional<value_type>& get) {
+        get = Get();
+        return *this;
+    }
+
+    void Close() {
+        channel.Close();
+    }
+
+    bool Runnable() const {
+        return channel.Runnable();
+    }
+
+    bool Readable() {
+        return channel.Readable();
+    }
+
+    RateLimiter& GetLimiter() {
+        return limiter;
+    }
+
+    iterator begin() {
+        return iterator(*this, Get());
+    }
+
+    iterator end() {
+        return iterator(*this, std::nullopt);
+    }
+
+private:
+    RateLimiter limiter;
+    Channel<Container> channel;
+
+    std::optional<value_type> give_back(std::optional<value_type>&& given) {
+        if (!given.has_value()) {
+            limiter.Release();
+        }
+        return std::move(given);
+    }
+};
+
+template <typename T>
+using ThrottledRChannel = ThrottledChannel<TSRingBuffer<T>>;
+
+template <typename T>
+using ThrottledLChannel = ThrottledChannel<TSList<T>>;
+
+#endif
\ No newline at end of file
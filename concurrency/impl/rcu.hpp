@@ -0,0 +1,226 @@
+#ifndef RCU_HPP
+#define RCU_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "platform/constant.hpp"
+#include "platform/cpu.hpp"
+
+// Read copy update domain. Readers only count themselves in a lane of
+// the current epoch parity, so read side is wait free and scales.
+// Writers unlink old versions and retire them, retired ones are freed
+// in batches after every reader present at retirement has left.
+class RcuDomain {
+public:
+    RcuDomain()
+        : RcuDomain(std::max(1u, std::thread::hardware_concurrency())) {
+        // Do Nothing
+    }
+
+    // lanes are rounded up to power of two
+    RcuDomain(size_t num_lanes)
+        : num_lanes(ceil_pow2(num_lanes)),
+          lanes(std::make_unique<Lane[]>(this->num_lanes)), epoch(0) {
+        // Do Nothing
+    }
+
+    // no reader should be left
+    ~RcuDomain() {
+        for (size_t lane = 0; lane < num_lanes; ++lane) {
+            for (Retired& retired : lanes[lane].pending) {
+                retired.deleter(retired.ptr);
+            }
+        }
+    }
+
+    RcuDomain(RcuDomain const&) = delete;
+    RcuDomain(RcuDomain&&) = delete;
+
+    RcuDomain& operator=(RcuDomain const&) = delete;
+    RcuDomain& operator=(RcuDomain&&) = delete;
+
+    // Token for ReadUnlock, read sections may nest.
+    // Fence pairs with Synchronize, so either writer sees this reader
+    // or reader sees what writer has unlinked before.
+    size_t ReadLock() {
+        size_t lane = platform::thread_hash() & (num_lanes - 1);
+        size_t parity = epoch.load(std::memory_order_relaxed) & 1;
+        lanes[lane].readers[parity].fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return lane * 2 + parity;
+    }
+
+    void ReadUnlock(size_t token) {
+        lanes[token / 2].readers[token % 2].fetch_sub(
+            1, std::memory_order_release);
+    }
+
+    // Wait for readers present at the call, not from read section.
+    // Epoch flips twice, so reader which took the parity just before
+    // a flip is waited too.
+    void Synchronize() {
+        std::unique_lock lock(sync_mutex);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (size_t flip = 0; flip < 2; ++flip) {
+            size_t parity = epoch.fetch_add(1) & 1;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (size_t lane = 0; lane < num_lanes; ++lane) {
+                std::atomic<size_t>& readers = lanes[lane].readers[parity];
+                while (readers.load(std::memory_order_acquire) > 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    // Free after grace period, batched per lane to amortize Synchronize,
+    // so it should not be called from read section either.
+    template <typename T>
+    void Retire(T* ptr) {
+        Retire(ptr, [](void* given) { delete static_cast<T*>(given); });
+    }
+
+    void Retire(void* ptr, void (*deleter)(void*)) {
+        Lane& lane = lanes[platform::thread_hash() & (num_lanes - 1)];
+
+        std::vector<Retired> batch;
+        {
+            std::unique_lock lock(lane.retire_mutex);
+            lane.pending.push_back(Retired{ ptr, deleter });
+            if (lane.pending.size() < batch_size) {
+                return;
+            }
+            batch.swap(lane.pending);
+        }
+
+        Synchronize();
+        for (Retired& retired : batch) {
+            retired.deleter(retired.ptr);
+        }
+    }
+
+private:
+    static constexpr size_t batch_size = 128;
+
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+    };
+
+    struct alignas(platform::cache_line) Lane {
+        std::atomic<size_t> readers[2] = { 0, 0 };
+
+        alignas(platform::cache_line) std::mutex retire_mutex;
+        std::vector<Retired> pending;
+    };
+
+    size_t num_lanes;
+    std::unique_ptr<Lane[]> lanes;
+
+    alignas(platform::cache_line) std::atomic<size_t> epoch;
+    std::mutex sync_mutex;
+
+    static size_t ceil_pow2(size_t value) {
+        size_t pow = 1;
+        while (pow < value) {
+            pow <<= 1;
+        }
+        return pow;
+    }
+};
+
+// RAII read section of domain.
+class RcuReadGuard {
+public:
+    RcuReadGuard(RcuDomain& domain)
+        : domain(domain), token(domain.ReadLock()) {
+        // Do Nothing
+    }
+
+    ~RcuReadGuard() {
+        domain.ReadUnlock(token);
+    }
+
+    RcuReadGuard(RcuReadGuard const&) = delete;
+    RcuReadGuard(RcuReadGuard&&) = delete;
+
+    RcuReadGuard& operator=(RcuReadGuard const&) = delete;
+    RcuReadGuard& operator=(RcuReadGuard&&) = delete;
+
+private:
+    RcuDomain& domain;
+    size_t token;
+};
+
+// Cell of read mostly value. Readers get snapshot of current version
+// with no lock or retry, writers publish new version and retire old one
+// to the domain, which frees it once no reader may hold it.
+template <typename T>
+class RcuCell {
+public:
+    template <typename... U>
+    RcuCell(U&&... args) : current(new T(std::forward<U>(args)...)) {
+        // Do Nothing
+    }
+
+    ~RcuCell() {
+        delete current.load();
+    }
+
+    RcuCell(RcuCell const&) = delete;
+    RcuCell(RcuCell&&) = delete;
+
+    RcuCell& operator=(RcuCell const&) = delete;
+    RcuCell& operator=(RcuCell&&) = delete;
+
+    // func gets snapshot, which stays alive until it returns
+    template <typename F>
+    decltype(auto) read(F&& func) {
+        RcuReadGuard guard(domain);
+        return func(std::as_const(*current.load(std::memory_order_acquire)));
+    }
+
+    T load() {
+        return read([](T const& value) { return value; });
+    }
+
+    template <typename... U>
+    void store(U&&... args) {
+        T* old = nullptr;
+        {
+            auto fresh = std::make_unique<T>(std::forward<U>(args)...);
+            std::unique_lock lock(writer);
+            old = current.exchange(fresh.release(), std::memory_order_acq_rel);
+        }
+        domain.Retire(old);
+    }
+
+    // Copy, modify and publish. Writers are serialized, so concurrent
+    // updates are not lost, readers are not blocked.
+    template <typename F>
+    void update(F&& func) {
+        T* old = nullptr;
+        {
+            std::unique_lock lock(writer);
+            auto fresh =
+                std::make_unique<T>(*current.load(std::memory_order_relaxed));
+            func(*fresh);
+            old = current.exchange(fresh.release(), std::memory_order_acq_rel);
+        }
+        domain.Retire(old);
+    }
+
+private:
+    std::atomic<T*> current;
+    std::mutex writer;
+    RcuDomain domain;
+};
+
+#endif
\ No newline at end of file
@@ -1,6 +1,14 @@
 #ifndef SELECT_HPP
 #define SELECT_HPP
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
 #include "channel.hpp"
 
 template <typename T, typename F>
@@ -26,7 +34,7 @@ struct DefaultSelectable {
 
     static DefaultSelectable channel;
 };
-DefaultSelectable DefaultSelectable::channel;
+inline DefaultSelectable DefaultSelectable::channel;
 
 template <typename T>
 struct case_m {
@@ -77,4 +85,139 @@ void select(T&&... matches) {
     (try_action(matches), ...);
 }
 
+// Select over channels registered at runtime.
+// Channels notify on add and close, ready ones are queued without scan.
+// Readiness is edge triggered, caller drains returned channel with TryGet
+// until it is empty. Unregister channel before it is destroyed.
+class Selector : public ChannelWatcher {
+public:
+    Selector() : num_active(0) {
+        // Do Nothing
+    }
+
+    ~Selector() {
+        for (size_t id = 0; id < entries.size(); ++id) {
+            Unregister(id);
+        }
+    }
+
+    Selector(Selector const&) = delete;
+    Selector(Selector&&) = delete;
+
+    Selector& operator=(Selector const&) = delete;
+    Selector& operator=(Selector&&) = delete;
+
+    // id of the channel, reused after unregister
+    template <typename C>
+    size_t Register(C& channel) {
+        size_t id;
+        {
+            std::unique_lock lock(mutex);
+            if (free_ids.empty()) {
+                id = entries.size();
+                entries.emplace_back();
+            }
+            else {
+                id = free_ids.back();
+                free_ids.pop_back();
+            }
+
+            ++num_active;
+            entries[id].active = true;
+            entries[id].unwatch = [&channel] { channel.Unwatch(); };
+        }
+
+        // items added before watch are drained with the first readiness
+        channel.Watch(this, id);
+        Notify(id);
+        return id;
+    }
+
+    void Unregister(size_t id) {
+        std::function<void()> unwatch;
+        {
+            std::unique_lock lock(mutex);
+            if (id >= entries.size() || !entries[id].active) {
+                return;
+            }
+            entries[id].active = false;
+            unwatch = std::move(entries[id].unwatch);
+        }
+
+        // notifier in flight may wait for the lock
+        unwatch();
+
+        std::unique_lock lock(mutex);
+        free_ids.push_back(id);
+        --num_active;
+    }
+
+    size_t Wait() {
+        std::unique_lock lock(mutex);
+        std::optional<size_t> id;
+        cond.wait(lock, [&] { return (id = take()).has_value(); });
+        return id.value();
+    }
+
+    template <typename Rep, typename Period>
+    std::optional<size_t> WaitFor(
+        std::chrono::duration<Rep, Period> const& timeout) {
+        std::unique_lock lock(mutex);
+        std::optional<size_t> id;
+        cond.wait_for(lock, timeout, [&] {
+            return (id = take()).has_value();
+        });
+        return id;
+    }
+
+    std::optional<size_t> TryWait() {
+        std::unique_lock lock(mutex);
+        return take();
+    }
+
+    size_t Size() {
+        std::unique_lock lock(mutex);
+        return num_active;
+    }
+
+    void Notify(size_t id) override {
+        std::unique_lock lock(mutex);
+        Entry& entry = entries[id];
+        if (entry.active && !entry.queued) {
+            entry.queued = true;
+            ready.push_back(id);
+            cond.notify_one();
+        }
+    }
+
+private:
+    struct Entry {
+        bool active = false;
+        bool queued = false;
+        std::function<void()> unwatch;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    std::vector<Entry> entries;
+    std::vector<size_t> free_ids;
+    std::deque<size_t> ready;
+    size_t num_active;
+
+    // front of ready queue, skip unregistered ones
+    std::optional<size_t> take() {
+        while (!ready.empty()) {
+            size_t id = ready.front();
+            ready.pop_front();
+
+            entries[id].queued = false;
+            if (entries[id].active) {
+                return id;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
 #endif
\ No newline at end of file
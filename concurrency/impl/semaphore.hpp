@@ -0,0 +1,105 @@
+#ifndef SEMAPHORE_HPP
+#define SEMAPHORE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include "policy.hpp"
+#include "trace.hpp"
+
+// Counting semaphore whose acquirers may take several permits at once.
+// Permits are taken with compare exchange, waiters park only when
+// there are not enough of them. Small requests may overtake large ones.
+class Semaphore {
+public:
+    Semaphore(size_t permits) : permits(permits) {
+        // Do Nothing
+    }
+
+    Semaphore(Semaphore const&) = delete;
+    Semaphore(Semaphore&&) = delete;
+
+    Semaphore& operator=(Semaphore const&) = delete;
+    Semaphore& operator=(Semaphore&&) = delete;
+
+    void Acquire(size_t n = 1) {
+        if (TryAcquire(n)) {
+            return;
+        }
+
+        Trace::Span span("Semaphore::Acquire");
+        waiter.wait([&] { return TryAcquire(n); });
+    }
+
+    bool TryAcquire(size_t n = 1) {
+        size_t given = permits.load(std::memory_order_relaxed);
+        while (given >= n) {
+            if (permits.compare_exchange_weak(
+                    given, given - n, std::memory_order_acquire)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename Clock, typename Duration>
+    bool AcquireUntil(size_t n,
+                      std::chrono::time_point<Clock, Duration> const& time) {
+        if (TryAcquire(n)) {
+            return true;
+        }
+
+        Trace::Span span("Semaphore::Acquire");
+        return waiter.wait_until(time, [&] { return TryAcquire(n); });
+    }
+
+    template <typename Rep, typename Period>
+    bool AcquireFor(size_t n,
+                    std::chrono::duration<Rep, Period> const& timeout) {
+        return AcquireUntil(n, std::chrono::steady_clock::now() + timeout);
+    }
+
+    template <typename Rep, typename Period>
+    bool AcquireFor(std::chrono::duration<Rep, Period> const& timeout) {
+        return AcquireFor(1, timeout);
+    }
+
+    void Release(size_t n = 1) {
+        permits.fetch_add(n, std::memory_order_release);
+        waiter.notify();
+    }
+
+    size_t Available() const {
+        return permits.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<size_t> permits;
+    Policy::Adaptive waiter;
+};
+
+// RAII guard of permits, released on destruction.
+class SemaphoreGuard {
+public:
+    SemaphoreGuard(Semaphore& semaphore, size_t n = 1)
+        : semaphore(semaphore), n(n) {
+        semaphore.Acquire(n);
+    }
+
+    ~SemaphoreGuard() {
+        semaphore.Release(n);
+    }
+
+    SemaphoreGuard(SemaphoreGuard const&) = delete;
+    SemaphoreGuard(SemaphoreGuard&&) = delete;
+
+    SemaphoreGuard& operator=(SemaphoreGuard const&) = delete;
+    SemaphoreGuard& operator=(SemaphoreGuard&&) = delete;
+
+private:
+    Semaphore& semaphore;
+    size_t n;
+};
+
+#endif
\ No newline at end of file
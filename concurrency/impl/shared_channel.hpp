@@ -0,0 +1,10 @@
+#ifndef SHARED_CHANNEL_HPP
+#define SHARED_CHANNEL_HPP
+
+#include "channel.hpp"
+#include "container/shared_ring_buffer.hpp"
+
+template <typename T>
+using SharedChannel = Channel<SharedRingBuffer<T>>;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef SYNCHRONIZED_HPP
+#define SYNCHRONIZED_HPP
+
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+#include "mutex.hpp"
+
+// Value guarded by reader writer lock, reachable only in the scope of
+// with_read and with_write, so it could not be touched without lock.
+// Mutex should meet SharedMutex, std::shared_mutex works as well.
+template <typename T, typename Mutex = ShardedSharedMutex>
+class Synchronized {
+public:
+    template <typename... U>
+    Synchronized(U&&... args) : value(std::forward<U>(args)...) {
+        // Do Nothing
+    }
+
+    Synchronized(Synchronized const&) = delete;
+    Synchronized(Synchronized&&) = delete;
+
+    Synchronized& operator=(Synchronized const&) = delete;
+    Synchronized& operator=(Synchronized&&) = delete;
+
+    // readers run concurrently, func gets const reference
+    template <typename F>
+    decltype(auto) with_read(F&& func) const {
+        std::shared_lock lock(mutex);
+        return func(std::as_const(value));
+    }
+
+    template <typename F>
+    decltype(auto) with_write(F&& func) {
+        std::unique_lock lock(mutex);
+        return func(value);
+    }
+
+    T copy() const {
+        return with_read([](T const& given) { return given; });
+    }
+
+    template <typename U>
+    void assign(U&& given) {
+        with_write([&](T& value) { value = std::forward<U>(given); });
+    }
+
+private:
+    mutable Mutex mutex;
+    T value;
+};
+
+#endif
\ No newline at end of file
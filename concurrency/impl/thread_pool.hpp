@@ -1,9 +1,70 @@
 #ifndef THREAD_POOL_HPP
 #define THREAD_POOL_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "barrier.hpp"
 #include "channel.hpp"
+#include "trace.hpp"
+
+template <typename Pool>
+class BlockingRegion;
+
+// Futures of tasks submitted at once, with completion of whole batch,
+// so fan out waits on single latch instead of each future.
+template <typename T>
+class TaskBatch {
+public:
+    TaskBatch(std::vector<std::future<T>>&& futures,
+              std::shared_ptr<Latch> done)
+        : futures(std::move(futures)), done(std::move(done)) {
+        // Do Nothing
+    }
+
+    TaskBatch(TaskBatch const&) = delete;
+    TaskBatch(TaskBatch&&) = default;
+
+    TaskBatch& operator=(TaskBatch const&) = delete;
+    TaskBatch& operator=(TaskBatch&&) = default;
+
+    // in order of submission, exception of task is thrown from its future
+    std::vector<std::future<T>>& Futures() {
+        return futures;
+    }
+
+    // true once every task has run
+    bool Ready() const {
+        return done->TryWait();
+    }
+
+    // wait every task, results are ready after it
+    void Wait() {
+        done->Wait();
+        for (auto& fut : futures) {
+            fut.wait();
+        }
+    }
+
+    size_t Size() const {
+        return futures.size();
+    }
+
+private:
+    std::vector<std::future<T>> futures;
+    std::shared_ptr<Latch> done;
+};
 
 template <typename T,
           template <typename> class ChannelType = RChannel>
@@ -17,17 +78,10 @@ public:
     ThreadPool(size_t num_threads, Args&&... args)
         : runnable(true), num_threads(num_threads),
           channel(std::forward<Args>(args)...),
-          threads(std::make_unique<std::thread[]>(num_threads)) {
+          threads(std::make_unique<std::thread[]>(num_threads)),
+          num_blocking(0), num_extra(0), num_alive(0) {
         for (size_t i = 0; i < num_threads; ++i) {
-            threads[i] = std::thread([this] {
-                while (runnable) {
-                    auto given = channel.Get();
-                    if (!given.has_value()) {
-                        break;
-                    }
-                    given.value()();
-                }
-            });
+            threads[i] = std::thread([this] { work(); });
         }
     }
 
@@ -43,19 +97,107 @@ public:
 
     template <typename F>
     std::future<T> Add(F&& task) {
-        std::packaged_task<T()> ptask(std::forward<F>(task));
+        std::packaged_task<T()> ptask(Trace::task(std::forward<F>(task)));
         std::future<T> fut = ptask.get_future();
         channel.Add(std::move(ptask));
         return fut;
     }
 
+    // Add tasks of forward range with one lock of queue, only as many
+    // idle workers as tasks are waked. Tasks are copied from range,
+    // pass move iterators to move them.
+    template <typename It>
+    TaskBatch<T> AddBulk(It first, It last) {
+        auto done = std::make_shared<Latch>(std::distance(first, last));
+
+        std::vector<std::packaged_task<T()>> tasks;
+        tasks.reserve(std::distance(first, last));
+        for (; first != last; ++first) {
+            tasks.emplace_back(Trace::task(arrive(done, *first)));
+        }
+        return submit(tasks, std::move(done));
+    }
+
+    // Add func(i) for i in [0, n) as AddBulk, func is shared by tasks.
+    template <typename F>
+    TaskBatch<T> AddN(size_t n, F&& func) {
+        auto shared = std::make_shared<std::decay_t<F>>(std::forward<F>(func));
+        auto done = std::make_shared<Latch>(n);
+
+        std::vector<std::packaged_task<T()>> tasks;
+        tasks.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            tasks.emplace_back(Trace::task(
+                arrive(done, [shared, i] { return (*shared)(i); })));
+        }
+        return submit(tasks, std::move(done));
+    }
+
+    // Run func which blocks on I/O or another channel. If caller is worker,
+    // compensating worker is spawned to keep pool busy until it returns.
+    template <typename F>
+    decltype(auto) Blocking(F&& func) {
+        BlockingRegion region(*this);
+        return std::forward<F>(func)();
+    }
+
+    // Run queued tasks in the caller until fut is ready, so worker
+    // waiting on its subtask does not hold a thread away from it.
+    template <typename U>
+    U Await(std::future<U> fut) {
+        while (fut.wait_for(std::chrono::seconds(0))
+               != std::future_status::ready) {
+            auto given = channel.TryGet();
+            if (given.has_value()) {
+                given.value()();
+            }
+            else {
+                fut.wait_for(help_interval);
+            }
+        }
+        return fut.get();
+    }
+
+    // only for workers, other threads are not counted in pool
+    void EnterBlocking() {
+        if (current != this) {
+            return;
+        }
+
+        std::unique_lock lock(mutex);
+        ++num_blocking;
+        if (!runnable || num_extra >= num_blocking
+            || num_alive >= max_extra) {
+            return;
+        }
+
+        // compensation is best effort, blocking call runs anyway
+        try {
+            std::thread(&ThreadPool::work_extra, this).detach();
+            ++num_extra;
+            ++num_alive;
+        }
+        catch (std::system_error const&) {
+            // Do Nothing
+        }
+    }
+
+    void LeaveBlocking() {
+        if (current == this) {
+            std::unique_lock lock(mutex);
+            --num_blocking;
+        }
+    }
+
     size_t GetNumThreads() const {
         return num_threads;
     }
 
     void Stop() {
         if (threads != nullptr) {
+            std::unique_lock lock(mutex);
             runnable = false;
+            lock.unlock();
             channel.Close();
 
             for (size_t i = 0; i < num_threads; ++i) {
@@ -64,18 +206,213 @@ public:
                 }
             }
             threads.reset();
+
+            lock.lock();
+            cond.wait(lock, [&] { return num_alive == 0; });
         }
     }
 
 private:
-    bool runnable;
+    // upper bound of compensating workers alive at once
+    static constexpr size_t max_extra = 256;
+    // how long idle compensating worker waits before it checks to retire
+    static constexpr std::chrono::milliseconds idle_interval{ 10 };
+    // how long Await sleeps on future before it looks at queue again
+    static constexpr std::chrono::microseconds help_interval{ 100 };
+
+    // pool which runs on this thread, nullptr for non worker
+    static inline thread_local ThreadPool* current = nullptr;
+
+    std::atomic<bool> runnable;
     size_t num_threads;
 
     ChannelType<std::packaged_task<T()>> channel;
     std::unique_ptr<std::thread[]> threads;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t num_blocking;
+    // compensating workers not yet retired, and all alive ones
+    size_t num_extra;
+    size_t num_alive;
+
+    void work() {
+        current = this;
+        while (runnable) {
+            auto given = channel.Get();
+            if (!given.has_value()) {
+                break;
+            }
+            given.value()();
+        }
+    }
+
+    // retire as soon as there are more compensating workers than blocked
+    void work_extra() {
+        current = this;
+        while (runnable && !retire()) {
+            auto given = channel.GetFor(idle_interval);
+            if (given.has_value()) {
+                given.value()();
+            }
+            else if (!channel.Readable()) {
+                break;
+            }
+        }
+
+        // notified after thread locals are destroyed, so Stop could
+        // release pool right after it
+        std::unique_lock lock(mutex);
+        --num_alive;
+        std::notify_all_at_thread_exit(cond, std::move(lock));
+    }
+
+    bool retire() {
+        std::unique_lock lock(mutex);
+        if (num_extra > num_blocking) {
+            --num_extra;
+            return true;
+        }
+        return false;
+    }
+
+    struct Arrival {
+        Latch& latch;
+
+        ~Arrival() {
+            latch.CountDown();
+        }
+    };
+
+    // count down latch of batch after task, even if it throws
+    template <typename F>
+    static auto arrive(std::shared_ptr<Latch> const& done, F&& func) {
+        return [done, func = std::forward<F>(func)]() mutable -> T {
+            Arrival arrival{ *done };
+            return func();
+        };
+    }
+
+    TaskBatch<T> submit(std::vector<std::packaged_task<T()>>& tasks,
+                        std::shared_ptr<Latch> done) {
+        std::vector<std::future<T>> futures;
+        futures.reserve(tasks.size());
+        for (auto& task : tasks) {
+            futures.push_back(task.get_future());
+        }
+
+        // tasks dropped by closed pool never run, their futures are broken
+        size_t added = channel.AddBulk(std::make_move_iterator(tasks.begin()),
+                                       std::make_move_iterator(tasks.end()));
+        if (added < tasks.size()) {
+            done->CountDown(tasks.size() - added);
+        }
+        return TaskBatch<T>(std::move(futures), std::move(done));
+    }
+};
+
+// Mark the scope where worker of the pool blocks, see ThreadPool::Blocking.
+template <typename Pool>
+class BlockingRegion {
+public:
+    BlockingRegion(Pool& pool) : pool(pool) {
+        pool.EnterBlocking();
+    }
+
+    ~BlockingRegion() {
+        pool.LeaveBlocking();
+    }
+
+    BlockingRegion(BlockingRegion const&) = delete;
+    BlockingRegion(BlockingRegion&&) = delete;
+
+    BlockingRegion& operator=(BlockingRegion const&) = delete;
+    BlockingRegion& operator=(BlockingRegion&&) = delete;
+
+private:
+    Pool& pool;
 };
 
 template <typename T>
 using LThreadPool = ThreadPool<T, LChannel>;
 
+// Pool whose workers own their inbox, tasks are spread round robin or
+// pinned to a worker with AddTo. Inbox has single consumer,
+// so it is MPSC queue which pops without compare exchange.
+template <typename T>
+class InboxThreadPool {
+public:
+    using inbox_type = MpscChannel<std::packaged_task<T()>>;
+
+    InboxThreadPool()
+        : InboxThreadPool(std::max(1u, std::thread::hardware_concurrency())) {
+        // Do Nothing
+    }
+
+    InboxThreadPool(size_t num_threads)
+        : num_threads(std::max<size_t>(num_threads, 1)), next(0),
+          inboxes(std::make_unique<inbox_type[]>(this->num_threads)),
+          threads(std::make_unique<std::thread[]>(this->num_threads)) {
+        for (size_t i = 0; i < this->num_threads; ++i) {
+            threads[i] = std::thread([this, i] {
+                for (auto& task : inboxes[i]) {
+                    task();
+                }
+            });
+        }
+    }
+
+    ~InboxThreadPool() {
+        Stop();
+    }
+
+    InboxThreadPool(const InboxThreadPool&) = delete;
+    InboxThreadPool(InboxThreadPool&&) = delete;
+
+    InboxThreadPool& operator=(const InboxThreadPool&) = delete;
+    InboxThreadPool& operator=(InboxThreadPool&&) = delete;
+
+    template <typename F>
+    std::future<T> Add(F&& task) {
+        size_t worker = next.fetch_add(1, std::memory_order_relaxed);
+        return AddTo(worker % num_threads, std::forward<F>(task));
+    }
+
+    // tasks pinned to the same worker run in order of submission
+    template <typename F>
+    std::future<T> AddTo(size_t worker, F&& task) {
+        std::packaged_task<T()> ptask(Trace::task(std::forward<F>(task)));
+        std::future<T> fut = ptask.get_future();
+        inboxes[worker % num_threads].Add(std::move(ptask));
+        return fut;
+    }
+
+    size_t GetNumThreads() const {
+        return num_threads;
+    }
+
+    // pending tasks are still run before workers exit
+    void Stop() {
+        if (threads != nullptr) {
+            for (size_t i = 0; i < num_threads; ++i) {
+                inboxes[i].Close();
+            }
+
+            for (size_t i = 0; i < num_threads; ++i) {
+                if (threads[i].joinable()) {
+                    threads[i].join();
+                }
+            }
+            threads.reset();
+        }
+    }
+
+private:
+    size_t num_threads;
+    std::atomic<size_t> next;
+
+    std::unique_ptr<inbox_type[]> inboxes;
+    std::unique_ptr<std::thread[]> threads;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,331 @@
+#ifndef TIMER_HPP
+#define TIMER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+class TimerService;
+
+// Channel like handle of a timer, usable in select.
+// Holds at most one pending expiration, later ticks are dropped until read.
+class Timer {
+public:
+    using clock = std::chrono::steady_clock;
+
+    Timer(TimerService* service, clock::duration period)
+        : service(service), period(period), expire(0), bucket(nullptr),
+          m_runnable(true) {
+        // Do Nothing
+    }
+
+    Timer(Timer const&) = delete;
+    Timer(Timer&&) = delete;
+
+    Timer& operator=(Timer const&) = delete;
+    Timer& operator=(Timer&&) = delete;
+
+    std::optional<clock::time_point> Get() {
+        std::unique_lock lock(mutex);
+        cond.wait(lock, [&] { return !m_runnable || value.has_value(); });
+        return take();
+    }
+
+    std::optional<clock::time_point> TryGet() {
+        std::unique_lock lock(mutex);
+        return take();
+    }
+
+    bool Runnable() const {
+        return m_runnable;
+    }
+
+    bool Readable() {
+        std::unique_lock lock(mutex);
+        return m_runnable || value.has_value();
+    }
+
+    // cancel timer, return true if it was still scheduled
+    bool Stop();
+
+private:
+    friend class TimerService;
+    using bucket_type = std::list<std::shared_ptr<Timer>>;
+
+    std::atomic<TimerService*> service;
+    clock::duration period;
+
+    uint64_t expire;
+    bucket_type* bucket;
+    bucket_type::iterator pos;
+
+    std::atomic<bool> m_runnable;
+    std::optional<clock::time_point> value;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    std::optional<clock::time_point> take() {
+        std::optional<clock::time_point> given = value;
+        value.reset();
+        return given;
+    }
+
+    void fire(clock::time_point now, bool last) {
+        std::unique_lock lock(mutex);
+        value = now;
+        if (last) {
+            m_runnable = false;
+        }
+        cond.notify_all();
+    }
+
+    void close() {
+        std::unique_lock lock(mutex);
+        m_runnable = false;
+        cond.notify_all();
+    }
+};
+
+// Hierarchical timing wheel driven by single thread.
+// Insert and cancel are O(1), wheel sleeps while there is no timer.
+class TimerService {
+public:
+    using clock = Timer::clock;
+
+    TimerService() : TimerService(std::chrono::milliseconds(1)) {
+        // Do Nothing
+    }
+
+    TimerService(clock::duration resolution)
+        : resolution(resolution), runnable(true), num_timers(0), current(0),
+          start(clock::now()) {
+        worker = std::thread([this] { run(); });
+    }
+
+    ~TimerService() {
+        Stop();
+    }
+
+    TimerService(TimerService const&) = delete;
+    TimerService(TimerService&&) = delete;
+
+    TimerService& operator=(TimerService const&) = delete;
+    TimerService& operator=(TimerService&&) = delete;
+
+    std::shared_ptr<Timer> After(clock::duration dur) {
+        return schedule(clock::now() + dur, clock::duration::zero());
+    }
+
+    std::shared_ptr<Timer> Deadline(clock::time_point time) {
+        return schedule(time, clock::duration::zero());
+    }
+
+    std::shared_ptr<Timer> Tick(clock::duration dur) {
+        dur = std::max(dur, resolution);
+        return schedule(clock::now() + dur, dur);
+    }
+
+    size_t Size() {
+        std::unique_lock lock(mutex);
+        return num_timers;
+    }
+
+    void Stop() {
+        {
+            std::unique_lock lock(mutex);
+            if (!runnable) {
+                return;
+            }
+            runnable = false;
+
+            for (auto& level : wheel) {
+                for (auto& bucket : level) {
+                    for (auto& timer : bucket) {
+                        timer->service = nullptr;
+                        timer->bucket = nullptr;
+                        timer->close();
+                    }
+                    bucket.clear();
+                }
+            }
+            num_timers = 0;
+            cond.notify_all();
+        }
+
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+private:
+    friend class Timer;
+    using bucket_type = Timer::bucket_type;
+
+    static constexpr size_t num_bits = 6;
+    static constexpr size_t num_slots = 1 << num_bits;
+    static constexpr size_t num_levels = 4;
+    static constexpr uint64_t max_delta = 1ull << (num_bits * num_levels);
+
+    clock::duration resolution;
+    bool runnable;
+    size_t num_timers;
+
+    uint64_t current;
+    clock::time_point start;
+    bucket_type wheel[num_levels][num_slots];
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread worker;
+
+    uint64_t floor_tick(clock::time_point time) const {
+        if (time <= start) {
+            return 0;
+        }
+        return (time - start) / resolution;
+    }
+
+    uint64_t ceil_tick(clock::time_point time) const {
+        if (time <= start) {
+            return 0;
+        }
+        return (time - start + resolution - clock::duration(1)) / resolution;
+    }
+
+    std::shared_ptr<Timer> schedule(clock::time_point time,
+                                    clock::duration period) {
+        auto timer = std::make_shared<Timer>(this, period);
+
+        std::unique_lock lock(mutex);
+        if (!runnable) {
+            timer->service = nullptr;
+            timer->close();
+            return timer;
+        }
+
+        if (num_timers == 0) {
+            // wheel is empty, catch up idle time
+            current = std::max(current, floor_tick(clock::now()));
+        }
+        timer->expire = std::max(ceil_tick(time), current + 1);
+
+        bucket_type single;
+        single.push_back(timer);
+        insert(single, single.begin());
+
+        if (num_timers++ == 0) {
+            cond.notify_all();
+        }
+        return timer;
+    }
+
+    bool cancel(Timer& timer) {
+        std::unique_lock lock(mutex);
+        if (timer.bucket == nullptr) {
+            return false;
+        }
+
+        timer.bucket->erase(timer.pos);
+        timer.bucket = nullptr;
+        --num_timers;
+        return true;
+    }
+
+    // move timer from given bucket to the slot of its expiration
+    void insert(bucket_type& from, bucket_type::iterator iter) {
+        Timer& timer = **iter;
+        uint64_t delta = timer.expire - current;
+
+        uint64_t place = timer.expire;
+        if (delta >= max_delta) {
+            place = current + max_delta - 1;
+            delta = max_delta - 1;
+        }
+
+        size_t level = 0;
+        while (delta >= (1ull << (num_bits * (level + 1)))) {
+            ++level;
+        }
+
+        bucket_type& target =
+            wheel[level][(place >> (num_bits * level)) & (num_slots - 1)];
+        target.splice(target.end(), from, iter);
+
+        timer.bucket = &target;
+        timer.pos = iter;
+    }
+
+    void advance(clock::time_point now) {
+        ++current;
+        for (size_t level = 1; level < num_levels; ++level) {
+            if ((current & ((1ull << (num_bits * level)) - 1)) != 0) {
+                break;
+            }
+
+            bucket_type moving;
+            moving.splice(moving.end(),
+                          wheel[level][(current >> (num_bits * level))
+                                       & (num_slots - 1)]);
+            while (!moving.empty()) {
+                insert(moving, moving.begin());
+            }
+        }
+
+        bucket_type expired;
+        expired.splice(expired.end(), wheel[0][current & (num_slots - 1)]);
+        while (!expired.empty()) {
+            Timer& timer = *expired.front();
+            if (timer.period > clock::duration::zero()) {
+                timer.fire(now, false);
+                timer.expire =
+                    current
+                    + std::max<uint64_t>(1, timer.period / resolution);
+                insert(expired, expired.begin());
+            }
+            else {
+                timer.fire(now, true);
+                timer.bucket = nullptr;
+                expired.pop_front();
+                --num_timers;
+            }
+        }
+    }
+
+    void run() {
+        std::unique_lock lock(mutex);
+        while (runnable) {
+            if (num_timers == 0) {
+                cond.wait(lock, [&] { return !runnable || num_timers > 0; });
+                continue;
+            }
+
+            clock::time_point now = clock::now();
+            uint64_t target = floor_tick(now);
+            while (current < target && num_timers > 0) {
+                advance(now);
+            }
+            cond.wait_until(lock, start + (current + 1) * resolution);
+        }
+    }
+};
+
+inline bool Timer::Stop() {
+    bool scheduled = false;
+    TimerService* owner = service;
+    if (owner != nullptr) {
+        scheduled = owner->cancel(*this);
+    }
+
+    close();
+    return scheduled;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,291 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "platform/config.hpp"
+
+namespace Trace {
+    constexpr bool enabled = platform::trace;
+
+    struct Event {
+        char const* name;
+        // chrome trace phase, B/E for span, b/e for async span, i for instant
+        char phase;
+        uint64_t id;
+        int64_t ts;
+    };
+
+    // Events of single thread, only the owner appends.
+    // Chunks are never moved, so dump could read while owner records.
+    class Buffer {
+    public:
+        Buffer(size_t tid) : tid(tid), tail(&head) {
+            // Do Nothing
+        }
+
+        ~Buffer() {
+            free_chunks();
+        }
+
+        Buffer(Buffer const&) = delete;
+        Buffer(Buffer&&) = delete;
+
+        Buffer& operator=(Buffer const&) = delete;
+        Buffer& operator=(Buffer&&) = delete;
+
+        void push(Event const& event) {
+            size_t size = tail->size.load(std::memory_order_relaxed);
+            if (size == chunk_size) {
+                Chunk* chunk = new Chunk;
+                tail->next.store(chunk, std::memory_order_release);
+                tail = chunk;
+                size = 0;
+            }
+
+            tail->events[size] = event;
+            tail->size.store(size + 1, std::memory_order_release);
+        }
+
+        template <typename F>
+        void for_each(F&& func) const {
+            for (Chunk const* chunk = &head; chunk != nullptr;
+                 chunk = chunk->next.load(std::memory_order_acquire)) {
+                size_t size = chunk->size.load(std::memory_order_acquire);
+                for (size_t i = 0; i < size; ++i) {
+                    func(chunk->events[i]);
+                }
+            }
+        }
+
+        // only if owner does not record at the same time
+        void clear() {
+            free_chunks();
+            head.size = 0;
+            tail = &head;
+        }
+
+        size_t get_tid() const {
+            return tid;
+        }
+
+    private:
+        static constexpr size_t chunk_size = 1024;
+
+        struct Chunk {
+            Event events[chunk_size];
+            std::atomic<size_t> size{ 0 };
+            std::atomic<Chunk*> next{ nullptr };
+        };
+
+        size_t tid;
+        Chunk head;
+        Chunk* tail;
+
+        void free_chunks() {
+            Chunk* chunk = head.next.exchange(nullptr);
+            while (chunk != nullptr) {
+                Chunk* next = chunk->next.load();
+                delete chunk;
+                chunk = next;
+            }
+        }
+    };
+
+    // Process wide sink, each thread registers its buffer once
+    // and records without lock after it.
+    class Recorder {
+    public:
+        static Recorder& global() {
+            static Recorder recorder;
+            return recorder;
+        }
+
+        void record(char const* name, char phase, uint64_t id = 0) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            local_buffer().push(
+                { name,
+                  phase,
+                  id,
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                      .count() });
+        }
+
+        uint64_t next_id() {
+            return id.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // chrome trace event json, opened by chrome://tracing or perfetto
+        void dump(std::ostream& out) {
+            std::unique_lock lock(mutex);
+
+            bool first = true;
+            auto separate = [&] {
+                out << (first ? "\n" : ",\n");
+                first = false;
+            };
+
+            out << "{\"traceEvents\":[";
+            for (auto const& buffer : buffers) {
+                size_t tid = buffer->get_tid();
+                separate();
+                out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                    << "\"tid\":" << tid << ",\"args\":{\"name\":\"thread "
+                    << tid << "\"}}";
+
+                buffer->for_each([&](Event const& event) {
+                    separate();
+                    write(out, event, tid);
+                });
+            }
+            out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        }
+
+        // only if no thread records at the same time
+        void clear() {
+            std::unique_lock lock(mutex);
+            for (auto const& buffer : buffers) {
+                buffer->clear();
+            }
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start;
+        std::atomic<uint64_t> id;
+
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Buffer>> buffers;
+
+        // buffer outlives its thread, events are kept until clear
+        static inline thread_local std::shared_ptr<Buffer> local;
+
+        Recorder() : start(std::chrono::steady_clock::now()), id(1) {
+            // Do Nothing
+        }
+
+        Buffer& local_buffer() {
+            if (local == nullptr) {
+                std::unique_lock lock(mutex);
+                local = std::make_shared<Buffer>(buffers.size() + 1);
+                buffers.push_back(local);
+            }
+            return *local;
+        }
+
+        static void write(std::ostream& out, Event const& event, size_t tid) {
+            out << "{\"name\":\"";
+            for (char const* c = event.name; *c != '\0'; ++c) {
+                if (*c == '"' || *c == '\\') {
+                    out << '\\';
+                }
+                out << *c;
+            }
+
+            // timestamp in microseconds
+            out << "\",\"cat\":\"concurrency\",\"ph\":\"" << event.phase
+                << "\",\"ts\":" << event.ts / 1000 << '.' << std::setw(3)
+                << std::setfill('0') << event.ts % 1000
+                << ",\"pid\":1,\"tid\":" << tid;
+
+            if (event.phase == 'b' || event.phase == 'e') {
+                out << ",\"id\":" << event.id;
+            }
+            else if (event.id != 0) {
+                out << ",\"args\":{\"id\":" << event.id << '}';
+            }
+            if (event.phase == 'i') {
+                out << ",\"s\":\"t\"";
+            }
+            out << '}';
+        }
+    };
+
+    inline void begin(char const* name, uint64_t id = 0) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'B', id);
+        }
+    }
+
+    inline void end(char const* name, uint64_t id = 0) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'E', id);
+        }
+    }
+
+    inline void instant(char const* name, uint64_t id = 0) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'i', id);
+        }
+    }
+
+    // span which may end on another thread, matched by id
+    inline void async_begin(char const* name, uint64_t id) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'b', id);
+        }
+    }
+
+    inline void async_end(char const* name, uint64_t id) {
+        if constexpr (enabled) {
+            Recorder::global().record(name, 'e', id);
+        }
+    }
+
+    inline bool dump(std::string const& path) {
+        std::ofstream out(path);
+        Recorder::global().dump(out);
+        return static_cast<bool>(out);
+    }
+
+    // record B and E of the scope
+    class Span {
+    public:
+        Span(char const* name, uint64_t id = 0) : name(name), id(id) {
+            begin(name, id);
+        }
+
+        ~Span() {
+            end(name, id);
+        }
+
+        Span(Span const&) = delete;
+        Span(Span&&) = delete;
+
+        Span& operator=(Span const&) = delete;
+        Span& operator=(Span&&) = delete;
+
+    private:
+        char const* name;
+        uint64_t id;
+    };
+
+    // Wrap task of pool, "queued" spans from submit to dequeue and
+    // "task" spans from start to end. Returns func itself if disabled.
+    template <typename F>
+    decltype(auto) task(F&& func) {
+        if constexpr (!enabled) {
+            return std::forward<F>(func);
+        }
+        else {
+            uint64_t id = Recorder::global().next_id();
+            async_begin("queued", id);
+            return [id, func = std::forward<F>(func)]() mutable {
+                async_end("queued", id);
+                Span span("task", id);
+                return func();
+            };
+        }
+    }
+}  // namespace Trace
+
+#endif
\ No newline at end of file
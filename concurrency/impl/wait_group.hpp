@@ -2,10 +2,13 @@
 #define WAIT_GROUP_HPP
 
 #include <atomic>
-#include <thread>
+
+#include "policy.hpp"
+#include "trace.hpp"
 
 using ull = unsigned long long;
 
+// Counter of pending works, waiters park until it drops to zero.
 class WaitGroup {
 public:
     WaitGroup() : visit(0) {
@@ -21,17 +24,21 @@ public:
     }
 
     ull Done() {
-        return (visit -= 1);
+        ull remain = (visit -= 1);
+        if (remain == 0) {
+            waiter.notify();
+        }
+        return remain;
     }
 
     void Wait() {
-        while (visit > 0) {
-            std::this_thread::yield();
-        }
+        Trace::Span span("WaitGroup::Wait");
+        waiter.wait([&] { return visit == 0; });
     }
 
 private:
     std::atomic<ull> visit;
+    Policy::Adaptive waiter;
 };
 
 #endif
\ No newline at end of file
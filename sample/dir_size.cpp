@@ -23,39 +23,28 @@ ull sizeof_dir(fs::path const& path) {
 }
 
 ull par_sizeof_dir(fs::path const& path) {
-    WaitGroup wg = 1;
-    LChannel<ull> channel;
-    LThreadPool<void> pool;
+    if (fs::is_regular_file(path)) {
+        return fs::file_size(path);
+    }
 
-    std::function<void(fs::path const&)> par = [&](fs::path const& path) {
-        if (fs::is_regular_file(path)) {
-            channel << fs::file_size(path);
-            return;
-        }
-        if (fs::is_directory(path)) {
-            ull res = 0;
-            for (auto const& dir : fs::directory_iterator(path)) {
-                if (dir.is_regular_file()) {
-                    res += dir.file_size();
-                }
-                else if (dir.is_directory()) {
-                    wg.Add();
-                    pool.Add([&, path = dir.path()] { par(path); });
+    // follow symlinks as sizeof_dir does
+    WalkOptions options;
+    options.follow_symlinks = true;
+
+    return parallel_walk(
+        path,
+        0ull,
+        [](ull& acc, fs::directory_entry const& entry) {
+            std::error_code ec;
+            if (entry.is_regular_file(ec)) {
+                ull size = entry.file_size(ec);
+                if (!ec) {
+                    acc += size;
                 }
             }
-            channel << res;
-            if (wg.Done() == 0) {
-                channel.Close();
-            }
-        }
-    };
-    par(path);
-
-    ull res = 0;
-    for (auto const& size : channel) {
-        res += size;
-    }
-    return res;
+        },
+        [](ull lhs, ull rhs) { return lhs + rhs; },
+        options);
 }
 
 template <typename T, typename F, typename... Args>
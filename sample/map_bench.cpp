@@ -0,0 +1,102 @@
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../concurrency.hpp"
+
+namespace chrono = std::chrono;
+
+// unordered_map behind single mutex, as shared lookup tables were
+class LockedMap {
+public:
+    std::optional<size_t> find(size_t key) {
+        std::unique_lock lock(mutex);
+        auto iter = map.find(key);
+        if (iter == map.end()) {
+            return std::nullopt;
+        }
+        return iter->second;
+    }
+
+    void insert_or_assign(size_t key, size_t value) {
+        std::unique_lock lock(mutex);
+        map.insert_or_assign(key, value);
+    }
+
+    void erase(size_t key) {
+        std::unique_lock lock(mutex);
+        map.erase(key);
+    }
+
+private:
+    std::mutex mutex;
+    std::unordered_map<size_t, size_t> map;
+};
+
+// `num_threads` threads run `num_ops` operations each over `num_keys`
+// keys, `writes` percent of them half insert and half erase,
+// returns throughput in operations per second
+template <typename Map>
+double throughput(size_t num_threads, size_t num_ops, size_t writes) {
+    constexpr size_t num_keys = 1 << 16;
+
+    Map map;
+    for (size_t key = 0; key < num_keys; key += 2) {
+        map.insert_or_assign(key, key);
+    }
+
+    auto start = chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&, i] {
+            std::mt19937_64 rng(i);
+            size_t found = 0;
+            for (size_t n = 0; n < num_ops; ++n) {
+                size_t key = rng() % num_keys;
+                size_t op = rng() % 200;
+                if (op < writes) {
+                    map.insert_or_assign(key, n);
+                }
+                else if (op < 2 * writes) {
+                    map.erase(key);
+                }
+                else if (map.find(key).has_value()) {
+                    ++found;
+                }
+            }
+            volatile size_t sink = found;
+            (void)sink;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = chrono::steady_clock::now();
+
+    chrono::duration<double> sec = end - start;
+    return num_threads * num_ops / sec.count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_ops = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+    for (size_t writes : { 10, 50 }) {
+        std::cout << "writes: " << writes << "%\n";
+        for (size_t threads : { 1, 8, 64 }) {
+            std::cout << "threads: " << threads << " / ConcurrentHashMap: "
+                      << throughput<ConcurrentHashMap<size_t, size_t>>(
+                             threads, num_ops, writes)
+                      << " / locked unordered_map: "
+                      << throughput<LockedMap>(threads, num_ops, writes)
+                      << " ops/s\n";
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../concurrency.hpp"
+
+namespace chrono = std::chrono;
+
+template <typename F>
+double measure(F&& func) {
+    auto start = chrono::steady_clock::now();
+    func();
+    chrono::duration<double> sec = chrono::steady_clock::now() - start;
+    return sec.count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t size = argc > 1 ? std::stoul(argv[1]) : 10000000;
+
+    std::mt19937_64 rng(0);
+    std::vector<long long> data(size);
+    for (auto& value : data) {
+        value = static_cast<long long>(rng() >> 1);
+    }
+
+    ThreadPool<void> pool(std::max(1u, std::thread::hardware_concurrency())
+                          - 1);
+    std::cout << "size: " << size << ", threads: " << pool.GetNumThreads() + 1
+              << '\n';
+
+    std::vector<long long> vec = data;
+    std::cout << "std::sort: "
+              << measure([&] { std::sort(vec.begin(), vec.end()); }) << "s / ";
+
+    vec = data;
+    std::cout << "parallel_sort: "
+              << measure([&] { parallel_sort(pool, vec.begin(), vec.end()); })
+              << "s\n";
+
+    long long sum = 0;
+    std::cout << "std::reduce: " << measure([&] {
+        sum = std::reduce(data.begin(), data.end(), 0LL);
+    }) << "s / ";
+    std::cout << "parallel_reduce: " << measure([&] {
+        sum -= parallel_reduce(pool, data.begin(), data.end(), 0LL);
+    }) << "s\n";
+
+    std::cout << "std::inclusive_scan: " << measure([&] {
+        std::inclusive_scan(data.begin(), data.end(), vec.begin());
+    }) << "s / ";
+    std::cout << "parallel_inclusive_scan: " << measure([&] {
+        parallel_inclusive_scan(pool, data.begin(), data.end(), vec.begin());
+    }) << "s\n";
+
+    return sum == 0 ? 0 : 1;
+}
\ No newline at end of file
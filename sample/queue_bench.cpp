@@ -0,0 +1,66 @@
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <thread>
+#include <vector>
+
+#include "../concurrency.hpp"
+
+namespace chrono = std::chrono;
+
+// push and pop `num_items` items per producer with `num_pairs`
+// producer-consumer pairs, returns throughput in items per second
+template <typename Queue>
+double throughput(size_t num_pairs, size_t num_items) {
+    Queue queue;
+
+    auto start = chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_pairs; ++i) {
+        threads.emplace_back([&] {
+            for (size_t n = 0; n < num_items; ++n) {
+                queue.push_back(n);
+            }
+        });
+        threads.emplace_back([&] {
+            for (size_t n = 0; n < num_items;) {
+                if (queue.try_pop().has_value()) {
+                    ++n;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = chrono::steady_clock::now();
+
+    chrono::duration<double> sec = end - start;
+    return num_pairs * num_items / sec.count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t num_items = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t max_pairs = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+    for (size_t pairs = 1; pairs <= max_pairs; pairs *= 2) {
+        std::cout << "pairs: " << pairs << " / LockFree::List: "
+                  << throughput<LockFree::List<size_t>>(pairs, num_items)
+                  << " / TSList: "
+                  << throughput<TSList<size_t>>(pairs, num_items)
+                  << " / TSList<SpinLock>: "
+                  << throughput<ThreadSafe<std::list<size_t>, SpinLock>>(
+                         pairs, num_items)
+                  << " / TSList<AdaptiveMutex>: "
+                  << throughput<ThreadSafe<std::list<size_t>, AdaptiveMutex>>(
+                         pairs, num_items)
+                  << " / ShardedQueue: "
+                  << throughput<ShardedQueue<size_t>>(pairs, num_items)
+                  << " / LockFree::SegmentQueue: "
+                  << throughput<LockFree::SegmentQueue<size_t>>(pairs,
+                                                                num_items)
+                  << " items/s\n";
+    }
+
+    return 0;
+}
\ No newline at end of file
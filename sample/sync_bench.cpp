@@ -0,0 +1,99 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __has_include(<barrier>) && __cplusplus >= 202002L
+#include <barrier>
+#include <semaphore>
+#define HAS_STD_SYNC
+#endif
+
+#include "../concurrency.hpp"
+
+namespace chrono = std::chrono;
+
+// run `func(i)` on `num_threads` threads, returns elapsed seconds
+template <typename F>
+double measure(size_t num_threads, F&& func) {
+    auto start = chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&, i] { func(i); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    chrono::duration<double> sec = chrono::steady_clock::now() - start;
+    return sec.count();
+}
+
+// phases per second of `num_threads` threads passing the barrier
+template <typename Barrier>
+double phases(size_t num_threads, size_t num_phases) {
+    Barrier barrier(num_threads);
+    double sec = measure(num_threads, [&](size_t) {
+        for (size_t n = 0; n < num_phases; ++n) {
+            barrier.arrive_and_wait();
+        }
+    });
+    return num_phases / sec;
+}
+
+// acquisitions per second of `num_threads` threads sharing 2 permits
+template <typename Semaphore>
+double acquires(size_t num_threads, size_t num_items) {
+    Semaphore semaphore(2);
+    double sec = measure(num_threads, [&](size_t) {
+        for (size_t n = 0; n < num_items; ++n) {
+            semaphore.acquire();
+            semaphore.release();
+        }
+    });
+    return num_threads * num_items / sec;
+}
+
+// adapt to standard interface
+struct BarrierAdapter : Barrier {
+    using Barrier::Barrier;
+
+    void arrive_and_wait() {
+        ArriveAndWait();
+    }
+};
+
+struct SemaphoreAdapter : Semaphore {
+    using Semaphore::Semaphore;
+
+    void acquire() {
+        Acquire();
+    }
+
+    void release() {
+        Release();
+    }
+};
+
+int main(int argc, char* argv[]) {
+    size_t num_items = argc > 1 ? std::stoul(argv[1]) : 10000;
+    size_t max_threads = std::max(2u, std::thread::hardware_concurrency());
+
+    for (size_t threads = 2; threads <= max_threads; threads *= 2) {
+        std::cout << "threads: " << threads << " / Barrier: "
+                  << phases<BarrierAdapter>(threads, num_items)
+#ifdef HAS_STD_SYNC
+                  << " / std::barrier: "
+                  << phases<std::barrier<>>(threads, num_items)
+#endif
+                  << " phases/s / Semaphore: "
+                  << acquires<SemaphoreAdapter>(threads, num_items)
+#ifdef HAS_STD_SYNC
+                  << " / std::counting_semaphore: "
+                  << acquires<std::counting_semaphore<>>(threads, num_items)
+#endif
+                  << " acquires/s\n";
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -4,31 +4,11 @@
 
 using namespace std::literals;
 
-LThreadPool<void> global_pool;
-inline auto sleep = [](auto dur) { std::this_thread::sleep_for(dur); };
-
-template <typename T>
-auto Tick(T dur, LThreadPool<void>& pool = global_pool) {
-    auto tick = std::make_unique<LChannel<int>>();;
-    pool.Add([tick = tick.get()]{
-        while (tick->Runnable()) {
-            sleep(100ms);
-            tick->Add(0);
-        }
-    });
-    return std::move(tick);
-}
-
-template <typename T>
-auto After(T dur, LThreadPool<void>& pool = global_pool) {
-    auto after = std::make_unique<LChannel<int>>();
-    pool.Add([=, after = after.get()]{ sleep(dur); after->Add(0); });
-    return std::move(after);
-}
-
 int main() {
-    auto tick = Tick(100ms);
-    auto boom = After(500ms);
+    TimerService timer;
+
+    auto tick = timer.Tick(100ms);
+    auto boom = timer.After(500ms);
 
     bool cont = true;
     while (cont) {
@@ -42,12 +22,11 @@ int main() {
             },
             default_m >> [&]{
                 std::cout << "." << std::endl;
-                sleep(50ms);
+                std::this_thread::sleep_for(50ms);
             }
         );
     }
-    tick->Close();
-    global_pool.Stop();
+    tick->Stop();
 
     return 0;
 }
\ No newline at end of file
@@ -109,7 +109,7 @@ def file_list(dirname, ban_dir=[]):
     if isinstance(ban_dir, str):
         ban_dir = [ban_dir]
 
-    for name in os.listdir(dirname):
+    for name in sorted(os.listdir(dirname)):
         full_path = os.path.join(dirname, name)
         if os.path.isfile(full_path):
             files.append(full_path)
@@ -128,8 +128,9 @@ def in_endswith(name, files):
 def order_dep(deps, files, done):
     info = SourceInfo()
     for dep in deps:
-        if in_endswith(dep, done) is None:
-            path = in_endswith(dep.split('/')[-1], files)
+        name = '/' + dep.split('/')[-1]
+        if in_endswith(name, done) is None:
+            path = in_endswith(name, files)
 
             if path is not None:
                 new = SourceInfo.read_file(path)
@@ -148,7 +149,7 @@ def none_preproc(dirname):
     dep = []
     out = ''
     includes = ''
-    for files in os.listdir(dirname):
+    for files in sorted(os.listdir(dirname)):
         with open(os.path.join(dirname, files)) as f:
             lines = f.readlines()
         
@@ -207,7 +208,7 @@ def merge(dirname):
 
 def write_hpp(outfile, merged):
     info, preproc_dep = merged
-    dep_check = lambda file: not any(file.endswith(dep) for dep in preproc_dep)
+    dep_check = lambda file: file not in preproc_dep
 
     idx = outfile.rfind('/')
     if idx > -1:
@@ -231,7 +232,63 @@ def write_hpp(outfile, merged):
     with open(outfile, 'w') as f:
         f.write(out)
 
+def quoted_deps(path):
+    deps = []
+    with open(path) as f:
+        for line in f.readlines():
+            name = ReSupport.include_dep(line)
+            if len(name) > 0:
+                deps.append(os.path.normpath(
+                    os.path.join(os.path.dirname(path), name[0])))
+    return deps
+
+
+def dep_closure(path, done):
+    for dep in quoted_deps(path):
+        if dep not in done:
+            dep_closure(dep, done)
+
+    if path not in done:
+        done.append(path)
+    return done
+
+
+def slim_source(path):
+    out = ''
+    with open(path) as f:
+        for line in f.readlines():
+            if len(ReSupport.include_dep(line)) > 0 \
+                    or line.startswith('// merge:'):
+                continue
+            out += line
+    return out + '\n\n'
+
+
+def write_slim(outdir, dirname):
+    """Header per component with only its own dependencies.
+    Guards of each source are kept, so slim headers could be included
+    together, but not with the merged single header."""
+    os.makedirs(outdir, exist_ok=True)
+
+    for name in sorted(os.listdir(dirname)):
+        path = os.path.join(dirname, name)
+        if not os.path.isfile(path):
+            continue
+
+        out = ''.join(slim_source(dep) for dep in dep_closure(path, []))
+        guard_name = 'CONCURRENCY_SLIM_' + name.upper().replace('.', '_')
+        out = Format.hpp.format(guard_name, '', '', out)
+
+        with open(os.path.join(outdir, name), 'w') as f:
+            f.write(Format.hpp_beutifier(out))
+
+
 if __name__ == "__main__":
+    if len(sys.argv) > 2 and sys.argv[1] == '--slim':
+        dirname = sys.argv[3] if len(sys.argv) > 3 else './concurrency/impl'
+        write_slim(sys.argv[2], dirname)
+        sys.exit(0)
+
     if len(sys.argv) > 1:
         outfile = sys.argv[1]
     else:
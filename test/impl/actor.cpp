@@ -0,0 +1,80 @@
+#include <catch2/catch.hpp>
+#include <actor.hpp>
+
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("Actor::Send", "[actor]") {
+    ThreadPool<void> pool(4);
+
+    std::vector<int> received;
+    Actor<int> actor(pool, [&](int& msg) { received.push_back(msg); });
+
+    constexpr int test_num = 1000;
+    for (int i = 0; i < test_num; ++i) {
+        actor << i;
+    }
+    actor.Wait();
+
+    REQUIRE(actor.Pending() == 0);
+    REQUIRE(received.size() == test_num);
+    for (int i = 0; i < test_num; ++i) {
+        REQUIRE(received[i] == i);
+    }
+
+    actor.Close();
+    REQUIRE(!actor.Runnable());
+    REQUIRE(!actor.Send(-1));
+}
+
+TEST_CASE("Actor many on small pool", "[actor]") {
+    ThreadPool<void> pool(2);
+
+    constexpr size_t num_actors = 10000;
+    constexpr size_t test_num = 10;
+
+    std::vector<size_t> sums(num_actors, 0);
+    std::vector<Actor<size_t>> actors;
+    for (size_t i = 0; i < num_actors; ++i) {
+        actors.emplace_back(
+            pool, [&, i](size_t& msg) { sums[i] += msg; }, 4);
+    }
+
+    std::vector<std::future<void>> futs;
+    for (size_t p = 0; p < 4; ++p) {
+        futs.emplace_back(std::async(std::launch::async, [&] {
+            for (size_t j = 1; j <= test_num; ++j) {
+                for (auto& actor : actors) {
+                    actor.Send(j);
+                }
+            }
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+    for (auto& actor : actors) {
+        actor.Wait();
+    }
+
+    for (size_t sum : sums) {
+        REQUIRE(sum == 4 * test_num * (test_num + 1) / 2);
+    }
+}
+
+TEST_CASE("Actor::Wait rethrow", "[actor]") {
+    InboxThreadPool<void> pool(2);
+
+    int handled = 0;
+    Actor<int, InboxThreadPool<void>> actor(pool, [&](int& msg) {
+        if (msg == 1) {
+            throw std::runtime_error("actor");
+        }
+        ++handled;
+    });
+
+    actor << 0 << 1 << 2;
+    REQUIRE_THROWS_AS(actor.Wait(), std::runtime_error);
+    REQUIRE(handled == 2);
+}
\ No newline at end of file
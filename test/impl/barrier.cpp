@@ -0,0 +1,85 @@
+#include <catch2/catch.hpp>
+#include <barrier.hpp>
+#include <wait_group.hpp>
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+TEST_CASE("Latch", "[barrier]") {
+    Latch latch(3);
+    REQUIRE(!latch.TryWait());
+
+    std::atomic<int> counter = 0;
+    std::vector<std::future<void>> futs;
+    for (int i = 0; i < 3; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&] {
+            ++counter;
+            latch.CountDown();
+        }));
+    }
+
+    latch.Wait();
+    REQUIRE(latch.TryWait());
+    REQUIRE(counter == 3);
+}
+
+TEST_CASE("Barrier", "[barrier]") {
+    constexpr size_t num_threads = 19;
+    constexpr size_t num_phases = 100;
+
+    // every thread should see all arrivals of previous phase
+    std::atomic<size_t> arrived = 0;
+    size_t completed = 0;
+    Barrier barrier(num_threads, [&] { ++completed; });
+
+    std::atomic<bool> failed = false;
+    std::vector<std::future<void>> futs;
+    for (size_t i = 0; i < num_threads; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&] {
+            for (size_t phase = 0; phase < num_phases; ++phase) {
+                ++arrived;
+                barrier.ArriveAndWait();
+                if (arrived < num_threads * (phase + 1)) {
+                    failed = true;
+                }
+                barrier.ArriveAndWait();
+            }
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+
+    REQUIRE(!failed);
+    REQUIRE(completed == 2 * num_phases);
+    REQUIRE(barrier.GetPhase() == 2 * num_phases);
+}
+
+TEST_CASE("Barrier::Arrive", "[barrier]") {
+    Barrier barrier(2);
+
+    size_t phase = barrier.Arrive();
+    REQUIRE(barrier.GetPhase() == phase);
+
+    auto fut = std::async(std::launch::async, [&] { barrier.Arrive(); });
+    barrier.Wait(phase);
+    fut.get();
+    REQUIRE(barrier.GetPhase() == phase + 1);
+}
+
+TEST_CASE("WaitGroup", "[barrier]") {
+    WaitGroup wg(4);
+
+    std::atomic<int> counter = 0;
+    std::vector<std::future<void>> futs;
+    for (int i = 0; i < 4; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&] {
+            ++counter;
+            wg.Done();
+        }));
+    }
+
+    wg.Wait();
+    REQUIRE(counter == 4);
+}
\ No newline at end of file
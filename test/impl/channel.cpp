@@ -0,0 +1,194 @@
+#include <catch2/catch.hpp>
+#include <channel.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Channel::Consume", "[channel]") {
+    RChannel<std::vector<int>> channel(3);
+    channel.Add(std::vector<int>{ 1, 2, 3 });
+
+    int acc = 0;
+    REQUIRE(channel.Consume([&](std::vector<int>& vec) {
+        for (int elem : vec) {
+            acc += elem;
+        }
+    }));
+    REQUIRE(acc == 6);
+
+    channel.Close();
+    REQUIRE(!channel.Consume([](std::vector<int>&) {}));
+}
+
+TEST_CASE("Channel::Reserve, Commit", "[channel]") {
+    RChannel<std::vector<int>> channel(2);
+
+    auto slot = channel.Reserve();
+    REQUIRE(static_cast<bool>(slot));
+
+    slot->assign({ 1, 2, 3 });
+    channel.Commit(slot);
+    REQUIRE(!static_cast<bool>(slot));
+
+    {
+        auto dropped = channel.Reserve();
+        dropped->assign({ 4 });
+    }
+
+    auto res = channel.TryGet();
+    REQUIRE(res.has_value());
+    REQUIRE(res.value() == std::vector<int>{ 1, 2, 3 });
+    REQUIRE(!channel.TryGet().has_value());
+
+    channel.Close();
+    REQUIRE(!static_cast<bool>(channel.Reserve()));
+}
+
+TEST_CASE("Channel::Reserve, Consume concurrently", "[channel]") {
+    RChannel<size_t> channel(4);
+    constexpr size_t test_num = 1000;
+
+    auto fut = std::async(std::launch::async, [&] {
+        for (size_t i = 1; i <= test_num; ++i) {
+            auto slot = channel.Reserve();
+            *slot = i;
+            channel.Commit(slot);
+        }
+        channel.Close();
+    });
+
+    size_t acc = 0;
+    while (channel.Consume([&](size_t& value) { acc += value; }))
+        ;
+    fut.wait();
+
+    REQUIRE(acc == test_num * (test_num + 1) / 2);
+}
+
+TEST_CASE("Channel::TryAdd", "[channel]") {
+    RChannel<int> channel(2);
+    REQUIRE(channel.TryAdd(1));
+    REQUIRE(channel.TryAdd(2));
+    REQUIRE(!channel.TryAdd(3));
+
+    REQUIRE(channel.TryGet().value() == 1);
+    REQUIRE(channel.TryAdd(3));
+
+    channel.Close();
+    REQUIRE(!channel.TryAdd(4));
+}
+
+TEST_CASE("Channel::AddFor, GetFor", "[channel]") {
+    using namespace std::chrono_literals;
+    RChannel<int> channel(1);
+
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(!channel.GetFor(20ms).has_value());
+    REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+
+    REQUIRE(channel.AddFor(20ms, 1));
+    REQUIRE(!channel.AddFor(20ms, 2));
+
+    auto fut = std::async(std::launch::async, [&] {
+        std::this_thread::sleep_for(10ms);
+        return channel.Get();
+    });
+    REQUIRE(channel.AddFor(10s, 2));
+    REQUIRE(fut.get().value() == 1);
+
+    auto deadline = std::chrono::steady_clock::now() + 10s;
+    REQUIRE(channel.GetUntil(deadline).value() == 2);
+
+    channel.Close();
+    REQUIRE(!channel.GetFor(10s).has_value());
+}
+
+TEST_CASE("Channel::TryGet under contention", "[channel]") {
+    LChannel<size_t> channel;
+    constexpr size_t test_num = 10000;
+    for (size_t i = 0; i < test_num; ++i) {
+        channel.Add(i);
+    }
+
+    std::atomic<size_t> count = 0;
+    std::vector<std::future<void>> futs;
+    for (size_t i = 0; i < 4; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&] {
+            while (channel.TryGet().has_value()) {
+                ++count;
+            }
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+
+    REQUIRE(count == test_num);
+}
+
+TEST_CASE("ShardedChannel::Add, Get", "[channel]") {
+    ShardedChannel<int> channel(4);
+    channel.Add(1);
+    channel << 2;
+
+    REQUIRE(channel.Get().value() == 1);
+    REQUIRE(channel.TryGet().value() == 2);
+    REQUIRE(!channel.TryGet().has_value());
+
+    channel.Close();
+    REQUIRE(!channel.Readable());
+    REQUIRE(!channel.Get().has_value());
+}
+
+TEST_CASE("ShardedChannel with many producers", "[channel]") {
+    ShardedChannel<std::pair<size_t, size_t>> channel(4);
+    constexpr size_t num_producers = 8;
+    constexpr size_t test_num = 1000;
+
+    std::vector<std::future<void>> producers;
+    for (size_t id = 0; id < num_producers; ++id) {
+        producers.emplace_back(std::async(std::launch::async, [&, id] {
+            for (size_t i = 1; i <= test_num; ++i) {
+                channel.Add(id, i);
+            }
+        }));
+    }
+
+    auto closer = std::async(std::launch::async, [&] {
+        for (auto& fut : producers) {
+            fut.wait();
+        }
+        channel.Close();
+    });
+
+    size_t acc = 0;
+    std::vector<size_t> last(num_producers, 0);
+    for (auto const& [id, value] : channel) {
+        REQUIRE(value > last[id]);
+        last[id] = value;
+        acc += value;
+    }
+    closer.wait();
+
+    REQUIRE(acc == num_producers * test_num * (test_num + 1) / 2);
+}
+
+TEST_CASE("ShardedChannel::TryAdd, GetFor", "[channel]") {
+    using namespace std::chrono_literals;
+    ShardedChannel<int> channel(4);
+    REQUIRE(!channel.GetFor(10ms).has_value());
+
+    auto fut = std::async(std::launch::async, [&] {
+        std::this_thread::sleep_for(10ms);
+        return channel.TryAdd(1);
+    });
+    REQUIRE(channel.GetFor(10s).value() == 1);
+    REQUIRE(fut.get());
+
+    channel.Close();
+    REQUIRE(!channel.TryAdd(2));
+    REQUIRE(!channel.GetFor(10s).has_value());
+}
\ No newline at end of file
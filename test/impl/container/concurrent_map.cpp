@@ -0,0 +1,103 @@
+#include <catch2/catch.hpp>
+#include <container/concurrent_map.hpp>
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <vector>
+
+TEST_CASE("ConcurrentHashMap", "[concurrent_map]") {
+    ConcurrentHashMap<std::string, int> map;
+    REQUIRE(map.empty());
+
+    REQUIRE(map.insert_or_assign("one", 1));
+    REQUIRE(map.insert_or_assign("two", 2));
+    REQUIRE(!map.insert_or_assign("one", 10));
+    REQUIRE(map.size() == 2);
+
+    REQUIRE(map.find("one").value() == 10);
+    REQUIRE(!map.find("three").has_value());
+    REQUIRE(map.compute_if_absent("two", [](auto const&) { return 0; }) == 2);
+    REQUIRE(map.compute_if_absent("three", [](auto const&) { return 3; })
+            == 3);
+
+    REQUIRE(map.erase("two"));
+    REQUIRE(!map.erase("two"));
+    REQUIRE(!map.contains("two"));
+
+    int sum = 0;
+    map.for_each([&](std::string const&, int value) { sum += value; });
+    REQUIRE(sum == 13);
+}
+
+TEST_CASE("ConcurrentHashMap::rehash", "[concurrent_map]") {
+    constexpr int num_threads = 4;
+    constexpr int num_keys = 10000;
+
+    ConcurrentHashMap<int, int> map;
+    size_t num_buckets = map.bucket_count();
+
+    // readers keep looking up while writers grow the table
+    std::atomic<bool> done = false;
+    std::atomic<bool> failed = false;
+    auto reader = std::async(std::launch::async, [&] {
+        while (!done) {
+            for (int key = 0; key < num_keys; key += 97) {
+                auto value = map.find(key);
+                if (value.has_value() && value.value() != key * 2) {
+                    failed = true;
+                }
+            }
+        }
+    });
+
+    std::vector<std::future<void>> futs;
+    for (int i = 0; i < num_threads; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&, i] {
+            for (int key = i; key < num_keys; key += num_threads) {
+                map.insert_or_assign(key, key * 2);
+            }
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+    done = true;
+    reader.get();
+
+    REQUIRE(!failed);
+    REQUIRE(map.size() == num_keys);
+    REQUIRE(map.bucket_count() > num_buckets);
+    for (int key = 0; key < num_keys; ++key) {
+        REQUIRE(map.find(key).value() == key * 2);
+    }
+}
+
+TEST_CASE("ConcurrentHashMap::compute_if_absent", "[concurrent_map]") {
+    ConcurrentHashMap<int, int> map;
+
+    // func runs once per key, all callers see its value
+    std::atomic<int> calls = 0;
+    std::atomic<bool> failed = false;
+    std::vector<std::future<void>> futs;
+    for (int i = 0; i < 4; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&] {
+            for (int key = 0; key < 1000; ++key) {
+                int value = map.compute_if_absent(key, [&](int given) {
+                    ++calls;
+                    return given + 1;
+                });
+                if (value != key + 1) {
+                    failed = true;
+                }
+            }
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+
+    REQUIRE(!failed);
+    REQUIRE(calls == 1000);
+    REQUIRE(map.size() == 1000);
+}
\ No newline at end of file
@@ -13,14 +13,9 @@ TEST_CASE("List::push_back", "[lockfree/list]") {
 
     constexpr size_t test_num = 1000;
 
-    std::vector<std::future<void>> futs;
-    for (size_t i = 1; i <= test_num; ++i) {
-        futs.emplace_back(pool.Add([&, i] { list.push_back(i); }));
-    }
-
-    for (auto& fut : futs) {
-        fut.get();
-    }
+    auto batch =
+        pool.AddN(test_num, [&](size_t i) { list.push_back(i + 1); });
+    batch.Wait();
 
     REQUIRE(list.size() == test_num);
 
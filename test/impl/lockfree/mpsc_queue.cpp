@@ -0,0 +1,122 @@
+#include <catch2/catch.hpp>
+#include <channel.hpp>
+#include <lockfree/mpsc_queue.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace {
+    struct Message : LockFree::MpscHook {
+        size_t value;
+
+        Message(size_t value) : value(value) {
+            // Do Nothing
+        }
+    };
+}  // namespace
+
+TEST_CASE("IntrusiveMpsc::push, pop", "[lockfree/mpsc_queue]") {
+    LockFree::IntrusiveMpsc<Message> queue;
+    REQUIRE(queue.pop() == nullptr);
+
+    Message first(1), second(2);
+    queue.push(&first);
+    queue.push(&second);
+
+    REQUIRE(queue.pop() == &first);
+    REQUIRE(queue.pop() == &second);
+    REQUIRE(queue.pop() == nullptr);
+
+    queue.push(&first);
+    REQUIRE(queue.pop() == &first);
+    REQUIRE(queue.pop() == nullptr);
+}
+
+TEST_CASE("IntrusiveMpsc concurrently", "[lockfree/mpsc_queue]") {
+    LockFree::IntrusiveMpsc<Message> queue;
+
+    constexpr size_t num_producers = 4;
+    constexpr size_t test_num = 10000;
+
+    std::vector<std::unique_ptr<Message>> messages;
+    for (size_t i = 0; i < num_producers * test_num; ++i) {
+        messages.emplace_back(std::make_unique<Message>(i % test_num + 1));
+    }
+
+    std::vector<std::future<void>> futs;
+    for (size_t i = 0; i < num_producers; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&, i] {
+            for (size_t j = 0; j < test_num; ++j) {
+                queue.push(messages[i * test_num + j].get());
+            }
+        }));
+    }
+
+    size_t acc = 0;
+    for (size_t n = 0; n < num_producers * test_num;) {
+        if (Message* msg = queue.pop()) {
+            acc += msg->value;
+            ++n;
+        }
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+
+    REQUIRE(acc == num_producers * test_num * (test_num + 1) / 2);
+    REQUIRE(queue.pop() == nullptr);
+}
+
+TEST_CASE("MpscChannel::Add, Get", "[lockfree/mpsc_queue]") {
+    MpscChannel<std::unique_ptr<int>> channel;
+    channel.Add(std::make_unique<int>(1));
+    channel << std::make_unique<int>(2);
+
+    REQUIRE(*channel.Get().value() == 1);
+    REQUIRE(*channel.TryGet().value() == 2);
+    REQUIRE(!channel.TryGet().has_value());
+
+    using namespace std::chrono_literals;
+    REQUIRE(!channel.GetFor(10ms).has_value());
+
+    channel.Add(std::make_unique<int>(3));
+    channel.Close();
+    REQUIRE(!channel.TryAdd(std::make_unique<int>(4)));
+
+    REQUIRE(*channel.Get().value() == 3);
+    REQUIRE(!channel.Readable());
+    REQUIRE(!channel.Get().has_value());
+}
+
+TEST_CASE("MpscChannel concurrently", "[lockfree/mpsc_queue]") {
+    MpscChannel<size_t> channel;
+
+    constexpr size_t num_producers = 4;
+    constexpr size_t test_num = 10000;
+
+    std::vector<std::future<void>> futs;
+    for (size_t i = 0; i < num_producers; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&] {
+            for (size_t j = 1; j <= test_num; ++j) {
+                channel.Add(j);
+            }
+        }));
+    }
+
+    auto closer = std::async(std::launch::async, [&] {
+        for (auto& fut : futs) {
+            fut.get();
+        }
+        channel.Close();
+    });
+
+    size_t acc = 0;
+    for (size_t value : channel) {
+        acc += value;
+    }
+    closer.get();
+
+    REQUIRE(acc == num_producers * test_num * (test_num + 1) / 2);
+}
\ No newline at end of file
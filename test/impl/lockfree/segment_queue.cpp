@@ -0,0 +1,111 @@
+#include <catch2/catch.hpp>
+#include <channel.hpp>
+#include <lockfree/segment_queue.hpp>
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    // small segments to cross and recycle them often
+    template <typename T>
+    using SmallQueue =
+        LockFree::SegmentQueue<T, Policy::Park, std::allocator<T>, 4>;
+}  // namespace
+
+TEST_CASE("SegmentQueue::push_back, try_pop", "[lockfree/segment_queue]") {
+    SmallQueue<std::string> queue;
+    REQUIRE(!queue.try_pop().has_value());
+
+    for (size_t round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < 10; ++i) {
+            queue.push_back(std::to_string(i));
+        }
+        REQUIRE(queue.size() == 10);
+
+        for (size_t i = 0; i < 10; ++i) {
+            REQUIRE(queue.try_pop().value() == std::to_string(i));
+        }
+        REQUIRE(!queue.try_pop().has_value());
+    }
+
+    // left items are released with the queue
+    auto shared = std::make_shared<int>(0);
+    {
+        SmallQueue<std::shared_ptr<int>> left;
+        for (size_t i = 0; i < 10; ++i) {
+            left.push_back(shared);
+        }
+        left.try_pop();
+        REQUIRE(shared.use_count() == 10);
+    }
+    REQUIRE(shared.use_count() == 1);
+}
+
+TEST_CASE("SegmentQueue::close", "[lockfree/segment_queue]") {
+    SmallQueue<int> queue;
+    queue.push_back(1);
+    queue.close();
+
+    REQUIRE(!queue.try_emplace_back(2));
+    REQUIRE(queue.readable());
+    REQUIRE(queue.pop_front().value() == 1);
+    REQUIRE(!queue.pop_front().has_value());
+    REQUIRE(!queue.readable());
+}
+
+TEST_CASE("SegmentQueue concurrently", "[lockfree/segment_queue]") {
+    SmallQueue<size_t> queue;
+
+    constexpr size_t num_threads = 4;
+    constexpr size_t test_num = 20000;
+
+    std::vector<std::future<size_t>> sums;
+    for (size_t i = 0; i < num_threads; ++i) {
+        sums.emplace_back(std::async(std::launch::async, [&] {
+            size_t sum = 0;
+            for (size_t n = 0; n < test_num; ++n) {
+                sum += queue.pop_front().value();
+            }
+            return sum;
+        }));
+    }
+
+    std::vector<std::future<void>> futs;
+    for (size_t i = 0; i < num_threads; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&] {
+            for (size_t n = 1; n <= test_num; ++n) {
+                queue.push_back(n);
+            }
+        }));
+    }
+
+    for (auto& fut : futs) {
+        fut.get();
+    }
+
+    size_t acc = 0;
+    for (auto& sum : sums) {
+        acc += sum.get();
+    }
+    REQUIRE(acc == num_threads * test_num * (test_num + 1) / 2);
+    REQUIRE(queue.size() == 0);
+}
+
+TEST_CASE("SegmentChannel", "[lockfree/segment_queue]") {
+    SegmentChannel<int> channel;
+    auto fut = std::async(std::launch::async, [&] {
+        int sum = 0;
+        for (int value : channel) {
+            sum += value;
+        }
+        return sum;
+    });
+
+    for (int i = 1; i <= 1000; ++i) {
+        channel << i;
+    }
+    channel.Close();
+    REQUIRE(fut.get() == 1000 * 1001 / 2);
+}
\ No newline at end of file
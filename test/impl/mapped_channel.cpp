@@ -0,0 +1,97 @@
+#include <catch2/catch.hpp>
+#include <mapped_channel.hpp>
+
+#include <cstdio>
+#include <future>
+#include <string>
+
+#ifndef _WIN32
+
+struct MappedRecord {
+    size_t id;
+    double value;
+};
+
+static void remove_mapped(std::string const& path, size_t num_segments) {
+    std::remove((path + ".meta").c_str());
+    for (size_t i = 0; i < num_segments; ++i) {
+        std::remove((path + "." + std::to_string(i)).c_str());
+    }
+}
+
+TEST_CASE("MappedChannel::Add, Get", "[mapped_channel]") {
+    std::string path = "mapped_channel_test";
+    remove_mapped(path, 16);
+
+    MappedChannel<MappedRecord> channel(path, 4);
+    for (size_t i = 0; i < 10; ++i) {
+        channel.Add(MappedRecord{ i, i * 0.5 });
+    }
+
+    for (size_t i = 0; i < 10; ++i) {
+        auto res = channel.TryGet();
+        REQUIRE(res.has_value());
+        REQUIRE(res.value().id == i);
+        REQUIRE(res.value().value == i * 0.5);
+    }
+    REQUIRE(!channel.TryGet().has_value());
+
+    remove_mapped(path, 16);
+}
+
+TEST_CASE("MappedChannel::reopen", "[mapped_channel]") {
+    std::string path = "mapped_channel_reopen";
+    remove_mapped(path, 16);
+
+    {
+        MappedChannel<size_t> channel(path, 4);
+        for (size_t i = 0; i < 10; ++i) {
+            channel << i;
+        }
+
+        size_t res = 0;
+        channel >> res;
+        REQUIRE(res == 0);
+    }
+
+    {
+        MappedChannel<size_t> channel(path, 4);
+        for (size_t i = 1; i < 10; ++i) {
+            auto res = channel.TryGet();
+            REQUIRE(res.has_value());
+            REQUIRE(res.value() == i);
+        }
+        REQUIRE(!channel.TryGet().has_value());
+    }
+
+    std::FILE* consumed = std::fopen((path + ".0").c_str(), "r");
+    REQUIRE(consumed == nullptr);
+
+    remove_mapped(path, 16);
+}
+
+TEST_CASE("MappedChannel::max_segments", "[mapped_channel]") {
+    std::string path = "mapped_channel_bounded";
+    remove_mapped(path, 64);
+
+    constexpr size_t test_num = 1000;
+    MappedChannel<size_t> channel(path, 8, 2, 16);
+
+    auto fut = std::async(std::launch::async, [&] {
+        for (size_t i = 1; i <= test_num; ++i) {
+            channel.Add(i);
+        }
+        channel.Close();
+    });
+
+    size_t acc = 0;
+    for (size_t value : channel) {
+        acc += value;
+    }
+    fut.wait();
+
+    REQUIRE(acc == test_num * (test_num + 1) / 2);
+    remove_mapped(path, test_num / 8 + 2);
+}
+
+#endif
\ No newline at end of file
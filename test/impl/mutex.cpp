@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+#include <channel.hpp>
+#include <mutex.hpp>
+
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace {
+    template <typename Mutex>
+    void count_concurrently() {
+        Mutex mutex;
+        size_t count = 0;
+
+        constexpr size_t num_threads = 4;
+        constexpr size_t test_num = 10000;
+
+        std::vector<std::future<void>> futs;
+        for (size_t i = 0; i < num_threads; ++i) {
+            futs.emplace_back(std::async(std::launch::async, [&] {
+                for (size_t j = 0; j < test_num; ++j) {
+                    std::unique_lock lock(mutex);
+                    ++count;
+                }
+            }));
+        }
+        for (auto& fut : futs) {
+            fut.get();
+        }
+        REQUIRE(count == num_threads * test_num);
+
+        REQUIRE(mutex.try_lock());
+        REQUIRE(!mutex.try_lock());
+        mutex.unlock();
+    }
+
+    template <typename Mutex>
+    void channel_concurrently() {
+        Channel<ThreadSafe<RingBuffer<size_t>, Mutex>> channel(4);
+        constexpr size_t test_num = 10000;
+
+        auto fut = std::async(std::launch::async, [&] {
+            for (size_t i = 1; i <= test_num; ++i) {
+                channel.Add(i);
+            }
+            channel.Close();
+        });
+
+        size_t acc = 0;
+        for (size_t value : channel) {
+            acc += value;
+        }
+        fut.get();
+        REQUIRE(acc == test_num * (test_num + 1) / 2);
+    }
+}  // namespace
+
+TEST_CASE("SpinLock", "[mutex]") {
+    count_concurrently<SpinLock>();
+    channel_concurrently<SpinLock>();
+}
+
+TEST_CASE("TicketLock", "[mutex]") {
+    count_concurrently<TicketLock>();
+    channel_concurrently<TicketLock>();
+}
+
+TEST_CASE("AdaptiveMutex", "[mutex]") {
+    count_concurrently<AdaptiveMutex>();
+    channel_concurrently<AdaptiveMutex>();
+}
+
+TEST_CASE("ShardedSharedMutex", "[mutex]") {
+    count_concurrently<ShardedSharedMutex>();
+    channel_concurrently<ShardedSharedMutex>();
+
+    ShardedSharedMutex mutex;
+    REQUIRE(mutex.try_lock_shared());
+    REQUIRE(mutex.try_lock_shared());
+    REQUIRE(!mutex.try_lock());
+    mutex.unlock_shared();
+    mutex.unlock_shared();
+
+    REQUIRE(mutex.try_lock());
+    REQUIRE(!mutex.try_lock_shared());
+    mutex.unlock();
+}
\ No newline at end of file
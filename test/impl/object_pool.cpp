@@ -0,0 +1,96 @@
+#include <catch2/catch.hpp>
+#include <channel.hpp>
+#include <object_pool.hpp>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
+TEST_CASE("ObjectPool", "[object_pool]") {
+    std::atomic<int> made = 0;
+    ObjectPool<std::vector<char>> pool(
+        [&] {
+            ++made;
+            return std::make_unique<std::vector<char>>();
+        },
+        [](std::vector<char>& buffer) { buffer.clear(); },
+        4);
+
+    std::vector<char>* given = nullptr;
+    {
+        Pooled<std::vector<char>> buffer = pool.Get();
+        buffer->resize(1024);
+        given = buffer.get();
+    }
+
+    // returned one is reused and reset, capacity is kept
+    Pooled<std::vector<char>> buffer = pool.Get();
+    REQUIRE(buffer.get() == given);
+    REQUIRE(buffer->empty());
+    REQUIRE(buffer->capacity() >= 1024);
+    REQUIRE(made == 1);
+}
+
+TEST_CASE("ObjectPool::Trim", "[object_pool]") {
+    std::atomic<int> made = 0;
+    ObjectPool<int> pool(
+        [&] {
+            ++made;
+            return std::make_unique<int>(0);
+        },
+        nullptr,
+        2);
+
+    // over capacity, half of lane moves to shared stock
+    {
+        std::vector<Pooled<int>> handles;
+        for (int i = 0; i < 4; ++i) {
+            handles.push_back(pool.Get());
+        }
+    }
+    REQUIRE(made == 4);
+
+    // stock survives one Trim and is freed on the next
+    pool.Trim();
+    pool.Trim();
+
+    std::vector<Pooled<int>> handles;
+    for (int i = 0; i < 4; ++i) {
+        handles.push_back(pool.Get());
+    }
+    REQUIRE(made > 4);
+}
+
+TEST_CASE("ObjectPool with Channel", "[object_pool]") {
+    constexpr int num_items = 10000;
+
+    std::atomic<int> made = 0;
+    ObjectPool<std::vector<char>> pool(
+        [&] {
+            ++made;
+            return std::make_unique<std::vector<char>>();
+        },
+        [](std::vector<char>& buffer) { buffer.clear(); });
+
+    // consumer drops buffers, producer gets them back in batches
+    LChannel<Pooled<std::vector<char>>> channel;
+    auto fut = std::async(std::launch::async, [&] {
+        for (int i = 0; i < num_items; ++i) {
+            Pooled<std::vector<char>> buffer = pool.Get();
+            buffer->assign(64, static_cast<char>(i));
+            channel.Add(std::move(buffer));
+        }
+        channel.Close();
+    });
+
+    int count = 0;
+    for (auto& buffer : channel) {
+        REQUIRE(buffer->size() == 64);
+        ++count;
+    }
+    fut.get();
+
+    REQUIRE(count == num_items);
+    REQUIRE(made < num_items);
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <catch2/catch.hpp>
+#include <parallel_algorithm.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<int> random_vector(size_t size, int max_value) {
+        std::mt19937 rng(static_cast<unsigned>(size));
+        std::uniform_int_distribution<int> dist(0, max_value);
+
+        std::vector<int> vec(size);
+        for (int& value : vec) {
+            value = dist(rng);
+        }
+        return vec;
+    }
+}  // namespace
+
+TEST_CASE("parallel_for", "[parallel_algorithm]") {
+    ThreadPool<void> pool(3);
+
+    std::vector<int> touched(100000, 0);
+    parallel_for(pool, touched.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            touched[i] += 1;
+        }
+    });
+    REQUIRE(std::all_of(
+        touched.begin(), touched.end(), [](int n) { return n == 1; }));
+
+    REQUIRE_THROWS_AS(parallel_for(pool,
+                                   100,
+                                   [](size_t begin, size_t) {
+                                       if (begin > 0) {
+                                           throw std::runtime_error("chunk");
+                                       }
+                                   }),
+                      std::runtime_error);
+}
+
+TEST_CASE("parallel_sort", "[parallel_algorithm]") {
+    ThreadPool<void> pool(3);
+
+    for (size_t size : { 0, 1, 1000, 100000, 300007 }) {
+        for (int max_value : { 3, 1 << 30 }) {
+            std::vector<int> vec = random_vector(size, max_value);
+            std::vector<int> expected = vec;
+            std::sort(expected.begin(), expected.end());
+
+            parallel_sort(pool, vec.begin(), vec.end());
+            REQUIRE(vec == expected);
+        }
+    }
+
+    std::vector<std::string> words;
+    for (int value : random_vector(100000, 1 << 20)) {
+        words.push_back(std::to_string(value));
+    }
+    std::vector<std::string> expected = words;
+    std::sort(expected.begin(), expected.end(), std::greater<>());
+
+    parallel_sort(words.begin(), words.end(), std::greater<>());
+    REQUIRE(words == expected);
+}
+
+TEST_CASE("parallel_reduce", "[parallel_algorithm]") {
+    ThreadPool<void> pool(3);
+
+    for (size_t size : { 0, 5, 1000, 300007 }) {
+        std::vector<int> vec = random_vector(size, 100);
+        long long expected = std::accumulate(vec.begin(), vec.end(), 7LL);
+
+        REQUIRE(parallel_reduce(pool, vec.begin(), vec.end(), 7LL)
+                == expected);
+    }
+
+    std::vector<int> vec = random_vector(100000, 1 << 20);
+    REQUIRE(parallel_reduce(vec.begin(),
+                            vec.end(),
+                            0,
+                            [](int a, int b) { return std::max(a, b); })
+            == *std::max_element(vec.begin(), vec.end()));
+}
+
+TEST_CASE("parallel_inclusive_scan", "[parallel_algorithm]") {
+    ThreadPool<void> pool(3);
+
+    for (size_t size : { 0, 5, 1000, 300007 }) {
+        std::vector<int> vec = random_vector(size, 100);
+        std::vector<long long> expected(size), result(size);
+        std::inclusive_scan(vec.begin(), vec.end(), expected.begin());
+
+        auto end = parallel_inclusive_scan(
+            pool, vec.begin(), vec.end(), result.begin());
+        REQUIRE(end == result.end());
+        REQUIRE(result == expected);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include <catch2/catch.hpp>
+#include <parallel_walk.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// depth 0 to 2, each directory has 3 files of 10 bytes and 3 subdirectories
+static fs::path make_tree(std::string const& name) {
+    fs::path root = fs::temp_directory_path() / name;
+    fs::remove_all(root);
+
+    std::vector<fs::path> dirs{ root };
+    for (size_t depth = 0; depth < 3; ++depth) {
+        std::vector<fs::path> next;
+        for (auto const& dir : dirs) {
+            fs::create_directories(dir);
+            for (int i = 0; i < 3; ++i) {
+                std::ofstream file(dir / ("file" + std::to_string(i)));
+                file << "0123456789";
+                if (depth < 2) {
+                    next.push_back(dir / ("dir" + std::to_string(i)));
+                }
+            }
+        }
+        dirs = std::move(next);
+    }
+    return root;
+}
+
+static auto file_size = [](size_t& acc, fs::directory_entry const& entry) {
+    if (entry.is_regular_file()) {
+        acc += entry.file_size();
+    }
+};
+
+static auto sum = [](size_t lhs, size_t rhs) { return lhs + rhs; };
+
+TEST_CASE("parallel_walk", "[parallel_walk]") {
+    fs::path root = make_tree("cc_parallel_walk");
+
+    REQUIRE(parallel_walk(root, size_t(0), file_size, sum) == 13 * 3 * 10);
+
+    std::atomic<size_t> num_entries = 0;
+    parallel_walk(root, [&](fs::directory_entry const&) { ++num_entries; });
+    REQUIRE(num_entries == 13 * 3 + 12);
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("parallel_walk with options", "[parallel_walk]") {
+    fs::path root = make_tree("cc_parallel_walk_options");
+
+    WalkOptions options;
+    options.max_depth = 1;
+    options.max_concurrency = 3;
+    options.batch_size = 1;
+    REQUIRE(parallel_walk(root, size_t(0), file_size, sum, options)
+            == 4 * 3 * 10);
+
+    options.max_depth = 0;
+    REQUIRE(parallel_walk(root, size_t(0), file_size, sum, options) == 30);
+
+    options.max_depth = 2;
+    options.max_fanout = 1;
+    REQUIRE(parallel_walk(root, size_t(0), file_size, sum, options)
+            == 3 * 3 * 10);
+
+    ThreadPool<void> pool(2);
+    REQUIRE(parallel_walk(pool, root, size_t(0), file_size, sum)
+            == 13 * 3 * 10);
+
+    fs::remove_all(root);
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include <catch2/catch.hpp>
+#include <pipeline.hpp>
+
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("Pipeline::map, filter, sink", "[pipeline]") {
+    using namespace Pipeline;
+
+    int i = 0;
+    auto gen = [&]() -> std::optional<int> {
+        if (i < 100) {
+            return i++;
+        }
+        return std::nullopt;
+    };
+
+    std::mutex mutex;
+    std::vector<int> res;
+
+    auto done = source(gen, 4)
+                | map([](int x) { return x * 2; }, 4)
+                | filter([](int x) { return x % 4 == 0; })
+                | sink([&](int x) {
+                      std::unique_lock lock(mutex);
+                      res.push_back(x);
+                  });
+    done.Wait();
+
+    int acc = 0;
+    for (int x : res) {
+        acc += x;
+    }
+    REQUIRE(res.size() == 50);
+    REQUIRE(acc == 2 * 2 * (49 * 50 / 2));
+}
+
+TEST_CASE("Pipeline::ordered_map, batch", "[pipeline]") {
+    using namespace Pipeline;
+
+    std::vector<int> input;
+    for (int i = 0; i < 100; ++i) {
+        input.push_back(i);
+    }
+
+    std::vector<std::vector<int>> res;
+    auto done = from(input, 4)
+                | ordered_map([](int x) { return x + 1; }, 4)
+                | batch(30)
+                | sink([&](std::vector<int> chunk) {
+                      res.push_back(std::move(chunk));
+                  });
+    done.Wait();
+
+    REQUIRE(res.size() == 4);
+    REQUIRE(res.back().size() == 10);
+
+    int expected = 1;
+    for (auto const& chunk : res) {
+        for (int x : chunk) {
+            REQUIRE(x == expected++);
+        }
+    }
+}
+
+TEST_CASE("Pipeline::Flow::Output", "[pipeline]") {
+    using namespace Pipeline;
+
+    auto flow = from(std::vector<int>{ 1, 2, 3 })
+                | map([](int x) { return x * 10; });
+
+    int acc = 0;
+    for (int x : flow.Output()) {
+        acc += x;
+    }
+    REQUIRE(acc == 60);
+}
+
+TEST_CASE("Pipeline failure", "[pipeline]") {
+    using namespace Pipeline;
+
+    std::vector<int> input(1000, 1);
+    auto done = from(input, 2)
+                | map(
+                    [](int x) {
+                        throw std::runtime_error("failed");
+                        return x;
+                    },
+                    2)
+                | sink([](int) {});
+
+    REQUIRE_THROWS_AS(done.Wait(), std::runtime_error);
+}
\ No newline at end of file
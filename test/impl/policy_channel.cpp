@@ -0,0 +1,135 @@
+#include <catch2/catch.hpp>
+#include <policy_channel.hpp>
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+    template <typename C>
+    bool run_channel(C& channel, size_t producers, size_t consumers) {
+        constexpr size_t test_num = 10000;
+
+        std::vector<std::future<size_t>> sums;
+        for (size_t i = 0; i < consumers; ++i) {
+            sums.emplace_back(std::async(std::launch::async, [&] {
+                size_t acc = 0;
+                for (size_t value : channel) {
+                    acc += value;
+                }
+                return acc;
+            }));
+        }
+
+        std::vector<std::future<void>> futs;
+        for (size_t i = 0; i < producers; ++i) {
+            futs.emplace_back(std::async(std::launch::async, [&] {
+                for (size_t j = 1; j <= test_num; ++j) {
+                    channel.Add(j);
+                }
+            }));
+        }
+        for (auto& fut : futs) {
+            fut.get();
+        }
+        channel.Close();
+
+        size_t acc = 0;
+        for (auto& sum : sums) {
+            acc += sum.get();
+        }
+        return acc == producers * test_num * (test_num + 1) / 2;
+    }
+}  // namespace
+
+TEST_CASE("PolicyChannel::select_container", "[policy_channel]") {
+    using unbounded = Policy::container_t<int,
+                                          Policy::unbounded,
+                                          Policy::Multi,
+                                          Policy::Multi,
+                                          Policy::Park,
+                                          std::allocator<int>>;
+    REQUIRE(std::is_same_v<unbounded,
+                           LockFree::SegmentQueue<int, Policy::Park>>);
+
+    using mpsc = Policy::container_t<int,
+                                     Policy::unbounded,
+                                     Policy::Multi,
+                                     Policy::Single,
+                                     Policy::Spin,
+                                     std::allocator<int>>;
+    REQUIRE(std::is_same_v<mpsc, LockFree::MpscQueue<int, Policy::Spin>>);
+
+    using spsc = Policy::container_t<int,
+                                     16,
+                                     Policy::Single,
+                                     Policy::Single,
+                                     Policy::Spin,
+                                     std::allocator<int>>;
+    REQUIRE(std::is_base_of_v<
+            BoundedQueue<int, Policy::Single, Policy::Single, Policy::Spin>,
+            spsc>);
+}
+
+TEST_CASE("PolicyChannel::Add, Get", "[policy_channel]") {
+    PolicyChannel<std::string, 2> channel;
+    channel.Add("a");
+    channel << "b";
+    REQUIRE(!channel.TryAdd("c"));
+
+    REQUIRE(channel.Get().value() == "a");
+    REQUIRE(channel.TryGet().value() == "b");
+    REQUIRE(!channel.TryGet().has_value());
+
+    using namespace std::chrono_literals;
+    REQUIRE(!channel.GetFor(10ms).has_value());
+    REQUIRE(channel.AddFor(10ms, "c"));
+    REQUIRE(channel.AddFor(10ms, "d"));
+    REQUIRE(!channel.AddFor(10ms, "e"));
+
+    channel.Close();
+    REQUIRE(channel.Readable());
+    REQUIRE(channel.Get().value() == "c");
+    REQUIRE(channel.Get().value() == "d");
+    REQUIRE(!channel.Readable());
+    REQUIRE(!channel.Get().has_value());
+}
+
+TEST_CASE("PolicyChannel topologies", "[policy_channel]") {
+    SECTION("spsc spin") {
+        PolicyChannel<size_t, 64, Policy::Single, Policy::Single, Policy::Spin>
+            channel;
+        REQUIRE(run_channel(channel, 1, 1));
+    }
+    SECTION("spsc park") {
+        PolicyChannel<size_t, 64, Policy::Single, Policy::Single> channel;
+        REQUIRE(run_channel(channel, 1, 1));
+    }
+    SECTION("mpsc park") {
+        PolicyChannel<size_t, 64, Policy::Multi, Policy::Single> channel;
+        REQUIRE(run_channel(channel, 4, 1));
+    }
+    SECTION("spmc park") {
+        PolicyChannel<size_t, 64, Policy::Single, Policy::Multi> channel;
+        REQUIRE(run_channel(channel, 1, 4));
+    }
+    SECTION("mpmc spin") {
+        PolicyChannel<size_t, 64, Policy::Multi, Policy::Multi, Policy::Spin>
+            channel;
+        REQUIRE(run_channel(channel, 4, 4));
+    }
+    SECTION("mpsc unbounded") {
+        PolicyChannel<size_t,
+                      Policy::unbounded,
+                      Policy::Multi,
+                      Policy::Single>
+            channel;
+        REQUIRE(run_channel(channel, 4, 1));
+    }
+    SECTION("mpmc unbounded") {
+        PolicyChannel<size_t> channel;
+        REQUIRE(run_channel(channel, 4, 4));
+    }
+}
\ No newline at end of file
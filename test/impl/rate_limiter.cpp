@@ -0,0 +1,67 @@
+#include <catch2/catch.hpp>
+#include <rate_limiter.hpp>
+
+#include <chrono>
+#include <future>
+#include <vector>
+
+namespace chrono = std::chrono;
+
+TEST_CASE("RateLimiter::TryAcquire", "[rate_limiter]") {
+    RateLimiter limiter(1, 3);
+    REQUIRE(limiter.GetBurst() == 3);
+
+    // burst is available at once, then one per second
+    REQUIRE(limiter.TryAcquire(2));
+    REQUIRE(limiter.TryAcquire());
+    REQUIRE(!limiter.TryAcquire());
+
+    limiter.Release();
+    REQUIRE(limiter.TryAcquire());
+    REQUIRE(!limiter.TryAcquire());
+    REQUIRE(!limiter.AcquireFor(chrono::milliseconds(1)));
+}
+
+TEST_CASE("RateLimiter::Acquire", "[rate_limiter]") {
+    RateLimiter limiter(1000, 1);
+
+    auto start = chrono::steady_clock::now();
+    std::vector<std::future<void>> futs;
+    for (size_t i = 0; i < 4; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&] {
+            for (size_t n = 0; n < 25; ++n) {
+                limiter.Acquire();
+            }
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+    auto elapsed = chrono::steady_clock::now() - start;
+
+    // 100 tokens at 1000/s, the first one is free
+    REQUIRE(elapsed >= chrono::milliseconds(99));
+    REQUIRE(limiter.AcquireFor(chrono::milliseconds(100)));
+}
+
+TEST_CASE("ThrottledChannel", "[rate_limiter]") {
+    ThrottledLChannel<int> channel(1000, 1);
+    REQUIRE(!channel.TryGet().has_value());
+
+    // token of failed TryGet is given back
+    channel << 1;
+    REQUIRE(channel.TryGet().value() == 1);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < 20; ++i) {
+        channel.Add(i);
+    }
+    channel.Close();
+
+    int sum = 0;
+    for (int value : channel) {
+        sum += value;
+    }
+    REQUIRE(sum == 19 * 20 / 2);
+    REQUIRE(chrono::steady_clock::now() - start >= chrono::milliseconds(19));
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include <catch2/catch.hpp>
+#include <select.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+
+TEST_CASE("Selector::Wait", "[select]") {
+    Selector selector;
+    REQUIRE(!selector.TryWait().has_value());
+
+    RChannel<int> first(4), second(4);
+    second.Add(1);
+
+    size_t id_first = selector.Register(first);
+    size_t id_second = selector.Register(second);
+    REQUIRE(selector.Size() == 2);
+
+    // first is registered empty, so only its registration is ready
+    REQUIRE(selector.Wait() == id_first);
+    REQUIRE(!first.TryGet().has_value());
+    REQUIRE(selector.Wait() == id_second);
+    REQUIRE(second.TryGet().value() == 1);
+    REQUIRE(!selector.WaitFor(std::chrono::milliseconds(1)).has_value());
+
+    // readiness is queued once until taken
+    first.Add(2);
+    first.Add(3);
+    REQUIRE(selector.Wait() == id_first);
+    REQUIRE(!selector.TryWait().has_value());
+    REQUIRE(first.TryGet().value() == 2);
+    REQUIRE(first.TryGet().value() == 3);
+
+    selector.Unregister(id_first);
+    REQUIRE(selector.Size() == 1);
+    first.Add(4);
+    REQUIRE(!selector.TryWait().has_value());
+
+    second.Close();
+    REQUIRE(selector.Wait() == id_second);
+    REQUIRE(!second.Readable());
+}
+
+TEST_CASE("Selector concurrently", "[select]") {
+    constexpr size_t num_channels = 1000;
+    constexpr size_t test_num = 10;
+
+    std::vector<std::unique_ptr<LChannel<size_t>>> channels;
+    for (size_t i = 0; i < num_channels; ++i) {
+        channels.emplace_back(std::make_unique<LChannel<size_t>>());
+    }
+
+    Selector selector;
+    std::vector<size_t> ids;
+    for (auto& channel : channels) {
+        ids.emplace_back(selector.Register(*channel));
+    }
+
+    auto fut = std::async(std::launch::async, [&] {
+        for (size_t n = 1; n <= test_num; ++n) {
+            for (auto& channel : channels) {
+                channel->Add(n);
+            }
+        }
+    });
+
+    // ids are issued in order for fresh selector
+    size_t acc = 0;
+    size_t num = 0;
+    while (num < num_channels * test_num) {
+        size_t id = selector.Wait();
+        while (auto given = channels[id]->TryGet()) {
+            acc += given.value();
+            ++num;
+        }
+    }
+    fut.get();
+
+    REQUIRE(acc == num_channels * test_num * (test_num + 1) / 2);
+    for (size_t id : ids) {
+        selector.Unregister(id);
+    }
+    REQUIRE(selector.Size() == 0);
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <catch2/catch.hpp>
+#include <semaphore.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <vector>
+
+TEST_CASE("Semaphore::TryAcquire", "[semaphore]") {
+    Semaphore semaphore(3);
+    REQUIRE(semaphore.TryAcquire(2));
+    REQUIRE(!semaphore.TryAcquire(2));
+    REQUIRE(semaphore.TryAcquire());
+    REQUIRE(semaphore.Available() == 0);
+    REQUIRE(!semaphore.AcquireFor(std::chrono::milliseconds(1)));
+
+    semaphore.Release(3);
+    REQUIRE(semaphore.Available() == 3);
+}
+
+TEST_CASE("Semaphore::Acquire", "[semaphore]") {
+    constexpr size_t permits = 3;
+    Semaphore semaphore(permits);
+
+    // weighted holders should never exceed permits
+    std::atomic<size_t> holding = 0;
+    std::atomic<bool> exceeded = false;
+
+    std::vector<std::future<void>> futs;
+    for (size_t i = 0; i < 8; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&, i] {
+            size_t n = i % 2 + 1;
+            for (size_t iter = 0; iter < 200; ++iter) {
+                SemaphoreGuard guard(semaphore, n);
+                if ((holding += n) > permits) {
+                    exceeded = true;
+                }
+                holding -= n;
+            }
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+
+    REQUIRE(!exceeded);
+    REQUIRE(semaphore.Available() == permits);
+}
\ No newline at end of file
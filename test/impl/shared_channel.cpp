@@ -0,0 +1,65 @@
+#include <catch2/catch.hpp>
+#include <shared_channel.hpp>
+
+#include <chrono>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+
+TEST_CASE("SharedChannel::Add, Get", "[shared_channel]") {
+    SharedChannel<int> channel("/cc_shared_channel", 3);
+    channel.Add(1);
+    channel << 2;
+
+    REQUIRE(channel.Get().value() == 1);
+    REQUIRE(channel.TryGet().value() == 2);
+    REQUIRE(!channel.TryGet().has_value());
+
+    channel.Close();
+    REQUIRE(!channel.Readable());
+    REQUIRE(!channel.Get().has_value());
+}
+
+TEST_CASE("SharedChannel::TryAdd, GetFor", "[shared_channel]") {
+    using namespace std::chrono_literals;
+    SharedChannel<int> channel("/cc_shared_timed", 1);
+
+    REQUIRE(!channel.GetFor(10ms).has_value());
+    REQUIRE(channel.TryAdd(1));
+    REQUIRE(!channel.TryAdd(2));
+    REQUIRE(!channel.AddFor(10ms, 2));
+    REQUIRE(channel.GetFor(10s).value() == 1);
+
+    channel.Close();
+    REQUIRE(!channel.GetFor(10s).has_value());
+}
+
+TEST_CASE("SharedChannel between processes", "[shared_channel]") {
+    constexpr size_t test_num = 1000;
+    SharedChannel<size_t> channel("/cc_shared_process", 8);
+
+    pid_t pid = fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        SharedChannel<size_t> child("/cc_shared_process", 8);
+        for (size_t i = 1; i <= test_num; ++i) {
+            child.Add(i);
+        }
+        child.Close();
+        _exit(0);
+    }
+
+    size_t acc = 0;
+    for (size_t value : channel) {
+        acc += value;
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(acc == test_num * (test_num + 1) / 2);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include <catch2/catch.hpp>
+#include <rcu.hpp>
+#include <synchronized.hpp>
+
+#include <atomic>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+TEST_CASE("Synchronized", "[synchronized]") {
+    Synchronized<std::map<std::string, int>> table;
+    table.with_write([](auto& map) { map["one"] = 1; });
+    table.assign(std::map<std::string, int>{ { "two", 2 } });
+
+    REQUIRE(table.with_read([](auto const& map) { return map.at("two"); })
+            == 2);
+    REQUIRE(table.copy().size() == 1);
+
+    // pair written together should be read together
+    Synchronized<std::pair<int, int>> pair(0, 0);
+    std::atomic<bool> torn = false;
+
+    std::vector<std::future<void>> futs;
+    for (int i = 0; i < 4; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&, i] {
+            for (int n = 0; n < 2000; ++n) {
+                if (i == 0) {
+                    pair.with_write([&](auto& given) {
+                        given.first = n;
+                        given.second = n;
+                    });
+                }
+                else if (pair.with_read([](auto const& given) {
+                             return given.first != given.second;
+                         })) {
+                    torn = true;
+                }
+            }
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+    REQUIRE(!torn);
+}
+
+TEST_CASE("RcuCell", "[synchronized]") {
+    RcuCell<std::vector<int>> cell(3, 0);
+    REQUIRE(cell.load().size() == 3);
+
+    // every snapshot is a consistent version
+    std::atomic<bool> torn = false;
+    std::vector<std::future<void>> futs;
+    for (int i = 0; i < 4; ++i) {
+        futs.emplace_back(std::async(std::launch::async, [&, i] {
+            for (int n = 0; n < 1000; ++n) {
+                if (i < 2) {
+                    cell.update([](auto& vec) {
+                        for (int& value : vec) {
+                            ++value;
+                        }
+                    });
+                    continue;
+                }
+                cell.read([&](auto const& vec) {
+                    if (vec[0] != vec[1] || vec[1] != vec[2]) {
+                        torn = true;
+                    }
+                });
+            }
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.get();
+    }
+
+    REQUIRE(!torn);
+    REQUIRE(cell.load() == std::vector<int>(3, 2000));
+
+    cell.store(std::vector<int>{ 1 });
+    REQUIRE(cell.read([](auto const& vec) { return vec[0]; }) == 1);
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include <catch2/catch.hpp>
+#include <thread_pool.hpp>
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("InboxThreadPool::Add", "[thread_pool]") {
+    InboxThreadPool<size_t> pool(4);
+    REQUIRE(pool.GetNumThreads() == 4);
+
+    constexpr size_t test_num = 1000;
+    std::vector<std::future<size_t>> futs;
+    for (size_t i = 1; i <= test_num; ++i) {
+        futs.emplace_back(pool.Add([i] { return i; }));
+    }
+
+    size_t acc = 0;
+    for (auto& fut : futs) {
+        acc += fut.get();
+    }
+    REQUIRE(acc == test_num * (test_num + 1) / 2);
+}
+
+TEST_CASE("InboxThreadPool::AddTo", "[thread_pool]") {
+    InboxThreadPool<std::thread::id> pool(3);
+
+    std::vector<size_t> order;
+    std::vector<std::future<std::thread::id>> futs;
+    for (size_t i = 0; i < 100; ++i) {
+        futs.emplace_back(pool.AddTo(1, [&, i] {
+            order.push_back(i);
+            return std::this_thread::get_id();
+        }));
+    }
+
+    std::thread::id worker = futs[0].get();
+    for (size_t i = 1; i < futs.size(); ++i) {
+        REQUIRE(futs[i].get() == worker);
+    }
+    for (size_t i = 0; i < order.size(); ++i) {
+        REQUIRE(order[i] == i);
+    }
+}
+
+TEST_CASE("InboxThreadPool::Stop", "[thread_pool]") {
+    std::future<int> fut;
+    {
+        InboxThreadPool<int> pool(1);
+        pool.AddTo(0, [] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            return 0;
+        });
+        fut = pool.Add([] { return 1; });
+    }
+    REQUIRE(fut.get() == 1);
+}
+
+TEST_CASE("ThreadPool::Blocking", "[thread_pool]") {
+    ThreadPool<int> pool(1);
+    REQUIRE(pool.Blocking([] { return 1; }) == 1);
+
+    // single worker blocks until next task runs, compensating worker runs it
+    std::promise<int> promise;
+    std::future<int> given = promise.get_future();
+    std::future<int> fut = pool.Add([&] {
+        return pool.Blocking([&] {
+            if (given.wait_for(std::chrono::seconds(5))
+                != std::future_status::ready) {
+                return -1;
+            }
+            return given.get();
+        });
+    });
+    pool.Add([&] {
+        promise.set_value(2);
+        return 0;
+    });
+    REQUIRE(fut.get() == 2);
+}
+
+TEST_CASE("ThreadPool::Await", "[thread_pool]") {
+    ThreadPool<int> pool(1);
+
+    // nested subtask on single worker pool
+    std::future<int> fut = pool.Add([&] {
+        int acc = 0;
+        for (int i = 1; i <= 10; ++i) {
+            acc += pool.Await(pool.Add([i] { return i; }));
+        }
+        return acc;
+    });
+    REQUIRE(fut.get() == 55);
+    REQUIRE(pool.Await(pool.Add([] { return 3; })) == 3);
+}
+
+TEST_CASE("ThreadPool::AddBulk", "[thread_pool]") {
+    // bounded queue smaller than batch, so batch is pushed in parts
+    ThreadPool<size_t> pool(3, 16);
+
+    std::vector<std::function<size_t()>> tasks;
+    for (size_t i = 1; i <= 100; ++i) {
+        tasks.emplace_back([i] { return i; });
+    }
+
+    auto batch = pool.AddBulk(std::make_move_iterator(tasks.begin()),
+                              std::make_move_iterator(tasks.end()));
+    REQUIRE(batch.Size() == 100);
+
+    batch.Wait();
+    REQUIRE(batch.Ready());
+
+    size_t acc = 0;
+    for (auto& fut : batch.Futures()) {
+        acc += fut.get();
+    }
+    REQUIRE(acc == 100 * 101 / 2);
+
+    auto empty = pool.AddBulk(tasks.begin(), tasks.begin());
+    REQUIRE(empty.Ready());
+    empty.Wait();
+}
+
+TEST_CASE("ThreadPool::AddN", "[thread_pool]") {
+    LThreadPool<int> pool(4);
+
+    std::atomic<int> count = 0;
+    auto batch = pool.AddN(1000, [&](size_t i) {
+        count.fetch_add(1);
+        if (i == 7) {
+            throw std::runtime_error("task");
+        }
+        return static_cast<int>(i);
+    });
+
+    // failed task still completes batch
+    batch.Wait();
+    REQUIRE(count == 1000);
+    REQUIRE_THROWS_AS(batch.Futures()[7].get(), std::runtime_error);
+    REQUIRE(batch.Futures()[999].get() == 999);
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include <catch2/catch.hpp>
+#include <timer.hpp>
+
+#include <vector>
+
+using namespace std::literals;
+
+TEST_CASE("TimerService::After", "[timer]") {
+    TimerService service;
+
+    auto start = Timer::clock::now();
+    auto timer = service.After(20ms);
+
+    auto res = timer->Get();
+    REQUIRE(res.has_value());
+    REQUIRE(res.value() - start >= 20ms);
+    REQUIRE(Timer::clock::now() - start >= 20ms);
+
+    REQUIRE(!timer->Readable());
+    REQUIRE(!timer->Get().has_value());
+    REQUIRE(service.Size() == 0);
+}
+
+TEST_CASE("TimerService::Deadline", "[timer]") {
+    TimerService service;
+
+    auto deadline = Timer::clock::now() + 10ms;
+    auto timer = service.Deadline(deadline);
+
+    REQUIRE(timer->Get().value() >= deadline);
+}
+
+TEST_CASE("TimerService::Tick", "[timer]") {
+    TimerService service;
+    auto tick = service.Tick(5ms);
+
+    auto prev = tick->Get().value();
+    for (int i = 0; i < 5; ++i) {
+        auto next = tick->Get().value();
+        REQUIRE(next > prev);
+        prev = next;
+    }
+
+    REQUIRE(tick->Runnable());
+    REQUIRE(tick->Stop());
+    REQUIRE(!tick->Runnable());
+    REQUIRE(service.Size() == 0);
+}
+
+TEST_CASE("Timer::Stop", "[timer]") {
+    TimerService service;
+    auto timer = service.After(1h);
+
+    REQUIRE(service.Size() == 1);
+    REQUIRE(timer->Stop());
+    REQUIRE(!timer->Stop());
+    REQUIRE(service.Size() == 0);
+    REQUIRE(!timer->Get().has_value());
+}
+
+TEST_CASE("TimerService with many timers", "[timer]") {
+    TimerService service;
+    constexpr size_t test_num = 10000;
+
+    std::vector<std::shared_ptr<Timer>> timers;
+    for (size_t i = 0; i < test_num; ++i) {
+        timers.push_back(service.After(std::chrono::milliseconds(i % 300)));
+    }
+
+    size_t fired = 0;
+    for (auto& timer : timers) {
+        if (timer->Get().has_value()) {
+            ++fired;
+        }
+    }
+    REQUIRE(fired == test_num);
+}
+
+TEST_CASE("TimerService::Stop", "[timer]") {
+    auto service = std::make_unique<TimerService>();
+    auto timer = service->After(1h);
+
+    service.reset();
+    REQUIRE(!timer->Readable());
+    REQUIRE(!timer->Stop());
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include <catch2/catch.hpp>
+#include <trace.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+    size_t count(std::string const& given, std::string const& pattern) {
+        size_t num = 0;
+        for (size_t pos = given.find(pattern); pos != std::string::npos;
+             pos = given.find(pattern, pos + pattern.size())) {
+            ++num;
+        }
+        return num;
+    }
+}  // namespace
+
+TEST_CASE("Trace::Recorder", "[trace]") {
+    Trace::Recorder& recorder = Trace::Recorder::global();
+    recorder.clear();
+
+    uint64_t id = recorder.next_id();
+    recorder.record("queued", 'b', id);
+    std::thread([&] {
+        recorder.record("queued", 'e', id);
+        recorder.record("task", 'B', id);
+        for (size_t i = 0; i < 3000; ++i) {
+            recorder.record("step", 'i');
+        }
+        recorder.record("task", 'E', id);
+    }).join();
+
+    std::stringstream out;
+    recorder.dump(out);
+    std::string given = out.str();
+
+    REQUIRE(given.rfind("{\"traceEvents\":[", 0) == 0);
+    REQUIRE(count(given, "\"ph\":\"b\"") == 1);
+    REQUIRE(count(given, "\"ph\":\"e\"") == 1);
+    REQUIRE(count(given, "\"ph\":\"B\"") == 1);
+    REQUIRE(count(given, "\"ph\":\"E\"") == 1);
+    REQUIRE(count(given, "\"name\":\"step\"") == 3000);
+    REQUIRE(count(given, "\"id\":" + std::to_string(id)) == 4);
+
+    recorder.clear();
+    std::stringstream empty;
+    recorder.dump(empty);
+    REQUIRE(count(empty.str(), "\"ph\":\"i\"") == 0);
+}
+
+TEST_CASE("Trace::task", "[trace]") {
+    Trace::Recorder::global().clear();
+
+    auto task = Trace::task([] { return 1; });
+    Trace::begin("span");
+    Trace::end("span");
+    REQUIRE(task() == 1);
+
+    // without CONCURRENCY_TRACE nothing is recorded
+    std::stringstream out;
+    Trace::Recorder::global().dump(out);
+    REQUIRE((count(out.str(), "\"name\":\"span\"") == 2) == Trace::enabled);
+    REQUIRE((count(out.str(), "\"name\":\"task\"") == 2) == Trace::enabled);
+}
\ No newline at end of file